@@ -0,0 +1,418 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - checkpoint.c
+
+Content:
+  -This file contains the checkpoints of the run, used to resume it after a time limit or a
+   preemption of the job. Each rank writes the conserved variables of its subdomain (U), the
+   equilibrium state (Ue and S_corr), the time and the counters of the time loop in a binary file
+   (out/checkpoint.bin, or out/checkpoint_r0002.bin for the rank 2). The file is written under a
+   temporary name and renamed once it is complete, so a job killed while writing never leaves a
+   broken checkpoint. The previous CHECKPOINT_KEEP-1 checkpoints are kept as out/checkpoint.1.bin,
+   out/checkpoint.2.bin, ...
+
+   With Restart 1, the run starts from the newest checkpoint that is valid (right size and
+   checksum) in all the ranks, and gives the same results, bit for bit, as the uninterrupted run.
+   The files are raw memory dumps, so they must be read on the same kind of machine, with the same
+   grid, number of ranks and equations.
+
+*/
+
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <omp.h>
+
+#include "definitions.h"
+#include "structures.h"
+#include "checkpoint.h"
+#include "mpicomm.h"
+#include "profiler.h"
+
+
+#define CHECKPOINT_MAGIC "EHOWCKPT"
+#define CHECKPOINT_VERSION 1
+
+//Header of a checkpoint file. It is followed by the fields U, Ue and S_corr, variable by variable
+typedef struct{
+	char magic[8];
+	int32_t version;
+	int32_t seq; //number of the checkpoint
+	int32_t nvar,eq_system,order,st;
+	int32_t nranks,rank;
+	int32_t gcells[3]; //cells of the whole grid
+	int32_t offset[3]; //first cell of the subdomain
+	int32_t cells[3]; //cells of the subdomain
+	int32_t nIt; //number of dumps written
+	double t,dt;
+	double timeac,timeac2; //time since the last dump and since the last line of tke.out
+	double mass0,energy0;
+	uint64_t checksum; //of the fields
+} t_checkpoint_header;
+
+
+//Set by the handler of SIGTERM and SIGUSR1: a checkpoint is written at the end of the current step
+//and the run stops
+static volatile sig_atomic_t stop_signal=0;
+
+static void signal_handler(int sig){
+
+	stop_signal=1;
+
+}
+
+
+//Checksum of an array of doubles (64-bit FNV-1a over words), continued from h
+static uint64_t checksum_update(uint64_t h, const double *v, long n){
+
+	long i;
+	uint64_t w;
+
+	for(i=0;i<n;i++){
+		memcpy(&w,&v[i],sizeof(uint64_t));
+		h=(h^w)*1099511628211ULL;
+	}
+	return h;
+
+}
+
+
+//Fields stored in the checkpoint, in the order they are written
+static void checkpoint_fields(t_mesh *mesh, double ***field){
+
+	field[0]=mesh->U;
+	field[1]=mesh->Ue;
+	field[2]=mesh->S_corr;
+
+}
+
+
+t_checkpoint *checkpoint_init(t_mesh *mesh, t_sim *sim, const char *folder_path){
+
+	t_checkpoint *ckpt;
+	struct sigaction sa;
+	char filename[1024];
+	int g;
+
+	ckpt=(t_checkpoint*)malloc(sizeof(t_checkpoint));
+	ckpt->enabled=(sim->checkpoint_time>0.0||sim->checkpoint_walltime>0.0);
+	ckpt->seq=0;
+	ckpt->t_last=0.0;
+	ckpt->wall_last=prof_time();
+	ckpt->stop=0;
+	for(g=0;g<CHECKPOINT_KEEP;g++){
+		if(g==0){
+			snprintf(filename,sizeof(filename),"%s/out/checkpoint.bin",folder_path);
+		}else{
+			snprintf(filename,sizeof(filename),"%s/out/checkpoint.%d.bin",folder_path,g);
+		}
+		rank_filename(mesh->comm,filename,ckpt->path[g],sizeof(ckpt->path[g]));
+	}
+
+	if(ckpt->enabled){
+		//A job scheduler sends SIGTERM (or SIGUSR1, if so requested) before killing the job
+		memset(&sa,0,sizeof(sa));
+		sa.sa_handler=signal_handler;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGTERM,&sa,NULL);
+		sigaction(SIGUSR1,&sa,NULL);
+		printf("%s Checkpoints are written every %.3e s of simulated time and every %.3e s of wall-clock time (0: never), and on SIGTERM or SIGUSR1\n",
+			OK,sim->checkpoint_time,sim->checkpoint_walltime);
+	}
+
+	return ckpt;
+}
+
+
+//Reads the header of a checkpoint file and checks that it belongs to this run and that the data is
+//complete and not corrupted. Returns 1 if it is valid
+static int check_file(const char *path, t_mesh *mesh, t_sim *sim, t_checkpoint_header *head){
+
+	FILE *fp;
+	double *buf;
+	uint64_t h;
+	int f,k,valid;
+
+	fp=fopen(path,"rb");
+	if(fp==NULL){
+		return 0;
+	}
+	valid=(fread(head,sizeof(t_checkpoint_header),1,fp)==1);
+	valid=valid&&memcmp(head->magic,CHECKPOINT_MAGIC,8)==0&&head->version==CHECKPOINT_VERSION;
+	valid=valid&&head->nvar==sim->nvar&&head->eq_system==sim->eq_system&&head->order==sim->order&&head->st==sim->st;
+	valid=valid&&head->nranks==mesh->comm->nranks&&head->rank==mesh->comm->rank;
+	valid=valid&&head->gcells[0]==mesh->gxcells&&head->gcells[1]==mesh->gycells&&head->gcells[2]==mesh->gzcells;
+	valid=valid&&head->cells[0]==mesh->xcells&&head->cells[1]==mesh->ycells&&head->cells[2]==mesh->zcells;
+	if(!valid){
+		fclose(fp);
+		return 0;
+	}
+
+	//The data is read variable by variable to compute the checksum
+	buf=(double*)malloc(mesh->ncells*sizeof(double));
+	h=14695981039346656037ULL;
+	for(f=0;f<3&&valid;f++){
+		for(k=0;k<sim->nvar&&valid;k++){
+			valid=(fread(buf,sizeof(double),mesh->ncells,fp)==(size_t)mesh->ncells);
+			h=checksum_update(h,buf,mesh->ncells);
+		}
+	}
+	valid=valid&&(h==head->checksum);
+	free(buf);
+	fclose(fp);
+
+	return valid;
+}
+
+
+//Resumes the run from the newest checkpoint that is valid in all the ranks. Returns 1 if the state,
+//the time and the counters have been read, and 0 if the run starts from the initial condition
+int read_checkpoint(t_checkpoint *ckpt, t_mesh *mesh, t_sim *sim, double *timeac, double *timeac2, int *nIt){
+
+	t_checkpoint_header head[CHECKPOINT_KEEP];
+	int valid[CHECKPOINT_KEEP];
+	double **field[3];
+	FILE *fp;
+	int g,gsel,f,k,seq,best;
+
+	if(sim->restart!=1){
+		return 0;
+	}
+
+	//Valid checkpoints of this rank
+	for(g=0;g<CHECKPOINT_KEEP;g++){
+		valid[g]=check_file(ckpt->path[g],mesh,sim,&head[g]);
+		if(!valid[g]&&access(ckpt->path[g],F_OK)==0){
+			printf("%s The checkpoint %s is not valid for this run and is ignored\n",WAR,ckpt->path[g]);
+		}
+	}
+
+	//The newest checkpoint present in all the ranks. A rank may have a newer one if the run was
+	//killed while the ranks were renaming their files
+	best=-1;
+	for(g=0;g<CHECKPOINT_KEEP;g++){
+		if(valid[g]) best=MAX(best,head[g].seq);
+	}
+	seq=(int)comm_max(mesh->comm,best);
+	gsel=-1;
+	while(seq>=0){
+		gsel=-1;
+		for(g=0;g<CHECKPOINT_KEEP;g++){
+			if(valid[g]&&head[g].seq==seq) gsel=g;
+		}
+		if((int)comm_sum(mesh->comm,(gsel>=0))==mesh->comm->nranks){
+			break;
+		}
+		best=-1;
+		for(g=0;g<CHECKPOINT_KEEP;g++){
+			if(valid[g]&&head[g].seq<seq) best=MAX(best,head[g].seq);
+		}
+		seq=(int)comm_max(mesh->comm,best);
+	}
+	if(seq<0){
+		printf("%s No valid checkpoint has been found. The run starts from the initial condition\n",WAR);
+		return 0;
+	}
+
+	fp=fopen(ckpt->path[gsel],"rb");
+	if(fp==NULL||fseek(fp,sizeof(t_checkpoint_header),SEEK_SET)!=0){
+		printf("%s The checkpoint %s could not be read. The program will close when pressing a key.\n",ERR,ckpt->path[gsel]);
+		getchar();
+		exit(1);
+	}
+	checkpoint_fields(mesh,field);
+	for(f=0;f<3;f++){
+		for(k=0;k<sim->nvar;k++){
+			if(fread(field[f][k],sizeof(double),mesh->ncells,fp)!=(size_t)mesh->ncells){
+				printf("%s The checkpoint %s could not be read. The program will close when pressing a key.\n",ERR,ckpt->path[gsel]);
+				getchar();
+				exit(1);
+			}
+		}
+	}
+	fclose(fp);
+
+	sim->t=head[gsel].t;
+	sim->dt=head[gsel].dt;
+	mesh->mass0=head[gsel].mass0;
+	mesh->energy0=head[gsel].energy0;
+	*timeac=head[gsel].timeac;
+	*timeac2=head[gsel].timeac2;
+	*nIt=head[gsel].nIt;
+	ckpt->seq=seq;
+	ckpt->t_last=sim->t;
+	ckpt->wall_last=prof_time();
+
+	printf("%s The run is resumed from the checkpoint %d (%s) at T= %14.14e\n",OK,seq,ckpt->path[gsel],sim->t);
+
+	return 1;
+}
+
+
+//Removes the lines of a time series (e.g. tke.out, one line per output time with the time in the
+//first column, written with %14.14e) after the time t of the checkpoint of a restart, so that the
+//lines written between that checkpoint and the end of the interrupted run do not appear twice
+void truncate_time_series(const char *fname, double t){
+
+	FILE *fp;
+	char line[1024],tstr[64];
+	long keep;
+	double tc;
+
+	fp=fopen(fname,"r");
+	if(fp==NULL){
+		return;
+	}
+	snprintf(tstr,sizeof(tstr),"%14.14e",t);	//t as written in the file
+	tc=atof(tstr);
+	keep=0;
+	while(fgets(line,sizeof(line),fp)!=NULL){
+		if(atof(line)>tc){
+			break;
+		}
+		keep=ftell(fp);
+	}
+	fclose(fp);
+
+	if(truncate(fname,keep)!=0){
+		printf("%s The file %s could not be truncated at T= %14.14e\n",WAR,fname,t);
+	}
+}
+
+
+//Returns 1 if a checkpoint must be written at the end of this time step: after CheckpointTime of
+//simulated time or CheckpointWallTime of wall-clock time since the last one, or when a SIGTERM or
+//SIGUSR1 has been received. The decision is the same in all the ranks
+int checkpoint_due(t_checkpoint *ckpt, t_mesh *mesh, t_sim *sim){
+
+	int due;
+
+	if(!ckpt->enabled){
+		return 0;
+	}
+	due=0;
+	if(sim->checkpoint_time>0.0&&sim->t-ckpt->t_last>=sim->checkpoint_time){
+		due=1;
+	}
+	if(sim->checkpoint_walltime>0.0&&prof_time()-ckpt->wall_last>=sim->checkpoint_walltime){
+		due=1;
+	}
+	if(stop_signal){
+		ckpt->stop=1;
+	}
+	if(mesh->comm->nranks>1){
+		//The wall-clock time and the signals may differ among the ranks
+		due=(comm_max(mesh->comm,due)>0.5);
+		ckpt->stop=(comm_max(mesh->comm,ckpt->stop)>0.5);
+	}
+
+	return (due||ckpt->stop);
+}
+
+
+void write_checkpoint(t_checkpoint *ckpt, t_mesh *mesh, t_sim *sim, double timeac, double timeac2, int nIt){
+
+	t_checkpoint_header head;
+	double **field[3],t0;
+	char tmpfile[1100];
+	FILE *fp;
+	int f,k,g,ok,fd;
+
+	PROF_START(t0);
+	checkpoint_fields(mesh,field);
+	memset(&head,0,sizeof(head));
+	memcpy(head.magic,CHECKPOINT_MAGIC,8);
+	head.version=CHECKPOINT_VERSION;
+	head.seq=ckpt->seq+1;
+	head.nvar=sim->nvar;
+	head.eq_system=sim->eq_system;
+	head.order=sim->order;
+	head.st=sim->st;
+	head.nranks=mesh->comm->nranks;
+	head.rank=mesh->comm->rank;
+	head.gcells[0]=mesh->gxcells;
+	head.gcells[1]=mesh->gycells;
+	head.gcells[2]=mesh->gzcells;
+	for(k=0;k<3;k++){
+		head.offset[k]=mesh->offset[k];
+	}
+	head.cells[0]=mesh->xcells;
+	head.cells[1]=mesh->ycells;
+	head.cells[2]=mesh->zcells;
+	head.nIt=nIt;
+	head.t=sim->t;
+	head.dt=sim->dt;
+	head.timeac=timeac;
+	head.timeac2=timeac2;
+	head.mass0=mesh->mass0;
+	head.energy0=mesh->energy0;
+	head.checksum=14695981039346656037ULL;
+	for(f=0;f<3;f++){
+		for(k=0;k<sim->nvar;k++){
+			head.checksum=checksum_update(head.checksum,field[f][k],mesh->ncells);
+		}
+	}
+
+	//The file is complete on disk before it replaces the previous checkpoint
+	snprintf(tmpfile,sizeof(tmpfile),"%s.tmp",ckpt->path[0]);
+	fp=fopen(tmpfile,"wb");
+	ok=(fp!=NULL);
+	if(ok){
+		ok=(fwrite(&head,sizeof(head),1,fp)==1);
+		for(f=0;f<3&&ok;f++){
+			for(k=0;k<sim->nvar&&ok;k++){
+				ok=(fwrite(field[f][k],sizeof(double),mesh->ncells,fp)==(size_t)mesh->ncells);
+			}
+		}
+		ok=ok&&(fflush(fp)==0)&&(fsync(fileno(fp))==0);
+		ok=(fclose(fp)==0)&&ok;
+	}
+	if(!ok){
+		printf("%s The checkpoint %s could not be written\n",WAR,tmpfile);
+		remove(tmpfile);
+		PROF_LAP(sim,PROF_CHECKPOINT,t0);
+		return;
+	}
+	for(g=CHECKPOINT_KEEP-1;g>0;g--){
+		rename(ckpt->path[g-1],ckpt->path[g]);
+	}
+	if(rename(tmpfile,ckpt->path[0])!=0){
+		printf("%s The checkpoint %s could not be written\n",WAR,ckpt->path[0]);
+		PROF_LAP(sim,PROF_CHECKPOINT,t0);
+		return;
+	}
+	//The renames are made durable by syncing the folder
+	snprintf(tmpfile,sizeof(tmpfile),"%s",ckpt->path[0]);
+	if(strrchr(tmpfile,'/')!=NULL){
+		*strrchr(tmpfile,'/')='\0';
+	}else{
+		snprintf(tmpfile,sizeof(tmpfile),".");
+	}
+	fd=open(tmpfile,O_RDONLY);
+	if(fd>=0){
+		fsync(fd);
+		close(fd);
+	}
+
+	ckpt->seq=head.seq;
+	ckpt->t_last=sim->t;
+	ckpt->wall_last=prof_time();
+	printf("%s Checkpoint %d written at T= %14.14e\n",OK,ckpt->seq,sim->t);
+	PROF_LAP(sim,PROF_CHECKPOINT,t0);
+
+}
@@ -0,0 +1,27 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - checkpoint.h
+
+Content:
+  -This file contains the function prototypes for checkpoint.c
+
+*/
+
+
+#ifndef CHECKPOINT_H
+  #define CHECKPOINT_H
+
+  t_checkpoint *checkpoint_init(t_mesh *mesh, t_sim *sim, const char *folder_path);
+  int read_checkpoint(t_checkpoint *ckpt, t_mesh *mesh, t_sim *sim, double *timeac, double *timeac2, int *nIt);
+  int checkpoint_due(t_checkpoint *ckpt, t_mesh *mesh, t_sim *sim);
+  void write_checkpoint(t_checkpoint *ckpt, t_mesh *mesh, t_sim *sim, double timeac, double timeac2, int nIt);
+  void truncate_time_series(const char *fname, double t);
+
+#endif
@@ -10,7 +10,9 @@ File:
   - closures.h
 
 Content:
-  -This code file contains the function prototypes for closures.c
+  -This header file contains all the functions related with the closure equations for the pressure.
+   They are inline functions, so that the source term type st is resolved at compile time in the
+   specialized kernels, where it is a constant.
 
 */
 
@@ -18,7 +20,45 @@ Content:
 #ifndef CLOSURES_H
   #define CLOSURES_H
 
-double energy_from_pressure(double gm, double p, double u, double v, double w, double rho, double z);
-double pressure_from_energy(double gm, double E, double u, double v, double w, double rho, double z);
+//Ratio of specific heats. For multicomponent flow, it depends on the transported variable phi (see MULTI_TYPE)
+static inline double mixture_gamma(int multicomponent, double phi){
+
+	if(multicomponent){
+		#if MULTI_TYPE==1
+		return phi;
+		#else
+		return 1.0+1.0/phi;
+		#endif
+	}
+
+	return _gamma_;
+}
+
+static inline double energy_from_pressure(int st, double gm, double p, double u, double v, double w, double rho, double z){
+
+	double energy;
+
+	if(st==3){
+	energy=p/(gm-1.0)+0.5*rho*(u*u + v*v + w*w)+rho*_g_*z;
+	}else{
+	energy=p/(gm-1.0)+0.5*rho*(u*u + v*v + w*w);
+	}
+
+	return energy;
+}
+
+static inline double pressure_from_energy(int st, double gm, double E, double u, double v, double w, double rho, double z){
+
+	double pressure;
+
+	if(st==3){
+	pressure=(gm-1.0)*(E-0.5*rho*(u*u + v*v + w*w)-rho*_g_*z);
+	}else{
+	pressure=(gm-1.0)*(E-0.5*rho*(u*u + v*v + w*w));
+	}
+
+
+	return pressure;
+}
 
 #endif
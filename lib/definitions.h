@@ -39,15 +39,27 @@ Content:
 #define MIN(x,y) (x < y ? x : y)
 #define MAX(x,y) (x > y ? x : y)
 #define ABS(x) (x < 0 ? -x : x)
+#define MAX_NVAR 6 //maximum number of conserved variables
+#define NPRIM 4 //number of primitive variables of the cache mesh->W: PRIM_U, PRIM_V, PRIM_W, PRIM_P
+#define PRIM_U 0
+#define PRIM_V 1
+#define PRIM_W 2
+#define PRIM_P 3
+#define PENCIL_HALO 4 //halo width of the pencil line buffers (half stencil of the 7th order reconstruction, plus the cell beyond a subdomain boundary)
+#define MAX_RK_STAGES 10 //maximum number of stages of the Runge-Kutta schemes
 
 //reconstruction method
 #define TYPE_REC 0 //This is 0 for WENO, 1 for TENO and 2 for optimal reconstruction
+#define REC_VARIABLES 0 //Variables of the reconstruction (Euler): 0 for conserved, 1 for primitive (rho, u, v, w, p, phi). Only with ST 0
+#define SIMD_DISPATCH 1 //1: the batch reconstruction kernels and Riemann solvers are built for AVX-512, AVX2 and baseline x86-64, and selected at runtime
 #define _CT_ 1.0e-6
 #define epsilon  1.0E-6
 #define epsilon2 1.0E-40
 #define _Q_ 6.0
 
-//Equations
+//Equations, solvers and reconstruction. These are the default values, which can be changed at
+//runtime in configure.input (EquationSystem, SourceTerm, Multicomponent, Solver, Reconstruction,
+//ReconstructionVariables)
 #define EQUATION_SYSTEM 0 // 0: Linear advection, 1: Burgers, 2: Compressible Euler 
 
 //Source terms for Euler
@@ -66,16 +78,38 @@ Content:
 //IBM utils
 #define ALLOW_SOLIDS 0 //0: no solid cells
 #define _stol_ 2.0 //tolerance for the generation of ghost cell layers. 1.0: 1 layer, 2.0: 2 layers....
+#define _ibmbin_ 8 //size (in cells per direction) of the bins of the triangle index used to find the ghost cells
 
-//OpenMP configuration
-#define NTHREADS 24
+//OpenMP configuration. The number of threads is taken from the command line (-t N), OMP_NUM_THREADS or
+//NTHREADS, in this order. 0: one thread per CPU available to the rank (see threads_init())
+#define NTHREADS 0
+#define PIN_THREADS 1 //1: each thread is pinned to a CPU, spread over sockets and cores
+
+//MPI domain decomposition. It is set with make MPI=1 (see mpicomm.c)
+#ifndef USE_MPI
+#define USE_MPI 0
+#endif
+
+//Memory alignment (in bytes) of the state arrays
+#define MEM_ALIGN 64
 
 //Output files
 #define WRITE_VTK 1
 #define WRITE_LIST 1
 #define WRITE_TKE 0 //write file TKE evolution in time
-
-//Printing variables (vtk)
+#define VTK_FORMAT 1 //0: legacy ASCII files (.vtk), 1: XML image data with appended binary data (.vti, and .pvti with MPI). Can be changed at runtime in configure.input
+#ifndef USE_ZLIB
+#define USE_ZLIB 0 //1 (make ZLIB=1): the data of the .vti files is compressed with zlib
+#endif
+#define VTK_ZLIB_LEVEL 1 //zlib compression level of the .vti files (1: fastest, 9: smallest)
+#define ASYNC_OUTPUT 1 //1: the state files (VTK and .out) are written by a background thread while the computation continues
+#define OUTPUT_QUEUE 2 //number of copies of the state that can wait to be written (ASYNC_OUTPUT). When all are used, the computation waits
+#define CHECKPOINT_KEEP 2 //number of checkpoint files kept (see CheckpointTime and CheckpointWallTime in configure.input)
+
+//Profiling
+#define PROFILE 1 //1: wall-clock time of each phase (per thread), MCUPS and load imbalance at each dump, and out/profile.json at the end
+
+//Printing variables (vtk). Default values, which can be changed at runtime in configure.input
 #define print_RHO 1
 #define print_VELOCITY 1
 #define print_ENERGY 0
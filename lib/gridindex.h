@@ -0,0 +1,195 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - gridindex.h
+
+Content:
+  -This header file contains the index arithmetic of the structured grid.
+   Faces and nodes are not stored: their ids, neighbour cells and geometry
+   are computed from the (l,m,n) indices of the cells.
+
+   Faces are numbered per direction d (0: x, 1: y, 2: z). The face (l,m,n) of
+   direction d is the lower face of the cell (l,m,n) in that direction, so
+   there are xcells+1 faces along x for the x-faces, and so on. Pencils are
+   the 1D lines of cells along each direction, used by the flux sweeps.
+
+*/
+
+#ifndef GRIDINDEX_H
+#define GRIDINDEX_H
+#include "definitions.h"
+#include "structures.h"
+
+
+//Id of the node (l,m,n)
+static inline int node_id(const t_mesh *mesh, int l, int m, int n){
+	return l + m*(mesh->xcells+1) + n*(mesh->xcells+1)*(mesh->ycells+1);
+}
+
+
+//Left and right cells of the face f of direction d. Outer faces take the cell
+//at the opposite side of the domain (periodic), as boundary fluxes are rewritten
+//when required. The return value is the boundary face (1 to 6) or 0 for inner faces.
+static inline int face_cells(const t_mesh *mesh, int d, int f, int *idL, int *idR, int *l, int *m, int *n){
+	int xcells,ycells,zcells,fx,fy;
+	int side;
+
+	xcells=mesh->xcells;
+	ycells=mesh->ycells;
+	zcells=mesh->zcells;
+	fx=xcells+(d==0);
+	fy=ycells+(d==1);
+	*l=f%fx;
+	*m=(f/fx)%fy;
+	*n=f/(fx*fy);
+
+	side=0;
+	if(d==0){
+		*idR=(*l==xcells ? 0 : *l) + (*m)*xcells + (*n)*xcells*ycells;
+		*idL=(*l==0 ? xcells-1 : *l-1) + (*m)*xcells + (*n)*xcells*ycells;
+		if(*l==0) side=4;
+		if(*l==xcells) side=2;
+	}else if(d==1){
+		*idR=*l + (*m==ycells ? 0 : *m)*xcells + (*n)*xcells*ycells;
+		*idL=*l + (*m==0 ? ycells-1 : *m-1)*xcells + (*n)*xcells*ycells;
+		if(*m==0) side=1;
+		if(*m==ycells) side=3;
+	}else{
+		*idR=*l + (*m)*xcells + (*n==zcells ? 0 : *n)*xcells*ycells;
+		*idL=*l + (*m)*xcells + (*n==0 ? zcells-1 : *n-1)*xcells*ycells;
+		if(*n==0) side=5;
+		if(*n==zcells) side=6;
+	}
+
+	return side;
+}
+
+
+//Id of the neighbour of the cell k across its face iface (1: -y, 2: +x, 3: +y, 4: -x, 5: -z, 6: +z).
+//The domain is assumed periodic.
+static inline int cell_neighbour(const t_mesh *mesh, int k, int iface){
+	int l,m,n;
+
+	l=k%mesh->xcells;
+	m=(k/mesh->xcells)%mesh->ycells;
+	n=k/(mesh->xcells*mesh->ycells);
+	switch(iface){
+		case 1: m=(m==0 ? mesh->ycells-1 : m-1); break;
+		case 2: l=(l==mesh->xcells-1 ? 0 : l+1); break;
+		case 3: m=(m==mesh->ycells-1 ? 0 : m+1); break;
+		case 4: l=(l==0 ? mesh->xcells-1 : l-1); break;
+		case 5: n=(n==0 ? mesh->zcells-1 : n-1); break;
+		default: n=(n==mesh->zcells-1 ? 0 : n+1); break;
+	}
+
+	return l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
+}
+
+
+//Number of pencils (1D lines of cells) along the direction d
+static inline int pencil_count(const t_mesh *mesh, int d){
+	if(d==0){
+		return mesh->ycells*mesh->zcells;
+	}else if(d==1){
+		return mesh->xcells*mesh->zcells;
+	}else{
+		return mesh->xcells*mesh->ycells;
+	}
+}
+
+
+//Cells and faces of the pencil q of direction d. The cell p of the pencil (p=0...ncells-1)
+//has id base+p*stride and its lower face is fbase+p*fstride. The indices (l,m,n) of the
+//first cell are returned. The return value is the number of cells of the pencil.
+static inline int pencil_index(const t_mesh *mesh, int d, int q, int *base, int *stride, int *fbase, int *fstride, int *l, int *m, int *n){
+	int xcells,ycells,zcells;
+
+	xcells=mesh->xcells;
+	ycells=mesh->ycells;
+	zcells=mesh->zcells;
+	if(d==0){
+		*l=0; *m=q%ycells; *n=q/ycells;
+		*base=q*xcells;
+		*stride=1;
+		*fbase=q*(xcells+1);
+		*fstride=1;
+		return xcells;
+	}else if(d==1){
+		*l=q%xcells; *m=0; *n=q/xcells;
+		*base=*l+(*n)*xcells*ycells;
+		*stride=xcells;
+		*fbase=*l+(*n)*xcells*(ycells+1);
+		*fstride=xcells;
+		return ycells;
+	}else{
+		*l=q%xcells; *m=q/xcells; *n=0;
+		*base=q;
+		*stride=xcells*ycells;
+		*fbase=q;
+		*fstride=xcells*ycells;
+		return zcells;
+	}
+}
+
+
+//Height of the faces of direction d placed at the z-index n (n=0...zcells for the z-faces). The
+//global index is used, so that both subdomains compute the same height for a shared face
+static inline double face_height(const t_mesh *mesh, int d, int n){
+	n+=mesh->offset[2];
+	if(d==2){
+		if(n<mesh->gzcells){
+			return (n+0.5)*mesh->dz-0.5*mesh->dz;
+		}else{
+			return (n-0.5)*mesh->dz+0.5*mesh->dz;
+		}
+	}else{
+		return (n+0.5)*mesh->dz;
+	}
+}
+
+
+//Id of the cell with global indices (l,m,n), or -1 if it is not in the subdomain of this rank
+static inline int local_cell(const t_mesh *mesh, int l, int m, int n){
+	l-=mesh->offset[0];
+	m-=mesh->offset[1];
+	n-=mesh->offset[2];
+	if(l<0||l>=mesh->xcells||m<0||m>=mesh->ycells||n<0||n>=mesh->zcells){
+		return -1;
+	}
+	return l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
+}
+
+
+//Boundary side (1 to 6, see face_cells()) at the lower (s=0) or upper (s=1) end of the direction d
+static inline int boundary_side(int d, int s){
+	if(d==0){
+		return (s==0 ? 4 : 2);
+	}else if(d==1){
+		return (s==0 ? 1 : 3);
+	}else{
+		return (s==0 ? 5 : 6);
+	}
+}
+
+
+//1 if the boundary side (1 to 6, see face_cells()) of the subdomain is a boundary of the domain,
+//0 if it is shared with another subdomain
+static inline int domain_boundary(const t_mesh *mesh, int side){
+	switch(side){
+		case 1: return mesh->offset[1]==0;
+		case 2: return mesh->offset[0]+mesh->xcells==mesh->gxcells;
+		case 3: return mesh->offset[1]+mesh->ycells==mesh->gycells;
+		case 4: return mesh->offset[0]==0;
+		case 5: return mesh->offset[2]==0;
+		default: return mesh->offset[2]+mesh->zcells==mesh->gzcells;
+	}
+}
+
+
+#endif
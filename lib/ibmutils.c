@@ -24,9 +24,56 @@ Content:
 #include "definitions.h"
 #include "structures.h"
 #include "ibmutils.h"
+#include "gridindex.h"
 
 
 
+//Packs the ghost cells (ghost==1) in increasing order, with the neighbours of their image points,
+//the interpolation weights and the normals of their facets, so that update_ghost_cells() does not
+//visit the whole mesh. A neighbour that is a ghost cell has a null weight and is replaced by the
+//ghost cell itself, which keeps the interpolation unchanged and the parallel update free of races
+static void build_ghost_table(t_mesh *mesh){
+	t_cell *cell;
+	int n,g,q,c;
+
+	cell=mesh->cell;
+	free(mesh->ghosts);
+	free(mesh->gni);
+	free(mesh->gli);
+	free(mesh->gnr);
+	mesh->nghost=0;
+	for(n=0;n<mesh->ncells;n++){
+		if(cell[n].ghost==1){
+			mesh->nghost++;
+		}
+	}
+	mesh->ghosts=(int*)malloc(MAX(mesh->nghost,1)*sizeof(int));
+	mesh->gni=(int*)malloc(8*MAX(mesh->nghost,1)*sizeof(int));
+	mesh->gli=(double*)malloc(8*MAX(mesh->nghost,1)*sizeof(double));
+	mesh->gnr=(double*)malloc(3*MAX(mesh->nghost,1)*sizeof(double));
+
+	g=0;
+	for(n=0;n<mesh->ncells;n++){
+		if(cell[n].ghost==1){
+			mesh->ghosts[g]=n;
+			for(q=0;q<8;q++){
+				if(cell[cell[n].ni[q]].ghost==1){
+					mesh->gni[8*g+q]=n;
+					mesh->gli[8*g+q]=0.0;
+				}else{
+					mesh->gni[8*g+q]=cell[n].ni[q];
+					mesh->gli[8*g+q]=cell[n].li[q];
+				}
+			}
+			for(c=0;c<3;c++){
+				mesh->gnr[3*g+c]=cell[n].tri->nr[c];
+			}
+			g++;
+		}
+	}
+}
+
+
 int assign_image_cells(t_mesh *mesh,t_solid *solids){
 	t_cell *cell;
 	int n,q;
@@ -112,6 +159,7 @@ int assign_image_cells(t_mesh *mesh,t_solid *solids){
 			  }
 		}
 
+		build_ghost_table(mesh);
 		//printf("%s Image points have been identified \n\n",OK);
 	}
 
@@ -120,40 +168,37 @@ int assign_image_cells(t_mesh *mesh,t_solid *solids){
 
 
 int update_ghost_cells(t_sim *sim,t_mesh *mesh,t_solid *solids){
-	t_cell *cell;
-      t_triangle *triangle;
-	int n,k,q;
-      double auxval[sim->nvar];
-      double dotprod;
+	//The ghost cells are updated from the table of build_ghost_table(), in parallel. A ghost cell
+	//only reads fluid or solid cells (or itself), so the ghost cells are independent
+	int g,n,k,q,nvar;
+	const int *ni;
+	const double *li,*nr;
+	double dotprod;
 
 	if(solids->nsolid>0){
-		cell=mesh->cell;
-		for(n=0;n<mesh->ncells;n++){
-			  if (cell[n].ghost==1) {
-				triangle=cell[n].tri;  // triangular facet associated to a ghost cell
-				for(k=0;k<sim->nvar;k++){
-					auxval[k]=0.0;
-					for(q=0;q<8;q++){
-						auxval[k]= auxval[k] + cell[n].li[q]* cell[cell[n].ni[q]].U[k]; //interpolated variables at image point
-						//printf("li:%lf U:%lf \n", cell[n].li[q],cell[cell[n].ni[q]].U[k] );
-					}
-					//getchar();
+		nvar=sim->nvar;
+#pragma omp parallel for default(none) private(n,k,q,ni,li,nr,dotprod) shared(mesh,nvar) schedule(static)
+		for(g=0;g<mesh->nghost;g++){
+			n=mesh->ghosts[g];
+			ni=mesh->gni+8*g;
+			li=mesh->gli+8*g;
+			nr=mesh->gnr+3*g; //normal of the triangular facet associated to the ghost cell
+			double auxval[nvar];
+			for(k=0;k<nvar;k++){
+				auxval[k]=0.0;
+				for(q=0;q<8;q++){
+					auxval[k]= auxval[k] + li[q]* mesh->U[k][ni[q]]; //interpolated variables at image point
 				}
+			}
 
-
-				dotprod=triangle->nr[0]*auxval[1]+triangle->nr[1]*auxval[2]+triangle->nr[2]*auxval[3];
-				for(k=0;k<sim->nvar;k++){
-					if(k==1||k==2||k==3){
-						cell[n].U[k]=auxval[k]-2.0*dotprod*triangle->nr[k-1]; //this is a reflection for vector variables u_r=u-2*(u·n)n, which allows to impose the Dirichlet BC of zero velocity at solid faces
-					}else{
-						cell[n].U[k]=auxval[k]; //non-vector variables are assigned equal
-					}
-
+			dotprod=nr[0]*auxval[1]+nr[1]*auxval[2]+nr[2]*auxval[3];
+			for(k=0;k<nvar;k++){
+				if(k==1||k==2||k==3){
+					mesh->U[k][n]=auxval[k]-2.0*dotprod*nr[k-1]; //this is a reflection for vector variables u_r=u-2*(u·n)n, which allows to impose the Dirichlet BC of zero velocity at solid faces
+				}else{
+					mesh->U[k][n]=auxval[k]; //non-vector variables are assigned equal
 				}
-
-
-
-			  }
+			}
 		}
 
 		//printf("%s Ghost cell values have been computed \n\n",OK);
@@ -165,26 +210,28 @@ int update_ghost_cells(t_sim *sim,t_mesh *mesh,t_solid *solids){
 
 
 int update_wall_type(t_mesh *mesh,t_solid *solids){
-	t_wall *wall;
-	int n;
+	t_cell *cellL,*cellR;
+	int d,f,idL,idR,l,m,n;
 
 	if(solids->nsolid<1){
             printf("%s In function update_wall_type() no solids are considered\n",WAR);
       }else{
-		for(n=0;n<mesh->nwalls;n++){
-			wall=&(mesh->wall[n]);
-
-			if(wall->cellL->ghost>0 && wall->cellR->ghost>0){       //left and right ghost
-				wall->wtype=0;
-			}else if(wall->cellR->type==0 && wall->cellL->ghost>0){ //left ghost and right solid
-				wall->wtype=0;
-			}else if(wall->cellL->type==0 && wall->cellR->ghost>0){ //left solid and right ghost
-				wall->wtype=0;
-			}else if(wall->cellL->type==0 && wall->cellR->type==0){ //left and right solids
-				wall->wtype=0;
+		for(d=0;d<3;d++){
+			for(f=0;f<mesh->nfaces[d];f++){
+				face_cells(mesh,d,f,&idL,&idR,&l,&m,&n);
+				cellL=&(mesh->cell[idL]);
+				cellR=&(mesh->cell[idR]);
+
+				if(cellL->ghost>0 && cellR->ghost>0){       //left and right ghost
+					mesh->wtype[d][f]=0;
+				}else if(cellR->type==0 && cellL->ghost>0){ //left ghost and right solid
+					mesh->wtype[d][f]=0;
+				}else if(cellL->type==0 && cellR->ghost>0){ //left solid and right ghost
+					mesh->wtype[d][f]=0;
+				}else if(cellL->type==0 && cellR->type==0){ //left and right solids
+					mesh->wtype[d][f]=0;
+				}
 			}
-
-
 		}
 
 	}
@@ -192,4 +239,3 @@ int update_wall_type(t_mesh *mesh,t_solid *solids){
       return 1;
 
 }
-
@@ -0,0 +1,307 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - kernels.c
+
+Content:
+  -This file contains the instances of the flux kernels (solvers_template.h and sweep_template.h)
+   for every valid combination of EQUATION_SYSTEM, SOLVER, ST and MULTICOMPONENT, and the
+   selection of the instance that corresponds to the options of the run. The options are constant
+   inside each instance, so there are no branches on them in the flux loops.
+  
+*/
+
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <omp.h>
+
+#include "definitions.h"
+#include "structures.h"
+#include "kernels.h"
+#include "numcore.h"
+#include "reconst.h"
+#include "closures.h"
+#include "gridindex.h"
+#include "profiler.h"
+#include "mpicomm.h"
+
+//The defaults of definitions.h are replaced by the values of each instance
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+
+#define KERNEL_SUFFIX lin
+#define EQUATION_SYSTEM 0
+#define SOLVER 0
+#define ST 0
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX burgers
+#define EQUATION_SYSTEM 1
+#define SOLVER 0
+#define ST 0
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st0_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 0
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st0_mc1
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 0
+#define MULTICOMPONENT 1
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st1_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 1
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st1_mc1
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 1
+#define MULTICOMPONENT 1
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st2_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 2
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st2_mc1
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 2
+#define MULTICOMPONENT 1
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st3_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 3
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hll_st3_mc1
+#define EQUATION_SYSTEM 2
+#define SOLVER 0
+#define ST 3
+#define MULTICOMPONENT 1
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hllc_st0_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 1
+#define ST 0
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hllc_st1_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 1
+#define ST 1
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hllc_st2_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 1
+#define ST 2
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hllc_st3_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 1
+#define ST 3
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hlls_st1_mc0
+#define EQUATION_SYSTEM 2
+#define SOLVER 2
+#define ST 1
+#define MULTICOMPONENT 0
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+#define KERNEL_SUFFIX hlls_st1_mc1
+#define EQUATION_SYSTEM 2
+#define SOLVER 2
+#define ST 1
+#define MULTICOMPONENT 1
+#include "solvers_template.h"
+#include "sweep_template.h"
+#undef KERNEL_SUFFIX
+#undef EQUATION_SYSTEM
+#undef SOLVER
+#undef ST
+#undef MULTICOMPONENT
+
+
+//Table of instances. For the scalar equations, the solver, source term and multicomponent
+//options do not apply (-1)
+typedef struct {
+	int eq_system,solver,st,multicomponent;
+	int (*compute_fluxes)(t_mesh *mesh, t_sim *sim, int stage);
+} t_kernel_instance;
+
+static const t_kernel_instance kernel_instances[]={
+	{0,-1,-1,-1,compute_fluxes_lin},
+	{1,-1,-1,-1,compute_fluxes_burgers},
+	{2,0,0,0,compute_fluxes_hll_st0_mc0},
+	{2,0,0,1,compute_fluxes_hll_st0_mc1},
+	{2,0,1,0,compute_fluxes_hll_st1_mc0},
+	{2,0,1,1,compute_fluxes_hll_st1_mc1},
+	{2,0,2,0,compute_fluxes_hll_st2_mc0},
+	{2,0,2,1,compute_fluxes_hll_st2_mc1},
+	{2,0,3,0,compute_fluxes_hll_st3_mc0},
+	{2,0,3,1,compute_fluxes_hll_st3_mc1},
+	{2,1,0,0,compute_fluxes_hllc_st0_mc0},
+	{2,1,1,0,compute_fluxes_hllc_st1_mc0},
+	{2,1,2,0,compute_fluxes_hllc_st2_mc0},
+	{2,1,3,0,compute_fluxes_hllc_st3_mc0},
+	{2,2,1,0,compute_fluxes_hlls_st1_mc0},
+	{2,2,1,1,compute_fluxes_hlls_st1_mc1}
+};
+
+
+void select_kernels(t_sim *sim){
+
+	int i,n;
+	const t_kernel_instance *ki;
+
+	select_reconstruction(sim);
+
+	sim->kernels.compute_fluxes=NULL;
+	n=sizeof(kernel_instances)/sizeof(kernel_instances[0]);
+	for(i=0;i<n;i++){
+		ki=&(kernel_instances[i]);
+		if(ki->eq_system==sim->eq_system &&
+		   (ki->solver<0||ki->solver==sim->solver) &&
+		   (ki->st<0||ki->st==sim->st) &&
+		   (ki->multicomponent<0||ki->multicomponent==sim->multicomponent)){
+			sim->kernels.compute_fluxes=ki->compute_fluxes;
+		}
+	}
+
+	if(sim->kernels.compute_fluxes==NULL){
+		printf("%s There is no flux kernel for EquationSystem %d, Solver %d, SourceTerm %d and Multicomponent %d. The program will close when pressing a key. \n",ERR,sim->eq_system,sim->solver,sim->st,sim->multicomponent);
+		getchar();
+		exit(1);
+	}
+
+}
@@ -0,0 +1,38 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - kernels.h
+
+Content:
+  -This file contains the function prototypes for kernels.c and the naming macro of the
+   specialized kernels. A template file is included once per configuration, with KERNEL_SUFFIX
+   defined to a different value each time, so that KERNEL(name) gives a different function name
+   for each instance.
+  
+*/
+
+
+#ifndef KERNELS_H
+  #define KERNELS_H
+
+  #define KERNEL_CAT_(name,suffix) name##_##suffix
+  #define KERNEL_CAT(name,suffix) KERNEL_CAT_(name,suffix)
+  #define KERNEL(name) KERNEL_CAT(name,KERNEL_SUFFIX)
+
+  //Functions that are instantiated for constant arguments (e.g. the sweep direction) by their callers
+#if defined(__GNUC__)
+  #define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+  #define KERNEL_INLINE inline
+#endif
+
+  void select_kernels(t_sim *sim);
+
+
+#endif
@@ -0,0 +1,539 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - mpicomm.c
+
+Content:
+  -This file contains the domain decomposition for multi-node runs (make MPI=1). The grid is
+   split into blocks, one per rank, over a 3D Cartesian communicator. Each rank keeps only the
+   cells of its block (mesh->xcells, ycells and zcells are the sizes of the block) and receives
+   from its neighbours the layers of cells needed by the stencils of its boundary cells.
+
+   The reconstruction is done along pencils, so only the halos across the six faces of the block
+   are needed (no edges nor corners). The halos of the three directions are sent at the beginning
+   of compute_fluxes(), and each sweep only waits for the halo of its own direction: the y and z
+   halos are in flight while the x-sweep is computed. A face shared by two blocks is computed by
+   both ranks with the same data, so the scheme remains conservative.
+
+   The time step and the totals of mass and energy are reduced over all the ranks. Output files
+   are written per rank (see rank_filename()).
+
+*/
+
+
+#define _GNU_SOURCE //sched_setaffinity()
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sched.h>
+#include <omp.h>
+
+#include "definitions.h"
+#include "structures.h"
+#include "mpicomm.h"
+#include "gridindex.h"
+#include "profiler.h"
+
+
+t_comm *parallel_init(int *argc, char ***argv){
+
+	t_comm *comm;
+	int d,s;
+#if USE_MPI
+	int provided;
+#endif
+
+	comm=(t_comm*)malloc(sizeof(t_comm));
+	comm->rank=0;
+	comm->nranks=1;
+	for(d=0;d<3;d++){
+		comm->dims[d]=1;
+		comm->coords[d]=0;
+		for(s=0;s<2;s++){
+			comm->nbr[d][s]=-1;
+			comm->halo[d][s]=NULL;
+			comm->send[d][s]=NULL;
+		}
+	}
+
+#if USE_MPI
+	//MPI is only called by the master thread, outside of the worksharing loops
+	MPI_Init_thread(argc,argv,MPI_THREAD_FUNNELED,&provided);
+	MPI_Comm_rank(MPI_COMM_WORLD,&comm->rank);
+	MPI_Comm_size(MPI_COMM_WORLD,&comm->nranks);
+	if(comm->rank!=0){
+		//Only the first rank writes on screen
+		if(freopen("/dev/null","w",stdout)==NULL){
+			printf("%s The screen output of rank %d could not be disabled\n",WAR,comm->rank);
+		}
+	}
+	if(provided<MPI_THREAD_FUNNELED){
+		printf("%s The MPI library does not support MPI_THREAD_FUNNELED\n",WAR);
+	}
+	printf("%s MPI is initialized with %d ranks\n",OK,comm->nranks);
+#endif
+
+	return comm;
+}
+
+
+void parallel_finalize(t_comm *comm){
+
+#if USE_MPI
+	MPI_Finalize();
+#endif
+
+}
+
+#ifdef __linux__
+//CPUs available to the process before the threads are pinned (see threads_unpin())
+static cpu_set_t process_mask;
+static int process_mask_saved=0;
+
+//Position of a CPU in the machine, read from /sys. The CPUs are ordered by hardware thread of the core
+//(smt), socket (package) and core, so that the first ones of the list are one per physical core
+typedef struct{
+	int cpu,package,core,smt;
+} t_cpuslot;
+
+static int read_topology(int cpu, const char *item){
+
+	FILE *fp;
+	char fname[256];
+	int value;
+
+	snprintf(fname,sizeof(fname),"/sys/devices/system/cpu/cpu%d/topology/%s",cpu,item);
+	fp=fopen(fname,"r");
+	if(fp==NULL){
+		return -1;
+	}
+	if(fscanf(fp,"%d",&value)!=1){
+		value=-1;
+	}
+	fclose(fp);
+	return value;
+
+}
+
+static int compare_socket_first(const void *a, const void *b){
+
+	const t_cpuslot *p=(const t_cpuslot*)a, *q=(const t_cpuslot*)b;
+
+	if(p->package!=q->package) return p->package-q->package;
+	if(p->core!=q->core) return p->core-q->core;
+	if(p->smt!=q->smt) return p->smt-q->smt;
+	return p->cpu-q->cpu;
+
+}
+
+static int compare_core_first(const void *a, const void *b){
+
+	const t_cpuslot *p=(const t_cpuslot*)a, *q=(const t_cpuslot*)b;
+
+	if(p->smt!=q->smt) return p->smt-q->smt;
+	return compare_socket_first(a,b);
+
+}
+
+
+//CPUs that this rank may use, sorted by socket and core. When several ranks run in the same node and
+//the MPI launcher has not bound them (all of them see the same CPUs), each one takes a contiguous part
+static int rank_cpus(t_comm *comm, t_cpuslot *slot){
+
+	int cpu,i,n,first,last;
+#if USE_MPI
+	MPI_Comm node;
+	int lrank,lsize,minfirst,maxfirst;
+#endif
+
+	n=0;
+	for(cpu=0;cpu<CPU_SETSIZE;cpu++){
+		if(CPU_ISSET(cpu,&process_mask)){
+			slot[n].cpu=cpu;
+			slot[n].package=MAX(read_topology(cpu,"physical_package_id"),0);
+			slot[n].core=read_topology(cpu,"core_id");
+			if(slot[n].core<0) slot[n].core=cpu;
+			slot[n].smt=0;
+			for(i=0;i<n;i++){
+				if(slot[i].package==slot[n].package&&slot[i].core==slot[n].core) slot[n].smt++;
+			}
+			n++;
+		}
+	}
+	qsort(slot,n,sizeof(t_cpuslot),compare_socket_first);
+
+	first=0;
+	last=n;
+#if USE_MPI
+	MPI_Comm_split_type(MPI_COMM_WORLD,MPI_COMM_TYPE_SHARED,comm->rank,MPI_INFO_NULL,&node);
+	MPI_Comm_rank(node,&lrank);
+	MPI_Comm_size(node,&lsize);
+	MPI_Allreduce(&slot[0].cpu,&minfirst,1,MPI_INT,MPI_MIN,node);
+	MPI_Allreduce(&slot[0].cpu,&maxfirst,1,MPI_INT,MPI_MAX,node);
+	MPI_Comm_free(&node);
+	if(lsize>1&&minfirst==maxfirst){
+		first=(int)((long)lrank*n/lsize);
+		last=(int)((long)(lrank+1)*n/lsize);
+		if(last==first) last=first+1; //more ranks than CPUs: they are shared
+	}
+#endif
+	for(i=first;i<last;i++){
+		slot[i-first]=slot[i];
+	}
+	n=last-first;
+	qsort(slot,n,sizeof(t_cpuslot),compare_core_first);
+
+	return n;
+}
+#endif
+
+
+//Number of OpenMP threads and placement of the threads. nthreads is the number of threads requested
+//(command line, OMP_NUM_THREADS or NTHREADS); with 0, one thread is used per CPU available to the rank.
+//With PIN_THREADS, each thread is pinned to a CPU, one per physical core while there are enough,
+//spread over the sockets so that consecutive threads (which work on consecutive cells with the static
+//schedule of the loops) share a socket. The pinning is left to the OpenMP runtime if OMP_PROC_BIND or
+//OMP_PLACES are set
+void threads_init(t_comm *comm, int nthreads){
+
+#ifdef _OPENMP
+#ifdef __linux__
+	t_cpuslot *slot;
+	int *cpu,n,nprimary,i,th,pin,nsockets,package;
+	cpu_set_t mask;
+
+	slot=NULL;
+	n=0;
+	if(sched_getaffinity(0,sizeof(cpu_set_t),&process_mask)==0){
+		process_mask_saved=1;
+		slot=(t_cpuslot*)malloc(CPU_SETSIZE*sizeof(t_cpuslot));
+		n=rank_cpus(comm,slot);
+	}
+	if(nthreads<=0){
+		nthreads=(n>0 ? n : omp_get_num_procs());
+	}
+	omp_set_num_threads(nthreads);
+
+	pin=(PIN_THREADS&&n>0&&getenv("OMP_PROC_BIND")==NULL&&getenv("OMP_PLACES")==NULL&&getenv("GOMP_CPU_AFFINITY")==NULL);
+	if(pin){
+		nprimary=0;
+		for(i=0;i<n;i++){
+			if(slot[i].smt==0) nprimary++;
+		}
+		cpu=(int*)malloc(nthreads*sizeof(int));
+		nsockets=0;
+		for(th=0;th<nthreads;th++){
+			if(nthreads<=nprimary){
+				i=(int)((long)th*nprimary/nthreads);
+			}else{
+				i=th%n;
+			}
+			cpu[th]=slot[i].cpu;
+			if(th==0||slot[i].package!=package){
+				nsockets++;
+			}
+			package=slot[i].package;
+		}
+#pragma omp parallel default(none) private(mask) shared(cpu)
+		{
+		CPU_ZERO(&mask);
+		CPU_SET(cpu[omp_get_thread_num()],&mask);
+		if(sched_setaffinity(0,sizeof(cpu_set_t),&mask)!=0){
+			printf("%s Thread %d could not be pinned to CPU %d\n",WAR,omp_get_thread_num(),cpu[omp_get_thread_num()]);
+		}
+		}
+		printf("%s %d threads are pinned to %d of the %d CPUs available in %d socket(s), CPUs %d...%d\n",
+			OK,nthreads,MIN(nthreads,n),n,nsockets,cpu[0],cpu[nthreads-1]);
+		free(cpu);
+	}else{
+		printf("%s %d threads. The threads are not pinned%s\n",OK,nthreads,(n>0&&PIN_THREADS ? " (placement set by the OpenMP runtime)" : ""));
+	}
+	free(slot);
+#else
+	if(nthreads<=0){
+		nthreads=omp_get_num_procs();
+	}
+	omp_set_num_threads(nthreads);
+	printf("%s %d threads\n",OK,nthreads);
+#endif
+#endif
+
+}
+
+
+//Releases the pinning of the calling thread, which may then run on any CPU available to the process.
+//It is called by the threads created after threads_init() (see output.c), which would otherwise
+//inherit the CPU of the master thread
+void threads_unpin(void){
+
+#ifdef __linux__
+	if(process_mask_saved){
+		sched_setaffinity(0,sizeof(cpu_set_t),&process_mask);
+	}
+#endif
+
+}
+
+
+
+//Split of the grid into blocks. It is called after read_config(), before create_mesh(): the number
+//of cells of the mesh is replaced by the number of cells of the block of this rank
+void decompose_domain(t_mesh *mesh, t_sim *sim){
+
+	t_comm *comm;
+	int gcells[3],cells[3];
+	int d,s,n,npencils;
+#if USE_MPI
+	int periodic[3];
+#endif
+
+	comm=mesh->comm;
+	mesh->gxcells=mesh->xcells;
+	mesh->gycells=mesh->ycells;
+	mesh->gzcells=mesh->zcells;
+	gcells[0]=mesh->xcells;
+	gcells[1]=mesh->ycells;
+	gcells[2]=mesh->zcells;
+	comm->width=(sim->order-1)/2+1;
+	comm->nvar=sim->nvar;
+
+#if USE_MPI
+	//Directions with a single cell (1D and 2D cases) are not split. At the non-periodic boundaries
+	//of the domain there is no neighbour, and the pencils are padded with ghost cells
+	periodic[0]=(mesh->bc[1]==1 && mesh->bc[3]==1);
+	periodic[1]=(mesh->bc[0]==1 && mesh->bc[2]==1);
+	periodic[2]=(mesh->bc[4]==1 && mesh->bc[5]==1);
+	for(d=0;d<3;d++){
+		comm->dims[d]=(gcells[d]==1 ? 1 : 0);
+	}
+	MPI_Dims_create(comm->nranks,3,comm->dims);
+	MPI_Cart_create(MPI_COMM_WORLD,3,comm->dims,periodic,0,&comm->cart);
+	MPI_Cart_coords(comm->cart,comm->rank,3,comm->coords);
+	for(d=0;d<3;d++){
+		if(comm->dims[d]>1){
+			MPI_Cart_shift(comm->cart,d,1,&comm->nbr[d][0],&comm->nbr[d][1]);
+			for(s=0;s<2;s++){
+				if(comm->nbr[d][s]==MPI_PROC_NULL){
+					comm->nbr[d][s]=-1;
+				}
+			}
+		}
+	}
+#endif
+
+	for(d=0;d<3;d++){
+		n=gcells[d]/comm->dims[d];
+		if(comm->dims[d]>1&&n<comm->width){ //checked with the smallest block, so that all the ranks stop
+			printf("%s The smallest subdomains have %d cells in direction %d, but %d are needed for the stencils. Use fewer ranks. The program will close when pressing a key.\n",ERR,n,d,comm->width);
+			getchar();
+			exit(1);
+		}
+	}
+	rank_block(mesh,comm->rank,mesh->offset,cells);
+	mesh->xcells=cells[0];
+	mesh->ycells=cells[1];
+	mesh->zcells=cells[2];
+
+	//Halo buffers of the split directions
+	for(d=0;d<3;d++){
+		if(comm->dims[d]>1){
+			npencils=pencil_count(mesh,d);
+			for(s=0;s<2;s++){
+				comm->halo[d][s]=(double*)malloc(comm->nvar*npencils*comm->width*sizeof(double));
+				comm->send[d][s]=(double*)malloc(comm->nvar*npencils*comm->width*sizeof(double));
+			}
+		}
+	}
+
+	if(comm->nranks>1){
+		printf("%s The domain is decomposed in %d x %d x %d blocks. Block of rank 0: %d x %d x %d cells\n",
+			OK,comm->dims[0],comm->dims[1],comm->dims[2],mesh->xcells,mesh->ycells,mesh->zcells);
+	}
+
+}
+
+
+//Block of the grid of a rank: global index of its first cell (offset) and number of cells (cells) in
+//each direction. The remainder of the division is given to the first blocks of each direction. The
+//ranks are numbered in row-major order over the Cartesian communicator (not reordered), so no MPI call
+//is needed and it can be called from the writer thread (see output.c)
+void rank_block(t_mesh *mesh, int rank, int *offset, int *cells){
+
+	t_comm *comm;
+	int d,n,r,gcells[3],coords[3];
+
+	comm=mesh->comm;
+	gcells[0]=mesh->gxcells;
+	gcells[1]=mesh->gycells;
+	gcells[2]=mesh->gzcells;
+	coords[2]=rank%comm->dims[2];
+	coords[1]=(rank/comm->dims[2])%comm->dims[1];
+	coords[0]=rank/(comm->dims[2]*comm->dims[1]);
+	for(d=0;d<3;d++){
+		n=gcells[d]/comm->dims[d];
+		r=gcells[d]%comm->dims[d];
+		cells[d]=n+(coords[d]<r);
+		offset[d]=coords[d]*n+MIN(coords[d],r);
+	}
+
+}
+
+
+#if USE_MPI
+//Copy of the first and last width cells of each pencil of direction d to the send buffers
+static void pack_halo(t_mesh *mesh, double **field, int d){
+
+	t_comm *comm;
+	int q,k,w,npencils,ncells,width,nvar;
+	int base,stride,fbase,fstride,l,m,n;
+	double *lo,*hi;
+
+	comm=mesh->comm;
+	width=comm->width;
+	nvar=comm->nvar;
+	npencils=pencil_count(mesh,d);
+#pragma omp parallel for default(none) private(k,w,ncells,base,stride,fbase,fstride,l,m,n,lo,hi) shared(mesh,field,comm,d,width,nvar,npencils)
+	for(q=0;q<npencils;q++){
+		ncells=pencil_index(mesh,d,q,&base,&stride,&fbase,&fstride,&l,&m,&n);
+		for(k=0;k<nvar;k++){
+			lo=comm->send[d][0]+(k*npencils+q)*width;
+			hi=comm->send[d][1]+(k*npencils+q)*width;
+			for(w=0;w<width;w++){
+				lo[w]=field[k][base+w*stride];
+				hi[w]=field[k][base+(ncells-width+w)*stride];
+			}
+		}
+	}
+
+}
+#endif
+
+
+//Sends the boundary cells of field and posts the receives of the halos, for every split direction.
+//The halo of the lower boundary comes from the upper cells of the lower neighbour (tag 2d+1) and
+//the halo of the upper boundary from the lower cells of the upper neighbour (tag 2d)
+void halo_exchange_start(t_mesh *mesh, double **field){
+
+#if USE_MPI
+	t_comm *comm;
+	int d,s,count,nbr[2];
+	double t0;
+
+	comm=mesh->comm;
+	PROF_START(t0);
+	for(d=0;d<3;d++){
+		if(comm->dims[d]>1){
+			count=comm->nvar*pencil_count(mesh,d)*comm->width;
+			for(s=0;s<2;s++){
+				nbr[s]=(comm->nbr[d][s]<0 ? MPI_PROC_NULL : comm->nbr[d][s]);
+			}
+			MPI_Irecv(comm->halo[d][0],count,MPI_DOUBLE,nbr[0],2*d+1,comm->cart,&comm->req[d][0]);
+			MPI_Irecv(comm->halo[d][1],count,MPI_DOUBLE,nbr[1],2*d,comm->cart,&comm->req[d][1]);
+			pack_halo(mesh,field,d);
+			MPI_Isend(comm->send[d][0],count,MPI_DOUBLE,nbr[0],2*d,comm->cart,&comm->req[d][2]);
+			MPI_Isend(comm->send[d][1],count,MPI_DOUBLE,nbr[1],2*d+1,comm->cart,&comm->req[d][3]);
+		}
+	}
+	PROF_LAP(mesh->sim,PROF_HALO,t0);
+#endif
+
+}
+
+
+//Lets the MPI library progress the messages in flight. It is called from the sweeps: only the
+//master thread enters MPI
+void halo_exchange_progress(t_mesh *mesh){
+
+#if USE_MPI
+	t_comm *comm;
+	int d,flag;
+
+#ifdef _OPENMP
+	if(omp_get_thread_num()!=0){
+		return;
+	}
+#endif
+	comm=mesh->comm;
+	for(d=0;d<3;d++){
+		if(comm->dims[d]>1){
+			MPI_Testall(4,comm->req[d],&flag,MPI_STATUSES_IGNORE);
+		}
+	}
+#endif
+
+}
+
+
+//Waits for the halo of direction d. It must be called by the master thread
+void halo_exchange_wait(t_mesh *mesh, int d){
+
+#if USE_MPI
+	t_comm *comm;
+	double t0;
+
+	comm=mesh->comm;
+	if(comm->dims[d]>1){
+		PROF_START(t0);
+		MPI_Waitall(4,comm->req[d],MPI_STATUSES_IGNORE);
+		PROF_LAP(mesh->sim,PROF_HALO,t0);
+	}
+#endif
+
+}
+
+
+double comm_max(t_comm *comm, double value){
+
+#if USE_MPI
+	double result;
+
+	MPI_Allreduce(&value,&result,1,MPI_DOUBLE,MPI_MAX,MPI_COMM_WORLD);
+	return result;
+#else
+	return value;
+#endif
+
+}
+
+
+double comm_sum(t_comm *comm, double value){
+
+#if USE_MPI
+	double result;
+
+	MPI_Allreduce(&value,&result,1,MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+	return result;
+#else
+	return value;
+#endif
+
+}
+
+
+//Name of the output file of this rank. With several ranks, the rank is added before the extension
+//(out/state001.vtk is written as out/state001_r0002.vtk by the rank 2). Cell coordinates are global
+void rank_filename(t_comm *comm, const char *filename, char *fname, int size){
+
+	const char *ext;
+
+	if(comm->nranks==1){
+		snprintf(fname,size,"%s",filename);
+		return;
+	}
+	ext=strrchr(filename,'.');
+	if(ext==NULL||strchr(ext,'/')!=NULL){
+		snprintf(fname,size,"%s_r%04d",filename,comm->rank);
+	}else{
+		snprintf(fname,size,"%.*s_r%04d%s",(int)(ext-filename),filename,comm->rank,ext);
+	}
+
+}
@@ -0,0 +1,42 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - mpicomm.h
+
+Content:
+  -This file contains the function prototypes for mpicomm.c. Without USE_MPI (make MPI=1) there
+   is a single rank, the subdomain is the whole grid and the functions do nothing.
+
+*/
+
+
+#ifndef MPICOMM_H
+  #define MPICOMM_H
+
+  #if USE_MPI && ALLOW_SOLIDS
+	#error "Solids (ALLOW_SOLIDS) are not supported with domain decomposition (USE_MPI)"
+  #endif
+
+  t_comm *parallel_init(int *argc, char ***argv);
+  void parallel_finalize(t_comm *comm);
+  void threads_init(t_comm *comm, int nthreads);
+  void threads_unpin(void);
+  void decompose_domain(t_mesh *mesh, t_sim *sim);
+  void rank_block(t_mesh *mesh, int rank, int *offset, int *cells);
+
+  void halo_exchange_start(t_mesh *mesh, double **field);
+  void halo_exchange_progress(t_mesh *mesh);
+  void halo_exchange_wait(t_mesh *mesh, int d);
+
+  double comm_max(t_comm *comm, double value);
+  double comm_sum(t_comm *comm, double value);
+  void rank_filename(t_comm *comm, const char *filename, char *fname, int size);
+
+
+#endif
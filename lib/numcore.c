@@ -27,475 +27,419 @@ Content:
 #include "structures.h"
 #include "numcore.h"
 #include "reconst.h"
-#include "solvers.h"
 #include "closures.h"
 #include "ibmutils.h"
+#include "gridindex.h"
+#include "preproc.h"
+#include "profiler.h"
+#include "mpicomm.h"
 
 
-void update_cell(t_mesh *mesh, t_sim *sim){
-
-	int i,k;
-	t_cell *cell;
+void set_rk_scheme(t_sim *sim){
+	//Coefficients of the Runge-Kutta stages (see t_rkstage_). All the schemes are SSP and use
+	//two registers (U and U_aux). The SSP coefficient scales the time step, so that the CFL
+	//number is always given relative to the forward Euler limit
 
-	cell=mesh->cell;
-	for(i=0;i<mesh->ncells;i++){
-		if(cell->type!=0&&cell->ghost!=1){
-		for(k=0;k<sim->nvar;k++){
-			cell->U[k]-=sim->dt*((cell->w2->fL_star[k]-cell->w4->fR_star[k])/cell->dx + (cell->w3->fL_star[k]-cell->w1->fR_star[k])/cell->dy + (cell->w6->fL_star[k]-cell->w5->fR_star[k])/cell->dz );
-		}
-		//printf("%lf\n",cell->w2->fL_star[5]);
-		if (cell->U[0]<TOL14){
-			printf("celda %d: rHO: %lf \n",i,cell->U[0]);
-		getchar();
-		}
-		}
+	int k,scheme;
+	t_rkstage *rk;
 
-		cell++;
+	scheme=sim->rk_scheme;
+	if(scheme==0){	//Automatic choice depending on the spatial order of accuracy
+		scheme=(sim->order==1 ? 1 : 2);
 	}
-}
 
+	rk=sim->rk;
+	for(k=0;k<MAX_RK_STAGES;k++){
+		rk[k].a=0.0; rk[k].b=1.0; rk[k].c=1.0;
+		rk[k].mix=0;
+		rk[k].d=1.0; rk[k].e=0.0; rk[k].f=0.0; rk[k].g=1.0;
+	}
 
-void update_cellK1(t_mesh *mesh, t_sim *sim){
-
-	int i,k;
-	t_cell *cell;
-
-	//cell=mesh->cell;
-#pragma omp parallel for default(none) private(k,cell) shared(sim,mesh)
-	for(i=0;i<mesh->ncells;i++){
-		cell=&(mesh->cell[i]);
-		if(cell->type!=0&&cell->ghost!=1){
-		for(k=0;k<sim->nvar;k++){
-			cell->U_aux[k]=cell->U[k];
-			cell->U[k]-=sim->dt*((cell->w2->fL_star[k]-cell->w4->fR_star[k])/cell->dx + (cell->w3->fL_star[k]-cell->w1->fR_star[k])/cell->dy + (cell->w6->fL_star[k]-cell->w5->fR_star[k])/cell->dz - cell->S[k]);
+	if(scheme==1){	//Forward Euler
+		sim->rk_steps=1;
+		sim->rk_ssp=1.0;
+		printf("%s Time integration: forward Euler\n",OK);
+	}else if(scheme==2){	//SSPRK(3,3), Shu and Osher
+		sim->rk_steps=3;
+		sim->rk_ssp=1.0;
+		rk[1].a=0.75; rk[1].b=0.25; rk[1].c=0.25;
+		rk[2].a=1.0/3.0; rk[2].b=2.0/3.0; rk[2].c=2.0/3.0;
+		printf("%s Time integration: SSPRK(3,3)\n",OK);
+	}else if(scheme==3){	//SSPRK(4,3), low-storage implementation by Ketcheson (2008)
+		sim->rk_steps=4;
+		sim->rk_ssp=2.0;
+		for(k=0;k<4;k++){
+			rk[k].c=0.5;
 		}
+		rk[2].a=2.0/3.0; rk[2].b=1.0/3.0; rk[2].c=1.0/6.0;
+		printf("%s Time integration: low-storage SSPRK(4,3)\n",OK);
+	}else if(scheme==4){	//SSPRK(10,4), low-storage implementation by Ketcheson (2008)
+		sim->rk_steps=10;
+		sim->rk_ssp=6.0;
+		for(k=0;k<10;k++){
+			rk[k].c=1.0/6.0;
 		}
+		rk[4].mix=1;
+		rk[4].d=1.0/25.0; rk[4].e=9.0/25.0; rk[4].f=15.0; rk[4].g=-5.0;
+		rk[9].a=1.0; rk[9].b=3.0/5.0; rk[9].c=1.0/10.0;
+		printf("%s Time integration: low-storage SSPRK(10,4)\n",OK);
+	}else{
+		printf("%s TimeScheme %d is not available. The program will close when pressing a key. \n",ERR,sim->rk_scheme);
+		getchar();
+		exit(1);
 	}
+
 }
 
 
-void update_cellK2(t_mesh *mesh, t_sim *sim){
+void update_cell(t_mesh *mesh, t_sim *sim){
+	//Forward Euler update of the fluid cells (see build_work_lists() in preproc.c)
 
-	int i,k;
-	t_cell *cell;
+	int a,i,k;
 
-	//cell=mesh->cell;
-#pragma omp parallel for default(none) private(k,cell) shared(sim,mesh)
-	for(i=0;i<mesh->ncells;i++){
-		cell=&(mesh->cell[i]);
-		if(cell->type!=0&&cell->ghost!=1){
+#pragma omp parallel for default(none) private(i,k) shared(sim,mesh) schedule(static)
+	for(a=0;a<mesh->nactive;a++){
+		i=mesh->active[a];
 		for(k=0;k<sim->nvar;k++){
-			cell->U[k]=0.75*cell->U_aux[k]+0.25*cell->U[k]-0.25*sim->dt*((cell->w2->fL_star[k]-cell->w4->fR_star[k])/cell->dx + (cell->w3->fL_star[k]-cell->w1->fR_star[k])/cell->dy + (cell->w6->fL_star[k]-cell->w5->fR_star[k])/cell->dz - cell->S[k]);
-
+			mesh->U[k][i]-=sim->dt*mesh->divF[k][i];
 		}
+		//printf("%lf\n",mesh->divF[5][i]);
+		if (mesh->U[0][i]<TOL14){
+			printf("celda %d: rHO: %lf \n",i,mesh->U[0][i]);
+		getchar();
 		}
 	}
 }
 
 
-void update_cellK3(t_mesh *mesh, t_sim *sim){
+void update_cellK1(t_mesh *mesh, t_sim *sim){
 
-	int i,k;
-	t_cell *cell;
+	int a,i,k;
 
-	//cell=mesh->cell;
-#pragma omp parallel for default(none) private(k,cell) shared(sim,mesh)
-	for(i=0;i<mesh->ncells;i++){
-		cell=&(mesh->cell[i]);
-		if(cell->type!=0&&cell->ghost!=1){
+	//Only the fluid cells are visited (see build_work_lists() in preproc.c)
+#pragma omp parallel for default(none) private(i,k) shared(sim,mesh) schedule(static)
+	for(a=0;a<mesh->nactive;a++){
+		i=mesh->active[a];
 		for(k=0;k<sim->nvar;k++){
-			cell->U[k]=(1.0/3.0)*cell->U_aux[k]+(2.0/3.0)*cell->U[k]-(2.0/3.0)*sim->dt*((cell->w2->fL_star[k]-cell->w4->fR_star[k])/cell->dx + (cell->w3->fL_star[k]-cell->w1->fR_star[k])/cell->dy + (cell->w6->fL_star[k]-cell->w5->fR_star[k])/cell->dz - cell->S[k]);
-
-		}
+			mesh->U_aux[k][i]=mesh->U[k][i];
+			rk_stage_update(&(sim->rk[0]),sim->dt,mesh->divF[k][i],&(mesh->U[k][i]),&(mesh->U_aux[k][i]));
 		}
 	}
 }
 
 
-int equilibrium_reconstruction(t_mesh *mesh, t_sim *sim){
-
-	double phi3[3],phi5[5],phi7[7]; //auxiliar arrays for the weno reconstruction
-	double uL,uR,vL,vR,wL,wR;
-	int order;
-	int n,i,j,k;
-	int st[9]; //local stencil array
-	t_wall *wall;
-	t_cell *cell;
-
-
-#pragma omp parallel for default(none) private(wall,phi3,phi5,phi7,uL,uR,vL,vR,wL,wR,order,i,j,k,st) shared(sim,mesh)
-	for(n=0;n<mesh->nwalls;n++){
-		wall=&(mesh->wall[n]);
-
-            if(wall->wtype!=0){
-
-            //RIGHT RECONSTRUCTION
-            if(wall->nx<TOL4 && wall->nz<TOL4){
-                  //y-wall
-                  order=wall->cellR->st_sizeY;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellR->stY[j];
-                  }
-            }else if (wall->nz<TOL4) {
-                  //x-wall
-                  order=wall->cellR->st_sizeX;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellR->stX[j];
-                  }
-            }else{
-                  //z-wall
-                  order=wall->cellR->st_sizeZ;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellR->stZ[j];
-                  }
-            }
-            if(order==1){
-
-                  for(k=0;k<sim->nvar;k++){
-                        wall->URe[k]=wall->cellR->Ue[k];
-                  }
-
-            }else if(order==3){
-
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi3[i]=mesh->cell[st[i]].Ue[k];
-                        }
-                        wall->URe[k]=weno3R(phi3);
-                  }
-
-            }else if(order==5){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi5[i]=mesh->cell[st[i]].Ue[k];
-                        }
-                        wall->URe[k]=weno5R(phi5);
-                  }
-            }else if(order==7){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi7[i]=mesh->cell[st[i]].Ue[k];
-                        }
-                        wall->URe[k]=weno7R(phi7);
-                  }
-            }else{
-                  //order==9
-            }
-
+t_pencil *allocate_pencil(t_mesh *mesh, t_sim *sim){
+
+	t_pencil *pc;
+	int k,nmax;
+
+	nmax=MAX(mesh->xcells,mesh->ycells);
+	nmax=MAX(nmax,mesh->zcells);
+
+	//The cells -1 and ncells are also stored, for the boundaries of the domain and of the subdomain
+	pc=(t_pencil*)malloc(sizeof(t_pencil));
+	pc->id=(int*)malloc((nmax+2)*sizeof(int))+1;
+	pc->st_size=(int*)malloc((nmax+2)*sizeof(int))+1;
+	pc->U=allocate_field(sim->nvar,nmax+2*PENCIL_HALO);
+	pc->UL=allocate_field(sim->nvar,nmax+2);
+	pc->UR=allocate_field(sim->nvar,nmax+2);
+	pc->FL=allocate_field(sim->nvar,nmax+1);
+	pc->FR=allocate_field(sim->nvar,nmax+1);
+	pc->zf=(double*)malloc((nmax+1)*sizeof(double));
+	for(k=0;k<sim->nvar;k++){
+		pc->U[k]+=PENCIL_HALO; //so that U[k][0] is the first cell of the pencil
+		pc->UL[k]+=1;
+		pc->UR[k]+=1;
+	}
 
+	return pc;
+}
 
-            //LEFT RECONSTRUCTION
-            if(wall->nx<TOL4 && wall->nz<TOL4){
-                  //y-wall
-                  order=wall->cellL->st_sizeY;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellL->stY[j];
-                  }
-            }else if (wall->nz<TOL4) {
-                  //x-wall
-                  order=wall->cellL->st_sizeX;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellL->stX[j];
-                  }
-            }else{
-                  //z-wall
-                  order=wall->cellL->st_sizeZ;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellL->stZ[j];
-                  }
-            }
 
-            if(order==1){
+void free_pencil(t_pencil *pc, t_sim *sim){
 
-                  for(k=0;k<sim->nvar;k++){
-                        wall->ULe[k]=wall->cellL->Ue[k];
-                  }
+	int k;
 
-            }else if(order==3){
+	for(k=0;k<sim->nvar;k++){
+		free(pc->U[k]-PENCIL_HALO);
+		free(pc->UL[k]-1);
+		free(pc->UR[k]-1);
+		free(pc->FL[k]);
+		free(pc->FR[k]);
+	}
+	free(pc->U);
+	free(pc->UL);
+	free(pc->UR);
+	free(pc->FL);
+	free(pc->FR);
+	free(pc->zf);
+	free(pc->st_size-1);
+	free(pc->id-1);
+	free(pc);
+}
 
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi3[i]=mesh->cell[st[i]].Ue[k];
-                        }
-                        wall->ULe[k]=weno3L(phi3);
-                  }
 
-            }else if(order==5){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi5[i]=mesh->cell[st[i]].Ue[k];
-                        }
-                        wall->ULe[k]=weno5L(phi5);
+void fill_ghost_cells(t_mesh *mesh, t_pencil *pc, int nvar, int d, int s){
+	//Ghost cells of the pencil beyond the boundary of the domain at the lower (s=0) or upper (s=1)
+	//end of the direction d, so that the cells near the boundary are reconstructed with the whole
+	//stencil. They depend on the boundary condition: reflective for solid walls (4), where the
+	//normal momentum changes sign, and zero gradient for transmissive (3) and user defined (2)
+	//boundaries. The boundary fluxes are computed afterwards from the inner state
+
+	int k,w,n,in,bc;
+	double sign;
+
+	n=pc->ncells;
+	bc=mesh->bc[boundary_side(d,s)-1];
+	for(k=0;k<nvar;k++){
+		sign=((bc==4 && mesh->sim->eq_system==2 && k==d+1) ? -1.0 : 1.0);
+		for(w=0;w<PENCIL_HALO;w++){
+			in=(bc==4 ? MIN(w,n-1) : 0); //inner cell copied to the w-th ghost cell, counted from the boundary
+			if(s==0){
+				pc->U[k][-1-w]=sign*pc->U[k][in];
+			}else{
+				pc->U[k][n+w]=sign*pc->U[k][n-1-in];
+			}
+		}
+	}
 
-                  }
-            }else if(order==7){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi7[i]=mesh->cell[st[i]].Ue[k];
-                        }
-                        wall->ULe[k]=weno7L(phi7);
-                  }
-            }else{
-                  //order==7
-            }
+}
 
-		uL=wall->ULe[1]/wall->ULe[0];
-		uR=wall->URe[1]/wall->URe[0];
 
-		vL=wall->ULe[2]/wall->ULe[0];
-		vR=wall->URe[2]/wall->URe[0];
+void load_pencil(t_mesh *mesh, t_pencil *pc, double **field, int nvar, int d, int q, int *fbase, int *fstride){
 
-		wL=wall->ULe[3]/wall->ULe[0];
-		wR=wall->URe[3]/wall->URe[0];
+	int p,k,s,w,ncells,base,stride,pw,p0;
+	int width,npencils,gcells,periodic,beyond;
+	t_comm *comm;
+	double *halo;
+#if ALLOW_SOLIDS
+	t_cell *cell;
+#endif
 
-		wall->pLe=pressure_from_energy(_gamma_, wall->ULe[4], uL, vL, wL, wall->ULe[0], wall->z);
-		wall->pRe=pressure_from_energy(_gamma_, wall->URe[4], uR, vR, wR, wall->URe[0], wall->z);
+	ncells=pencil_index(mesh,d,q,&base,&stride,fbase,fstride,&(pc->l),&(pc->m),&(pc->n));
+	pc->ncells=ncells;
+	comm=mesh->comm;
+	gcells=(d==0 ? mesh->gxcells : (d==1 ? mesh->gycells : mesh->gzcells));
+	periodic=(d==0 ? mesh->periodicX : (d==1 ? mesh->periodicY : mesh->periodicZ));
+	pc->order=(gcells<mesh->sim->order ? 1 : mesh->sim->order);
 
+	for(p=0;p<ncells;p++){
+		pc->id[p]=base+p*stride;
 	}
+#if ALLOW_SOLIDS
+	for(p=0;p<ncells;p++){
+		cell=&(mesh->cell[pc->id[p]]);
+		pc->st_size[p]=(d==0 ? cell->st_sizeX : (d==1 ? cell->st_sizeY : cell->st_sizeZ));
+	}
+#endif
 
-      }
-
-#pragma omp parallel for default(none) private(k,cell) shared(mesh)
-	for(i=0;i<mesh->ncells;i++){
-		cell=&(mesh->cell[i]);
-		if(cell->type!=0){
-			cell->S_corr[3] = (cell->w6->pLe-cell->w5->pRe)/cell->dz + _g_*cell->Ue[0];
-			//cell->S_corr[3] = (cell->w6->ULe[4]-cell->w5->URe[4])*(_gamma_-1.0)/cell->dz + _g_*cell->Ue[0]; this is only valid for static equilibrium
+	//Line buffer
+	for(k=0;k<nvar;k++){
+		for(p=0;p<ncells;p++){
+			pc->U[k][p]=field[k][base+p*stride];
 		}
 	}
 
+	//Cells beyond the ends of the pencil. When the direction is periodic and it is not split among
+	//several ranks, the pencil wraps around and the boundary faces take the cell at the other end.
+	//Otherwise, the cells are those of the neighbour subdomain (received by halo_exchange_start())
+	//or ghost cells, and the first of them is also reconstructed, for the flux at the boundary face
+	for(s=0;s<2;s++){
+		p0=(s==0 ? -PENCIL_HALO : ncells);
+		if(comm->nbr[d][s]>=0){
+			width=comm->width;
+			npencils=pencil_count(mesh,d);
+			p0=(s==0 ? -width : ncells);
+			for(k=0;k<nvar;k++){
+				halo=comm->halo[d][s]+(k*npencils+q)*width;
+				for(w=0;w<width;w++){
+					pc->U[k][p0+w]=halo[w];
+				}
+			}
+			beyond=1;
+		}else if(periodic){
+			for(k=0;k<nvar;k++){
+				for(p=p0;p<p0+PENCIL_HALO;p++){
+					pw=((p%ncells)+ncells)%ncells;
+					pc->U[k][p]=pc->U[k][pw];
+				}
+			}
+			beyond=0;
+		}else{
+			fill_ghost_cells(mesh,pc,nvar,d,s);
+			beyond=1;
+		}
+		if(s==0){
+			pc->lo=beyond;
+		}else{
+			pc->hi=beyond;
+		}
+		if(beyond){
+			pc->id[s==0 ? -1 : ncells]=-1;
+		}
+	}
 
-
-	return 1;
 }
 
 
-int compute_fluxes(t_mesh *mesh, t_sim *sim){
+void sweep_equilibrium(t_mesh *mesh, t_sim *sim, t_pencil *pc, int d, int q){
 
-	double phi3[3],phi5[5],phi7[7]; //auxiliar arrays for the weno reconstruction
-	double lambdaMax;
-	int order;
-	int n,i,j,k;
-	int st[9]; //local stencil array
+	double uL,uR,vL,vR,wL,wR;
+	int j,k,f,pL,pR,fbase,fstride,ncells;
+	double *ULe,*URe;
+	t_wall face; //face descriptor, filled for each face
 	t_wall *wall;
 
-	mesh->lambda_max=0.0;
-	lambdaMax=mesh->lambda_max;
-//	wall=mesh->wall;
-#pragma omp parallel for default(none) private(wall,phi3,phi5,phi7,order,i,j,k,st) shared(sim,mesh) reduction(max:lambdaMax)
-	for(n=0;n<mesh->nwalls;n++){
-		wall=&(mesh->wall[n]);
-
-            if(wall->wtype!=0){
-
-            //RIGHT RECONSTRUCTION
-            if(wall->nx<TOL4 && wall->nz<TOL4){
-                  //y-wall
-                  order=wall->cellR->st_sizeY;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellR->stY[j];
-                  }
-            }else if (wall->nz<TOL4) {
-                  //x-wall
-                  order=wall->cellR->st_sizeX;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellR->stX[j];
-                  }
-            }else{
-                  //z-wall
-                  order=wall->cellR->st_sizeZ;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellR->stZ[j];
-                  }
-            }
-            if(order==1){
+	load_pencil(mesh,pc,mesh->Ue,sim->nvar,d,q,&fbase,&fstride);
+	sim->kernels.reconstruct_pencil(pc,sim->nvar,pc->order);
+	ncells=pc->ncells;
 
-                  for(k=0;k<sim->nvar;k++){
-                        wall->UR[k]=wall->cellR->U[k];
-                  }
+	wall=&face;
+	ULe=wall->ULe;
+	URe=wall->URe;
+	wall->z=face_height(mesh,d,pc->n);
 
-            }else if(order==3){
+	for(j=0;j<=ncells;j++){
+		f=fbase+j*fstride;
 
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi3[i]=mesh->cell[st[i]].U[k];
-                        }
-                        wall->UR[k]=weno3R(phi3);
-                  }
+		if(mesh->wtype[d][f]!=0){
 
-            }else if(order==5){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi5[i]=mesh->cell[st[i]].U[k];
-                        }
-                        wall->UR[k]=weno5R(phi5);
-                  }
-            }else if(order==7){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi7[i]=mesh->cell[st[i]].U[k];
-                        }
-                        wall->UR[k]=weno7R(phi7);
-                  }
-            }else{
-                  //order==9
-            }
+		//Left and right cells of the face, within the pencil (or beyond it, see load_pencil())
+		pL=(j==0 ? (pc->lo ? -1 : ncells-1) : j-1);
+		pR=(j==ncells ? (pc->hi ? ncells : 0) : j);
 
+		for(k=0;k<sim->nvar;k++){
+			URe[k]=pc->UR[k][pR];
+			ULe[k]=pc->UL[k][pL];
+		}
 
+		if(d==2){
+			wall->z=face_height(mesh,d,j);
+		}
 
-            //LEFT RECONSTRUCTION
-            if(wall->nx<TOL4 && wall->nz<TOL4){
-                  //y-wall
-                  order=wall->cellL->st_sizeY;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellL->stY[j];
-                  }
-            }else if (wall->nz<TOL4) {
-                  //x-wall
-                  order=wall->cellL->st_sizeX;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellL->stX[j];
-                  }
-            }else{
-                  //z-wall
-                  order=wall->cellL->st_sizeZ;
-                  for(j=0;j<9;j++){
-                        st[j]=wall->cellL->stZ[j];
-                  }
-            }
+		uL=ULe[1]/ULe[0];
+		uR=URe[1]/URe[0];
 
-            if(order==1){
+		vL=ULe[2]/ULe[0];
+		vR=URe[2]/URe[0];
 
-                  for(k=0;k<sim->nvar;k++){
-                        wall->UL[k]=wall->cellL->U[k];
-                  }
+		wL=ULe[3]/ULe[0];
+		wR=URe[3]/URe[0];
 
-            }else if(order==3){
+		wall->pLe=pressure_from_energy(sim->st, _gamma_, ULe[4], uL, vL, wL, ULe[0], wall->z);
+		wall->pRe=pressure_from_energy(sim->st, _gamma_, URe[4], uR, vR, wR, URe[0], wall->z);
 
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi3[i]=mesh->cell[st[i]].U[k];
-                        }
-                        wall->UL[k]=weno3L(phi3);
-                  }
+		//The equilibrium face values are stored, as they are used by the solvers at every step
+		for(k=0;k<sim->nvar;k++){
+			mesh->ULe[d][k][f]=ULe[k];
+			mesh->URe[d][k][f]=URe[k];
+		}
+		mesh->pLe[d][f]=wall->pLe;
+		mesh->pRe[d][f]=wall->pRe;
 
-            }else if(order==5){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi5[i]=mesh->cell[st[i]].U[k];
-                        }
-                        wall->UL[k]=weno5L(phi5);
-                  }
-            }else if(order==7){
-                  for(k=0;k<sim->nvar;k++){
-                        for(i=0;i<order;i++){
-                              phi7[i]=mesh->cell[st[i]].U[k];
-                        }
-                        wall->UL[k]=weno7L(phi7);
-                  }
-            }else{
-                  //order==9
-            }
+		}
+	}
 
+}
 
-            if(wall->wtype==1){
-
-            //This is to compute fn at each edge
-		#if EQUATION_SYSTEM == 2
-			#if SOLVER == 0
-				compute_euler_HLLE(wall,&lambdaMax);
-			#elif SOLVER == 1
-				compute_euler_HLLC(wall,&lambdaMax);
-			#else 
-				compute_euler_HLLS(wall,&lambdaMax,sim);
-			#endif
-		#elif EQUATION_SYSTEM == 1
-                  compute_burgers_flux(wall,&lambdaMax);
-            #else
-                  compute_linear_flux(wall,&lambdaMax);
-            #endif
-
-
-            }else if(wall->wtype==3){
-                  if(wall->boundId==999){
-                        printf("%s boundId has been assigned 999, please check. The program will close when pressing a key. \n",ERR);
-                        getchar();
-                        exit(1);
-                  }
-            #if EQUATION_SYSTEM == 2
-				compute_transmissive_euler(wall,wall->boundId);
-            #elif EQUATION_SYSTEM == 1
-				compute_burgers_flux(wall,&lambdaMax);
-			#else
-				compute_linear_flux(wall,&lambdaMax);
-			#endif
-            }else if(wall->wtype==4){
-                  if(wall->boundId==999){
-                        printf("%s boundId has been assigned 999, please check. The program will close when pressing a key. \n",ERR);
-                        getchar();
-                        exit(1);
-                  }
-            #if EQUATION_SYSTEM == 2
-				compute_solid_euler_hlle(wall,&lambdaMax,wall->boundId);
-            #endif
-            }
-            #if EQUATION_SYSTEM == 2
-		compute_transport(wall);
-            #endif
 
+int equilibrium_reconstruction(t_mesh *mesh, t_sim *sim){
 
-            }
+	int d,q,i,sz;
+	t_pencil *pc;
+	t_cell *cell;
 
+	halo_exchange_start(mesh,mesh->Ue);
+#pragma omp parallel default(none) private(pc,d,q) shared(sim,mesh)
+	{
+	pc=allocate_pencil(mesh,sim);
+	for(d=0;d<3;d++){
+#if USE_MPI
+#pragma omp master
+		halo_exchange_wait(mesh,d);
+#pragma omp barrier
+#endif
+#pragma omp for schedule(static)
+		for(q=0;q<pencil_count(mesh,d);q++){
+			sweep_equilibrium(mesh,sim,pc,d,q);
+		}
+	}
+	free_pencil(pc,sim);
+	}
+
+	sz=mesh->xcells*mesh->ycells;
+#pragma omp parallel for default(none) private(cell) shared(mesh,sz) schedule(static)
+	for(i=0;i<mesh->ncells;i++){
+		cell=&(mesh->cell[i]);
+		if(cell->type!=0){
+			mesh->S_corr[3][i] = (mesh->pLe[2][i+sz]-mesh->pRe[2][i])/cell->dz + _g_*mesh->Ue[0][i];
+			//mesh->S_corr[3][i] = (ULe[4] at the upper face - URe[4] at the lower face)*(_gamma_-1.0)/cell->dz + _g_*mesh->Ue[0][i]; this is only valid for static equilibrium
+		}
 	}
 
-	mesh->lambda_max=lambdaMax;
 
 
 	return 1;
 }
 
 
-void compute_transport(t_wall *wall){
-
-	if(wall->fR_star[0]<TOL14){ //negative transport -> information from right hand side
-		wall->fR_star[5]=wall->fR_star[0]*wall->UR[5]/wall->UR[0];
-		wall->fL_star[5]=wall->fR_star[5];
-	}else{ //positive transport -> information from right hand side
-		wall->fR_star[5]=wall->fL_star[0]*wall->UL[5]/wall->UL[0];
-		wall->fL_star[5]=wall->fR_star[5];
+void update_primitives(t_mesh *mesh, t_sim *sim){
+	//Primitive variables of the cells (mesh->W), from the conserved variables of the current stage.
+	//They are computed once per stage and read by the sweeps of the three directions (REC_VARIABLES 1).
+	//The cells without fluid (rho=0) get zero velocity and pressure
+
+	int i,multicomponent,st;
+	double rho,u,v,w,gamma;
+	double * restrict U0=mesh->U[0];
+	double * restrict U1=mesh->U[1];
+	double * restrict U2=mesh->U[2];
+	double * restrict U3=mesh->U[3];
+	double * restrict U4=mesh->U[4];
+	double * restrict U5=mesh->U[5];
+	double * restrict Wu=mesh->W[PRIM_U];
+	double * restrict Wv=mesh->W[PRIM_V];
+	double * restrict Ww=mesh->W[PRIM_W];
+	double * restrict Wp=mesh->W[PRIM_P];
+
+	multicomponent=sim->multicomponent;
+	st=sim->st;
+
+#pragma omp parallel for simd default(none) private(rho,u,v,w,gamma) shared(mesh,multicomponent,st,U0,U1,U2,U3,U4,U5,Wu,Wv,Ww,Wp) schedule(static)
+	for(i=0;i<mesh->ncells;i++){
+		rho=(U0[i]>0.0 ? U0[i] : 1.0);
+		u=U1[i]/rho;
+		v=U2[i]/rho;
+		w=U3[i]/rho;
+		gamma=mixture_gamma(multicomponent,(U0[i]>0.0 ? U5[i]/rho : 1.0));
+		Wu[i]=u;
+		Wv[i]=v;
+		Ww[i]=w;
+		Wp[i]=pressure_from_energy(st,gamma,U4[i],u,v,w,U0[i],mesh->cell[i].zc);
 	}
 
-
 }
 
 
-void compute_source(t_mesh *mesh){
+int compute_fluxes(t_mesh *mesh, t_sim *sim, int stage){
+	//stage 0: the flux divergence is stored in mesh->divF (forward Euler)
+	//stage 1: the residual (flux divergence minus source term) is stored in mesh->divF
+	//stage k>1: the cells are updated with the k-th Runge-Kutta stage
+	//The kernel specialized for the equations and solver of the run is called (kernels.c)
 
-	int i;
-	t_cell *cell;
+	double t0;
 
-#pragma omp parallel for default(none) private(cell) shared(mesh)
-	for(i=0;i<mesh->ncells;i++){
-		cell=&(mesh->cell[i]);
-		#if ST==1
-		if(cell->type!=0&&cell->st_sizeZ>1){     //This is the implementation of gravity force in -Z direction
-			cell->S[3]= -_g_*cell->U[0] + cell->S_corr[3];
-			cell->S[4]= -_g_*cell->U[3];
-		}
-		#elif ST==2
-		if(cell->type!=0){     //This is the implementation of gravity force in -Z direction
-			cell->S[3]= -_g_*(cell->U[0]-cell->Ue[0]);
-			cell->S[4]= -_g_*cell->U[3];
-		}
-		#else
-		if(cell->type!=0){     //This is the implementation of gravity force in -Z direction
-			cell->S[3]= -_g_*(cell->U[0]-cell->Ue[0]);
-			cell->S[4]= 0.0;
-		}
-		#endif
+	PROF_START(t0);
+	halo_exchange_start(mesh,mesh->U);	//Halos of the neighbour subdomains (USE_MPI)
+	if(sim->rec_vars==1){
+		update_primitives(mesh,sim);
 	}
+	sim->kernels.compute_fluxes(mesh,sim,stage);
+	PROF_LAP(sim,PROF_FLUXES,t0);
+
+	return 1;
 }
 
+
 int update_cell_boundaries(t_mesh *mesh){
 
 	/*
@@ -530,9 +474,10 @@ int update_dt(t_mesh *mesh,t_sim *sim){
 
 	double dl;
 
+	mesh->lambda_max=comm_max(mesh->comm,mesh->lambda_max);	//The time step is the same in all the subdomains
 	dl=MIN(mesh->dx,mesh->dy);
       dl=MIN(dl,mesh->dz);
-	sim->dt=sim->CFL*dl/mesh->lambda_max;
+	sim->dt=sim->rk_ssp*sim->CFL*dl/mesh->lambda_max;
 	if(sim->dt+sim->t>sim->tf){
 		sim->dt=sim->tf-sim->t+TOL14;
 	}
@@ -552,35 +497,38 @@ void mass_calculation(t_mesh *mesh, t_sim *sim){
 #pragma omp parallel for default(none) shared(area,mesh) reduction(+:massAux)
 	for(i=0;i<mesh->ncells;i++){
             if(mesh->cell[i].type!=0){
-                  massAux+=mesh->cell[i].U[0]*area;
+                  massAux+=mesh->U[0][i]*area;
             }
 	}
-	mesh->mass=massAux;
+	mesh->mass=comm_sum(mesh->comm,massAux);
 
 }
 
 void energy_calculation(t_mesh *mesh, t_sim *sim){
 
-#if EQUATION_SYSTEM==2
 	int i;
 	double energyAux;
 	double area;
+	int gravity;
+
+	if(sim->eq_system!=2){
+		mesh->energy=0.0;
+		return;
+	}
+	gravity=(sim->st==1||sim->st==2);
 	area=mesh->dx*mesh->dy*mesh->dz;
 	energyAux=0.0;
-#pragma omp parallel for default(none) shared(area,mesh) reduction(+:energyAux)
+#pragma omp parallel for default(none) shared(area,mesh,gravity) reduction(+:energyAux)
 	for(i=0;i<mesh->ncells;i++){
             if(mesh->cell[i].type!=0){
-			#if ST==0||ST==3
-			energyAux+=mesh->cell[i].U[4]*area;
-			#else
-                  energyAux+=(mesh->cell[i].U[4]+mesh->cell[i].U[0]*_g_*mesh->cell[i].zc)*area;
-			#endif
+			if(gravity){
+                  	energyAux+=(mesh->U[4][i]+mesh->U[0][i]*_g_*mesh->cell[i].zc)*area;
+			}else{
+				energyAux+=mesh->U[4][i]*area;
+			}
             }
 	}
-	mesh->energy=energyAux;
-#else
-	mesh->energy=0.0;
-#endif
+	mesh->energy=comm_sum(mesh->comm,energyAux);
 }
 
 void tke_calculation(t_mesh *mesh, t_sim *sim){
@@ -594,13 +542,15 @@ void tke_calculation(t_mesh *mesh, t_sim *sim){
 	tke_a=0.0;
 	for(i=0;i<mesh->ncells;i++){
             if(mesh->cell[i].type!=0){
-                  u=mesh->cell[i].U[1]/mesh->cell[i].U[0];
-                  v=mesh->cell[i].U[2]/mesh->cell[i].U[0];
-                  w=mesh->cell[i].U[3]/mesh->cell[i].U[0];
-                  tke_a+=0.5*mesh->cell[i].U[0]*(u*u + v*v + w*w)*volume;
+                  u=mesh->U[1][i]/mesh->U[0][i];
+                  v=mesh->U[2][i]/mesh->U[0][i];
+                  w=mesh->U[3][i]/mesh->U[0][i];
+                  tke_a+=0.5*mesh->U[0][i]*(u*u + v*v + w*w)*volume;
 				  volumeT+=volume;
             }
 	}
+	tke_a=comm_sum(mesh->comm,tke_a);
+	volumeT=comm_sum(mesh->comm,volumeT);
 	mesh->tke=tke_a/volumeT; //average TKE in the domain
 
 }
@@ -610,45 +560,37 @@ void tke_calculation(t_mesh *mesh, t_sim *sim){
 void update_solution(t_mesh *mesh, t_sim *sim, t_solid *solids, int rk_steps){
 
 	int k;
+	double t0;
 
 	for(k=1;k<=rk_steps;k++){
 		if(k==1){
-			compute_fluxes(mesh,sim);
-			#if ST!=0&&EQUATION_SYSTEM==2
-				compute_source(mesh);
-			#endif
-			update_dt(mesh,sim);
+			//The time step depends on the fluxes of the whole mesh, so the residual is stored
+			//and the cells are updated afterwards
 			if(rk_steps==1){
+				compute_fluxes(mesh,sim,0);
+				PROF_START(t0);
+				update_dt(mesh,sim);
+				PROF_LAP(sim,PROF_DT,t0);
 				update_cell(mesh,sim);
-				#if ALLOW_SOLIDS
-					update_ghost_cells(sim,mesh,solids);
-				#endif
+				PROF_LAP(sim,PROF_UPDATE,t0);
 			}else{
+				compute_fluxes(mesh,sim,1);
+				PROF_START(t0);
+				update_dt(mesh,sim);
+				PROF_LAP(sim,PROF_DT,t0);
 				update_cellK1(mesh,sim);
-				#if ALLOW_SOLIDS
-					update_ghost_cells(sim,mesh,solids);
-				#endif                               
+				PROF_LAP(sim,PROF_UPDATE,t0);
 			}
-
-		}else if(k==2){
-			compute_fluxes(mesh,sim);
-			#if ST!=0&&EQUATION_SYSTEM==2
-				compute_source(mesh);
-			#endif
-			update_cellK2(mesh,sim);
-			#if ALLOW_SOLIDS
-				update_ghost_cells(sim,mesh,solids);
-			#endif   				
-		}else{ //k=3
-			compute_fluxes(mesh,sim);
-			#if ST!=0&&EQUATION_SYSTEM==2
-				compute_source(mesh);
-			#endif
-			update_cellK3(mesh,sim);
-			#if ALLOW_SOLIDS
-				update_ghost_cells(sim,mesh,solids);
-			#endif     
+		}else{
+			//The flux divergence, the source term and the RK combination of the stage
+			//are computed in a single pass (in the z-sweep of compute_fluxes)
+			compute_fluxes(mesh,sim,k);
 		}
+		#if ALLOW_SOLIDS
+			PROF_START(t0);
+			update_ghost_cells(sim,mesh,solids);
+			PROF_LAP(sim,PROF_GHOST,t0);
+		#endif
 	}
 
 }
@@ -10,7 +10,7 @@ File:
   - numcore.h
 
 Content:
-  -This file contains all the function prototypes for numcore.c
+  -This file contains all the function prototypes for numcore.c and the update of the Runge-Kutta stages
   
 */
 
@@ -18,15 +18,18 @@ Content:
 #ifndef NUMCORE_H
   #define NUMCORE_H
 
+  void set_rk_scheme(t_sim *sim);
   void update_cell(t_mesh *mesh, t_sim *sim);
   void update_cellK1(t_mesh *mesh, t_sim *sim);
-  void update_cellK2(t_mesh *mesh, t_sim *sim);
-  void update_cellK3(t_mesh *mesh, t_sim *sim);
 
+  t_pencil *allocate_pencil(t_mesh *mesh, t_sim *sim);
+  void free_pencil(t_pencil *pc, t_sim *sim);
+  void fill_ghost_cells(t_mesh *mesh, t_pencil *pc, int nvar, int d, int s);
+  void load_pencil(t_mesh *mesh, t_pencil *pc, double **field, int nvar, int d, int q, int *fbase, int *fstride);
+  void sweep_equilibrium(t_mesh *mesh, t_sim *sim, t_pencil *pc, int d, int q);
   int equilibrium_reconstruction(t_mesh *mesh, t_sim *sim);
-  int compute_fluxes(t_mesh *mesh, t_sim *sim);
-  void compute_transport(t_wall *wall);
-  void compute_source(t_mesh *mesh);
+  void update_primitives(t_mesh *mesh, t_sim *sim);
+  int compute_fluxes(t_mesh *mesh, t_sim *sim, int stage);
 
   int update_cell_boundaries(t_mesh *mesh);
   int update_dt(t_mesh *mesh,t_sim *sim);
@@ -37,6 +40,23 @@ Content:
   
   void update_solution(t_mesh *mesh, t_sim *sim, t_solid *solids, int rk_steps);
 
+  //Update of a single value with the Runge-Kutta stage rk (see t_rkstage_). R is the residual
+  static inline void rk_stage_update(const t_rkstage *rk, double dt, double R, double *u, double *uaux){
+	double x;
+
+	if(rk->a==0.0){
+		x=rk->b*(*u)-rk->c*dt*R;
+	}else{
+		x=rk->a*(*uaux)+rk->b*(*u)-rk->c*dt*R;
+	}
+	if(rk->mix){
+		*uaux=rk->d*(*uaux)+rk->e*x;
+		*u=rk->f*(*uaux)+rk->g*x;
+	}else{
+		*u=x;
+	}
+  }
+
 
 #endif
 
@@ -0,0 +1,224 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - output.c
+
+Content:
+  -This file contains the output stage of the time loop. With ASYNC_OUTPUT, the state is copied
+   at each dump to a snapshot of a bounded queue, and a writer thread writes the VTK and .out
+   files from the snapshot while the computation continues. The writer thread runs the loops of
+   the writers with a single OpenMP thread and makes no MPI calls. Without ASYNC_OUTPUT, the
+   files are written directly.
+
+*/
+
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "definitions.h"
+#include "structures.h"
+#include "output.h"
+#include "postproc.h"
+#include "preproc.h"
+#include "profiler.h"
+#include "mpicomm.h"
+
+
+#if ASYNC_OUTPUT
+//Writes the files of a snapshot, accumulating the time spent in each writer
+static void write_snapshot(t_output *out, t_snapshot *snap){
+
+	double t0,t1;
+
+	t0=prof_time();
+	if(snap->vtkfile[0]!='\0'){
+		write_vtk(snap->mesh,snap->vtkfile);
+	}
+	t1=prof_time();
+	out->time_vtk+=t1-t0;
+	if(snap->listfile[0]!='\0'){
+		write_list(snap->mesh,snap->listfile);
+	}
+	out->time_list+=prof_time()-t1;
+
+}
+
+
+//Writer thread: writes the snapshots in the order they are queued, until output_finalize()
+static void *writer_thread(void *arg){
+
+	t_output *out;
+	t_snapshot *snap;
+
+	out=(t_output*)arg;
+	threads_unpin(); //not on the CPU of the master thread (see threads_init())
+#ifdef _OPENMP
+	omp_set_num_threads(1); //the OpenMP threads are left to the computation
+#endif
+
+	pthread_mutex_lock(&out->lock);
+	while(1){
+		while(out->count==0&&out->stop==0){
+			pthread_cond_wait(&out->ready,&out->lock);
+		}
+		if(out->count==0){
+			break;
+		}
+		snap=&(out->slot[out->head]);
+		pthread_mutex_unlock(&out->lock);
+
+		write_snapshot(out,snap);
+
+		pthread_mutex_lock(&out->lock);
+		out->head=(out->head+1)%out->nslots;
+		out->count--;
+		pthread_cond_signal(&out->free);
+	}
+	pthread_mutex_unlock(&out->lock);
+
+	return NULL;
+}
+#endif
+
+
+t_output *output_init(t_mesh *mesh, t_sim *sim){
+
+	t_output *out;
+#if ASYNC_OUTPUT
+	int i;
+#endif
+
+	out=(t_output*)malloc(sizeof(t_output));
+	out->nslots=0;
+	out->nvar=sim->nvar;
+	out->slot=NULL;
+	out->head=0;
+	out->count=0;
+	out->stop=0;
+	out->time_vtk=0.0;
+	out->time_list=0.0;
+
+#if ASYNC_OUTPUT
+	out->nslots=OUTPUT_QUEUE;
+	out->slot=(t_snapshot*)malloc(out->nslots*sizeof(t_snapshot));
+	for(i=0;i<out->nslots;i++){
+		out->slot[i].U=allocate_field(out->nvar,mesh->ncells);
+		out->slot[i].mesh=(t_mesh*)malloc(sizeof(t_mesh));
+	}
+	pthread_mutex_init(&out->lock,NULL);
+	pthread_cond_init(&out->ready,NULL);
+	pthread_cond_init(&out->free,NULL);
+	if(pthread_create(&out->thread,NULL,writer_thread,out)!=0){
+		printf("%s The writer thread could not be created. The program will close when pressing a key.\n",ERR);
+		getchar();
+		exit(1);
+	}
+	printf("%s The output files are written by a background thread (%d snapshots, %.1lf MB)\n",
+		OK,out->nslots,out->nslots*out->nvar*(double)mesh->ncells*sizeof(double)/1048576.0);
+#endif
+
+	return out;
+}
+
+
+//Writes the current state in vtkfile and listfile (an empty name skips the file). With ASYNC_OUTPUT,
+//the state is copied to a free snapshot, waiting for the writer if there is none, and the files are
+//written later by the writer thread
+void output_submit(t_output *out, t_mesh *mesh, char *vtkfile, char *listfile){
+
+	double t0;
+#if ASYNC_OUTPUT
+	t_snapshot *snap;
+	int i,k,slot,nvar,ncells;
+
+	PROF_START(t0);
+	pthread_mutex_lock(&out->lock);
+	while(out->count==out->nslots){
+		pthread_cond_wait(&out->free,&out->lock);
+	}
+	slot=(out->head+out->count)%out->nslots;
+	pthread_mutex_unlock(&out->lock);
+
+	//The slot is not used by the writer until it is queued
+	snap=&(out->slot[slot]);
+	nvar=out->nvar;
+	ncells=mesh->ncells;
+#pragma omp parallel default(none) private(k) shared(snap,mesh,nvar,ncells)
+	{
+	for(k=0;k<nvar;k++){
+#pragma omp for schedule(static) nowait
+		for(i=0;i<ncells;i++){
+			snap->U[k][i]=mesh->U[k][i];
+		}
+	}
+	}
+	*(snap->mesh)=*mesh;
+	snap->mesh->U=snap->U;
+	snprintf(snap->vtkfile,sizeof(snap->vtkfile),"%s",vtkfile);
+	snprintf(snap->listfile,sizeof(snap->listfile),"%s",listfile);
+
+	pthread_mutex_lock(&out->lock);
+	out->count++;
+	pthread_cond_signal(&out->ready);
+	pthread_mutex_unlock(&out->lock);
+	PROF_LAP(mesh->sim,PROF_OUTPUT,t0);
+#else
+	PROF_START(t0);
+	if(vtkfile[0]!='\0'){
+		write_vtk(mesh,vtkfile);
+		PROF_LAP(mesh->sim,PROF_WRITE_VTK,t0);
+	}
+	if(listfile[0]!='\0'){
+		write_list(mesh,listfile);
+		PROF_LAP(mesh->sim,PROF_WRITE_LIST,t0);
+	}
+#endif
+
+}
+
+
+//Waits until all the snapshots are written and stops the writer thread. The time spent by the
+//writer is added to the write_vtk and write_list phases of the profiler
+void output_finalize(t_output *out, t_sim *sim){
+
+#if ASYNC_OUTPUT
+	double t0;
+	int i,k;
+
+	PROF_START(t0);
+	pthread_mutex_lock(&out->lock);
+	out->stop=1;
+	pthread_cond_signal(&out->ready);
+	pthread_mutex_unlock(&out->lock);
+	pthread_join(out->thread,NULL);
+	PROF_LAP(sim,PROF_OUTPUT,t0);
+#if PROFILE
+	sim->prof.time[PROF_WRITE_VTK]+=out->time_vtk;
+	sim->prof.time[PROF_WRITE_LIST]+=out->time_list;
+#endif
+
+	pthread_mutex_destroy(&out->lock);
+	pthread_cond_destroy(&out->ready);
+	pthread_cond_destroy(&out->free);
+	for(i=0;i<out->nslots;i++){
+		for(k=0;k<out->nvar;k++){
+			free(out->slot[i].U[k]);
+		}
+		free(out->slot[i].U);
+		free(out->slot[i].mesh);
+	}
+	free(out->slot);
+#endif
+	free(out);
+
+}
@@ -0,0 +1,25 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - output.h
+
+Content:
+  -This file contains the function prototypes for output.c
+
+*/
+
+
+#ifndef OUTPUT_H
+  #define OUTPUT_H
+
+  t_output *output_init(t_mesh *mesh, t_sim *sim);
+  void output_submit(t_output *out, t_mesh *mesh, char *vtkfile, char *listfile);
+  void output_finalize(t_output *out, t_sim *sim);
+
+#endif
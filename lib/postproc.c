@@ -10,7 +10,8 @@ File:
   - postproc.c
 
 Content:
-  -This file contains all the post-processing utilities
+  -This file contains all the post-processing utilities. The VTK files are written in the legacy
+   ASCII format (unstructured grid) or in the XML format (image data, see write_vti())
   
 */
 
@@ -21,7 +22,11 @@ Content:
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <omp.h>
+#if USE_ZLIB
+#include <zlib.h>
+#endif
 
 
 #include "definitions.h"
@@ -29,17 +34,312 @@ Content:
 #include "postproc.h"
 #include "closures.h"
 #include "numcore.h"
+#include "gridindex.h"
+#include "profiler.h"
+#include "mpicomm.h"
+
+
+//Fields of the XML VTK files. They are the same as in the legacy files, with the same names. The last
+//ones are those of the geometry file (write_geo_vtk())
+enum{VTK_RHO,VTK_PRES,VTK_DPRES,VTK_U,VTK_V,VTK_W,VTK_E,VTK_PHI,VTK_THETA,VTK_SCALAR,VTK_STX,VTK_STY,VTK_STZ,VTK_CELLTYPE,VTK_GHOST,VTK_NFIELDS};
+static const char *vtk_field_name[VTK_NFIELDS]={"rho","pres","d_pres","U","V","W","E","phi","theta","U","stX","stY","stZ","cellType","ghostCell"};
+
+//Size in bytes of the blocks compressed with zlib (each one is compressed by a thread)
+#define VTK_BLOCK 1048576
+
+//Width reserved for the offset attributes of the data arrays, which are written when the sizes are known
+#define VTK_OFFSET_WIDTH 32
+
+
+//Fields written according to the print_* options. Returns the number of fields
+static int vtk_fields(t_sim *sim, int *field){
+
+	int n;
+
+	n=0;
+	if(sim->eq_system==2){
+		if(sim->print_rho) field[n++]=VTK_RHO;
+		if(sim->print_pressure) field[n++]=VTK_PRES;
+		if(sim->print_overpressure) field[n++]=VTK_DPRES;
+		if(sim->print_velocity){
+			field[n++]=VTK_U;
+			field[n++]=VTK_V;
+			field[n++]=VTK_W;
+		}
+		if(sim->print_energy) field[n++]=VTK_E;
+		if(sim->print_solutes) field[n++]=VTK_PHI;
+		if(sim->print_potentialtem) field[n++]=VTK_THETA;
+	}else{
+		field[n++]=VTK_SCALAR;
+	}
+
+	return n;
+}
+
+
+//Values of a field in the cells of the mesh. pres is the pressure (Euler equations)
+static void vtk_field_values(t_mesh *mesh, int field, double *pres, double *val){
+
+	int j;
+
+#pragma omp parallel for default(none) shared(mesh,field,pres,val)
+	for(j=0;j<mesh->ncells;j++){
+		switch(field){
+			case VTK_PRES: val[j]=pres[j]; break;
+			case VTK_DPRES: val[j]=pres[j]-mesh->prese[j]; break;
+			case VTK_U: val[j]=mesh->U[1][j]/mesh->U[0][j]; break;
+			case VTK_V: val[j]=mesh->U[2][j]/mesh->U[0][j]; break;
+			case VTK_W: val[j]=mesh->U[3][j]/mesh->U[0][j]; break;
+			case VTK_E: val[j]=mesh->U[4][j]; break;
+			case VTK_PHI: val[j]=mesh->U[5][j]; break;
+			case VTK_THETA: val[j]=pres[j]/(_R_*mesh->U[0][j])/( pow((pres[j]/_p0_),((_gamma_-1.0)/_gamma_)) ); break;
+			case VTK_STX: val[j]=mesh->cell[j].st_sizeX; break;
+			case VTK_STY: val[j]=mesh->cell[j].st_sizeY; break;
+			case VTK_STZ: val[j]=mesh->cell[j].st_sizeZ; break;
+			case VTK_CELLTYPE: val[j]=mesh->cell[j].type; break;
+			case VTK_GHOST: val[j]=mesh->cell[j].ghost; break;
+			default: val[j]=mesh->U[0][j]; //rho or the scalar variable
+		}
+	}
+
+}
+
+
+//Writes n values in the appended data of a .vti file: the size in bytes followed by the raw data or,
+//with zlib, the header of the compressed blocks followed by the blocks. Returns the number of bytes written
+static long vtk_append(FILE *fp, double *val, long n){
+
+	uint64_t nbytes;
+#if USE_ZLIB
+	uint64_t *header;
+	unsigned char *cbuf;
+	long b,nblocks,bound,total;
+	int err;
+
+	nbytes=n*sizeof(double);
+	nblocks=(nbytes+VTK_BLOCK-1)/VTK_BLOCK;
+	bound=compressBound(VTK_BLOCK);
+	header=(uint64_t*)malloc((3+nblocks)*sizeof(uint64_t));
+	cbuf=(unsigned char*)malloc(nblocks*bound);
+	header[0]=nblocks;
+	header[1]=VTK_BLOCK;
+	header[2]=nbytes-(nblocks-1)*VTK_BLOCK; //size of the last block
+	err=0;
+#pragma omp parallel for default(none) shared(val,header,cbuf,nblocks,bound) reduction(|:err)
+	for(b=0;b<nblocks;b++){
+		uLongf csize;
+		csize=bound;
+		if(compress2(cbuf+b*bound,&csize,(const Bytef*)val+b*VTK_BLOCK,(b==nblocks-1 ? header[2] : VTK_BLOCK),VTK_ZLIB_LEVEL)!=Z_OK){
+			err=1;
+		}
+		header[3+b]=csize;
+	}
+	if(err){
+		printf("%s The data of the VTK file could not be compressed\n",ERR);
+	}
+	fwrite(header,sizeof(uint64_t),3+nblocks,fp);
+	total=(3+nblocks)*sizeof(uint64_t);
+	for(b=0;b<nblocks;b++){
+		fwrite(cbuf+b*bound,1,header[3+b],fp);
+		total+=header[3+b];
+	}
+	free(header);
+	free(cbuf);
+
+	return total;
+#else
+	nbytes=n*sizeof(double);
+	fwrite(&nbytes,sizeof(uint64_t),1,fp);
+	fwrite(val,sizeof(double),n,fp);
+
+	return sizeof(uint64_t)+nbytes;
+#endif
+}
+
+
+//Common attributes of the VTKFile element
+static void vtk_file_attributes(FILE *fp){
+
+	int one;
+
+	one=1;
+	fprintf(fp," version=\"1.0\" byte_order=\"%s\" header_type=\"UInt64\"",(*(char*)&one==1 ? "LittleEndian" : "BigEndian"));
+#if USE_ZLIB
+	fprintf(fp," compressor=\"vtkZLibDataCompressor\"");
+#endif
+
+}
+
+
+//filename with its extension replaced by ext
+static void replace_extension(const char *filename, const char *ext, char *fname, int size){
+
+	const char *dot;
+
+	dot=strrchr(filename,'.');
+	if(dot==NULL||strchr(dot,'/')!=NULL){
+		snprintf(fname,size,"%s%s",filename,ext);
+	}else{
+		snprintf(fname,size,"%.*s%s",(int)(dot-filename),filename,ext);
+	}
+
+}
+
+
+//Index file of the pieces written by the ranks (.pvti). It is written by the first rank
+static void write_pvti(t_mesh *mesh, const char *filename, int *field, int nfields){
+
+	FILE *fp;
+	char fname[1024],piece[1000];
+	const char *source;
+	int r,f,offset[3],cells[3];
+
+	replace_extension(filename,".pvti",fname,sizeof(fname));
+	fp=fopen(fname,"w");
+	if(fp==NULL){
+		printf("%s The VTK file %s could not be written\n",WAR,fname);
+		return;
+	}
+	fprintf(fp,"<?xml version=\"1.0\"?>\n");
+	fprintf(fp,"<VTKFile type=\"PImageData\"");
+	vtk_file_attributes(fp);
+	fprintf(fp,">\n");
+	fprintf(fp,"  <PImageData WholeExtent=\"0 %d 0 %d 0 %d\" GhostLevel=\"0\" Origin=\"0 0 0\" Spacing=\"%.14e %.14e %.14e\">\n",
+		mesh->gxcells,mesh->gycells,mesh->gzcells,mesh->dx,mesh->dy,mesh->dz);
+	fprintf(fp,"    <PCellData>\n");
+	for(f=0;f<nfields;f++){
+		fprintf(fp,"      <PDataArray type=\"Float64\" Name=\"%s\"/>\n",vtk_field_name[field[f]]);
+	}
+	fprintf(fp,"    </PCellData>\n");
+	for(r=0;r<mesh->comm->nranks;r++){
+		rank_block(mesh,r,offset,cells);
+		replace_extension(filename,"",piece,sizeof(piece));
+		snprintf(fname,sizeof(fname),"%s_r%04d.vti",piece,r);
+		source=strrchr(fname,'/');
+		source=(source==NULL ? fname : source+1); //relative to the .pvti file
+		fprintf(fp,"    <Piece Extent=\"%d %d %d %d %d %d\" Source=\"%s\"/>\n",
+			offset[0],offset[0]+cells[0],offset[1],offset[1]+cells[1],offset[2],offset[2]+cells[2],source);
+	}
+	fprintf(fp,"  </PImageData>\n");
+	fprintf(fp,"</VTKFile>\n");
+	fclose(fp);
+
+}
+
+
+//VTK file in XML format, as image data: only the origin and the cell size are written, and the
+//fields are stored as appended binary data (compressed with USE_ZLIB). The extension of filename
+//is replaced by .vti. With several ranks, each one writes its piece and the first rank writes the
+//.pvti file that gathers them
+static int write_vti_fields(t_mesh *mesh, const char *filename, int *field, int nfields){
+
+	int j,f,needpres;
+	long offset[VTK_NFIELDS],pos[VTK_NFIELDS],total;
+	double gamma,u,v,w;
+	double *pres,*val;
+	t_sim *sim;
+	FILE *fp;
+	char vtiname[1024],fname[1024],attr[VTK_OFFSET_WIDTH+1];
+
+	sim=mesh->sim;
+	replace_extension(filename,".vti",vtiname,sizeof(vtiname));
+	rank_filename(mesh->comm,vtiname,fname,sizeof(fname));
+	fp=fopen(fname,"wb");
+	if(fp==NULL){
+		printf("%s The VTK file %s could not be written\n",WAR,fname);
+		return 0;
+	}
+
+	fprintf(fp,"<?xml version=\"1.0\"?>\n");
+	fprintf(fp,"<VTKFile type=\"ImageData\"");
+	vtk_file_attributes(fp);
+	fprintf(fp,">\n");
+	fprintf(fp,"  <ImageData WholeExtent=\"0 %d 0 %d 0 %d\" Origin=\"0 0 0\" Spacing=\"%.14e %.14e %.14e\">\n",
+		mesh->gxcells,mesh->gycells,mesh->gzcells,mesh->dx,mesh->dy,mesh->dz);
+	fprintf(fp,"    <Piece Extent=\"%d %d %d %d %d %d\">\n",
+		mesh->offset[0],mesh->offset[0]+mesh->xcells,mesh->offset[1],mesh->offset[1]+mesh->ycells,mesh->offset[2],mesh->offset[2]+mesh->zcells);
+	fprintf(fp,"      <CellData>\n");
+	for(f=0;f<nfields;f++){
+		fprintf(fp,"        <DataArray type=\"Float64\" Name=\"%s\" format=\"appended\" ",vtk_field_name[field[f]]);
+		pos[f]=ftell(fp);
+		fprintf(fp,"%-*s/>\n",VTK_OFFSET_WIDTH,"offset=\"0\"");
+	}
+	fprintf(fp,"      </CellData>\n");
+	fprintf(fp,"    </Piece>\n");
+	fprintf(fp,"  </ImageData>\n");
+	fprintf(fp,"  <AppendedData encoding=\"raw\">\n   _");
+
+	needpres=0;
+	for(f=0;f<nfields;f++){
+		needpres|=(field[f]==VTK_PRES||field[f]==VTK_DPRES||field[f]==VTK_THETA);
+	}
+	pres=NULL;
+	if(sim->eq_system==2&&needpres){
+		pres=(double*)malloc(mesh->ncells*sizeof(double));
+#pragma omp parallel for default(none) private(gamma,u,v,w) shared(mesh,sim,pres)
+		for(j=0;j<mesh->ncells;j++){
+			gamma=mixture_gamma(sim->multicomponent,mesh->U[5][j]/mesh->U[0][j]);
+			u=mesh->U[1][j]/mesh->U[0][j];
+			v=mesh->U[2][j]/mesh->U[0][j];
+			w=mesh->U[3][j]/mesh->U[0][j];
+			pres[j]=pressure_from_energy(sim->st, gamma, mesh->U[4][j], u, v, w, mesh->U[0][j], mesh->cell[j].zc);
+		}
+	}
+	val=(double*)malloc(mesh->ncells*sizeof(double));
+	total=0;
+	for(f=0;f<nfields;f++){
+		vtk_field_values(mesh,field[f],pres,val);
+		offset[f]=total;
+		total+=vtk_append(fp,val,mesh->ncells);
+	}
+	free(val);
+	free(pres);
+	fprintf(fp,"\n  </AppendedData>\n");
+	fprintf(fp,"</VTKFile>\n");
+
+	//Offsets of the data arrays
+	for(f=0;f<nfields;f++){
+		snprintf(attr,sizeof(attr),"offset=\"%ld\"",offset[f]);
+		fseek(fp,pos[f],SEEK_SET);
+		fprintf(fp,"%-*s",VTK_OFFSET_WIDTH,attr);
+	}
+	fclose(fp);
+
+	if(mesh->comm->nranks>1&&mesh->comm->rank==0){
+		write_pvti(mesh,filename,field,nfields);
+	}
+	printf("%s A VTK has been written: %s\n",OK,fname);
+
+	return 1;
+}
+
+
+int write_vti(t_mesh *mesh, char *filename){
+
+	int nfields,field[VTK_NFIELDS];
+
+	nfields=vtk_fields(mesh->sim,field);
+
+	return write_vti_fields(mesh,filename,field,nfields);
+}
 
 
 int write_vtk(t_mesh *mesh, char *filename){
 
 
-	int i,j;
+	int i,j,l,m,n;
 	FILE *fp;
-#if EQUATION_SYSTEM == 2 
 	double gamma,theta,u,v,w;
-#endif
-	fp=fopen(filename,"w");
+	double *pres;
+	t_sim *sim;
+	char fname[1024];
+
+	sim=mesh->sim;
+	if(sim->vtk_format==1){
+		return write_vti(mesh,filename);
+	}
+	rank_filename(mesh->comm,filename,fname,sizeof(fname));
+	fp=fopen(fname,"w");
 
 	// Write file header
 	fprintf(fp,"# vtk DataFile Version 2.0\n");
@@ -49,14 +349,22 @@ int write_vtk(t_mesh *mesh, char *filename){
 
 	// Write node coordinates
 	fprintf(fp,"POINTS %d double \n",mesh->nnodes);
-	for (i=0;i<mesh->nnodes;i++){
-	   fprintf(fp,"%lf %lf %lf\n", mesh->node[i].x, mesh->node[i].y, mesh->node[i].z);
+	for (n=0;n<mesh->zcells+1;n++){
+		for (m=0;m<mesh->ycells+1;m++){
+			for (l=0;l<mesh->xcells+1;l++){
+				fprintf(fp,"%lf %lf %lf\n", (l+mesh->offset[0])*mesh->dx, (m+mesh->offset[1])*mesh->dy, (n+mesh->offset[2])*mesh->dz);
+			}
+		}
 	}
 
 	//Write cell-node connectivity
 	fprintf(fp,"CELLS %d %d \n",mesh->ncells,mesh->ncells*(8+1));
 	for(i=0;i<mesh->ncells;i++){
-		fprintf(fp,"8 %d %d %d %d %d %d %d %d\n",mesh->cell[i].n1,mesh->cell[i].n2,mesh->cell[i].n3,mesh->cell[i].n4,mesh->cell[i].n5,mesh->cell[i].n6,mesh->cell[i].n7,mesh->cell[i].n8);
+		l=mesh->cell[i].l;
+		m=mesh->cell[i].m;
+		n=mesh->cell[i].n;
+		fprintf(fp,"8 %d %d %d %d %d %d %d %d\n",node_id(mesh,l,m,n),node_id(mesh,l+1,m,n),node_id(mesh,l+1,m+1,n),node_id(mesh,l,m+1,n),
+			node_id(mesh,l,m,n+1),node_id(mesh,l+1,m,n+1),node_id(mesh,l+1,m+1,n+1),node_id(mesh,l,m+1,n+1));
 	}
 	////////////////////////////////////////////////////
 	////////////// C O N E C T I V I T Y ///////////////
@@ -72,103 +380,97 @@ int write_vtk(t_mesh *mesh, char *filename){
 	fprintf(fp,"CELL_DATA %d \n",mesh->ncells);
 
 
-#if EQUATION_SYSTEM == 2 
-      #if print_RHO
+	if(sim->eq_system == 2){
+      if(sim->print_rho){
 	fprintf(fp,"SCALARS rho DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e\n",mesh->cell[j].U[0]);
+	   	fprintf(fp,"%14.14e\n",mesh->U[0][j]);
 	}
-      #endif
+      }
 
+	pres=(double*)malloc(mesh->ncells*sizeof(double));
 	for(j=0;j<mesh->ncells;j++){
-		#if MULTICOMPONENT
-			#if MULTI_TYPE==1
-				gamma=mesh->cell[j].U[5]/mesh->cell[j].U[0];
-			#else
-				gamma=1.0+1.0/(mesh->cell[j].U[5]/mesh->cell[j].U[0]);
-			#endif
-		#else
-			gamma=_gamma_;
-		#endif
-		u=mesh->cell[j].U[1]/mesh->cell[j].U[0];
-		v=mesh->cell[j].U[2]/mesh->cell[j].U[0];
-		w=mesh->cell[j].U[3]/mesh->cell[j].U[0];
-            mesh->cell[j].pres=pressure_from_energy(gamma, mesh->cell[j].U[4], u, v, w, mesh->cell[j].U[0], mesh->cell[j].zc);
-		//mesh->cell[j].pres=(gamma-1.0)*(mesh->cell[j].U[4]-0.5*mesh->cell[j].U[0]*(mesh->cell[j].U[1]*mesh->cell[j].U[1]+mesh->cell[j].U[2]*mesh->cell[j].U[2]+mesh->cell[j].U[3]*mesh->cell[j].U[3])/(mesh->cell[j].U[0]*mesh->cell[j].U[0]));
+		gamma=mixture_gamma(sim->multicomponent,mesh->U[5][j]/mesh->U[0][j]);
+		u=mesh->U[1][j]/mesh->U[0][j];
+		v=mesh->U[2][j]/mesh->U[0][j];
+		w=mesh->U[3][j]/mesh->U[0][j];
+            pres[j]=pressure_from_energy(sim->st, gamma, mesh->U[4][j], u, v, w, mesh->U[0][j], mesh->cell[j].zc);
+		//pres[j]=(gamma-1.0)*(mesh->U[4][j]-0.5*mesh->U[0][j]*(mesh->U[1][j]*mesh->U[1][j]+mesh->U[2][j]*mesh->U[2][j]+mesh->U[3][j]*mesh->U[3][j])/(mesh->U[0][j]*mesh->U[0][j]));
       }
-      #if print_PRESSURE
+      if(sim->print_pressure){
 	fprintf(fp,"SCALARS pres DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
       for(j=0;j<mesh->ncells;j++){
-		fprintf(fp,"%14.14e \n",mesh->cell[j].pres);
+		fprintf(fp,"%14.14e \n",pres[j]);
+      }
       }
-      #endif
 
-      #if print_OVERPRESSURE
+      if(sim->print_overpressure){
 	fprintf(fp,"SCALARS d_pres DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e \n",mesh->cell[j].pres - mesh->cell[j].prese);
+	   	fprintf(fp,"%14.14e \n",pres[j] - mesh->prese[j]);
 	}
-      #endif
+      }
 
-      #if print_VELOCITY
+      if(sim->print_velocity){
 	fprintf(fp,"SCALARS U DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e \n",mesh->cell[j].U[1]/mesh->cell[j].U[0]);
+	   	fprintf(fp,"%14.14e \n",mesh->U[1][j]/mesh->U[0][j]);
 	}
 
 	fprintf(fp,"SCALARS V DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e \n",mesh->cell[j].U[2]/mesh->cell[j].U[0]);
+	   	fprintf(fp,"%14.14e \n",mesh->U[2][j]/mesh->U[0][j]);
 	}
 
 	fprintf(fp,"SCALARS W DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e \n",mesh->cell[j].U[3]/mesh->cell[j].U[0]);
+	   	fprintf(fp,"%14.14e \n",mesh->U[3][j]/mesh->U[0][j]);
 	}
-      #endif
+      }
 
-      #if print_ENERGY
+      if(sim->print_energy){
 	fprintf(fp,"SCALARS E DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e \n",mesh->cell[j].U[4]);
+	   	fprintf(fp,"%14.14e \n",mesh->U[4][j]);
 	}
-      #endif
+      }
 
-      #if print_SOLUTES
+      if(sim->print_solutes){
 	fprintf(fp,"SCALARS phi DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e \n",mesh->cell[j].U[5]);
+	   	fprintf(fp,"%14.14e \n",mesh->U[5][j]);
 	}
-      #endif
+      }
 
-      #if print_POTENTIALTEM
+      if(sim->print_potentialtem){
 	fprintf(fp,"SCALARS theta DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-            theta=mesh->cell[j].pres/(_R_*mesh->cell[j].U[0])/( pow((mesh->cell[j].pres/_p0_),((_gamma_-1.0)/_gamma_)) );
+            theta=pres[j]/(_R_*mesh->U[0][j])/( pow((pres[j]/_p0_),((_gamma_-1.0)/_gamma_)) );
 	   	fprintf(fp,"%14.14e \n",theta);
 	}
-      #endif
+      }
 
+	free(pres);
 
-#else
+	}else{
 	fprintf(fp,"SCALARS U DOUBLE \n");
 	fprintf(fp,"LOOKUP_TABLE DEFAULT \n");
 	for(j=0;j<mesh->ncells;j++){
-	   	fprintf(fp,"%14.14e\n",mesh->cell[j].U[0]);
+	   	fprintf(fp,"%14.14e\n",mesh->U[0][j]);
+	}
 	}
-#endif
 
 	fclose(fp);
-	printf("%s A VTK has been written: %s\n",OK,filename);
+	printf("%s A VTK has been written: %s\n",OK,fname);
 
 
 	return 1;
@@ -177,12 +479,17 @@ int write_vtk(t_mesh *mesh, char *filename){
 
 int write_list(t_mesh *mesh, char *filename){
 
-#if EQUATION_SYSTEM == 2 
-
 	int l,m,n,k;
 	double u,v,w,p,rho,phi,gamma,theta;
 	FILE *fp;
-	fp=fopen(filename,"w");
+	t_sim *sim;
+	char fname[1024];
+
+	sim=mesh->sim;
+	rank_filename(mesh->comm,filename,fname,sizeof(fname));
+	if(sim->eq_system == 2){
+
+	fp=fopen(fname,"w");
 	// Write file header
 	fprintf(fp,"VARIABLES = X, Y, Z, u, v, w, rho, p, phi, theta \n");
 	fprintf(fp,"CELLS = %d, %d, %d,\n",mesh->xcells,mesh->ycells,mesh->zcells);
@@ -191,32 +498,22 @@ int write_list(t_mesh *mesh, char *filename){
 		for(m=0;m<mesh->ycells;m++){
 			for(n=0;n<mesh->zcells;n++){
 			k = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-			u=mesh->cell[k].U[1]/mesh->cell[k].U[0];
-			v=mesh->cell[k].U[2]/mesh->cell[k].U[0];
-			w=mesh->cell[k].U[3]/mesh->cell[k].U[0];
-			rho=mesh->cell[k].U[0];
-			phi=mesh->cell[k].U[5]/mesh->cell[k].U[0];
-			#if MULTICOMPONENT
-				#if MULTI_TYPE==1
-					gamma=phi;
-				#else
-					gamma=1.0+1.0/phi;
-				#endif
-			#else
-				gamma=_gamma_;
-			#endif
-			p=pressure_from_energy(gamma, mesh->cell[k].U[4], u, v, w, mesh->cell[k].U[0], mesh->cell[k].zc);
-			theta=p/(_R_*mesh->cell[k].U[0])/( pow((p/_p0_),((_gamma_-1.0)/_gamma_)) );
+			u=mesh->U[1][k]/mesh->U[0][k];
+			v=mesh->U[2][k]/mesh->U[0][k];
+			w=mesh->U[3][k]/mesh->U[0][k];
+			rho=mesh->U[0][k];
+			phi=mesh->U[5][k]/mesh->U[0][k];
+			gamma=mixture_gamma(sim->multicomponent,phi);
+			p=pressure_from_energy(sim->st, gamma, mesh->U[4][k], u, v, w, mesh->U[0][k], mesh->cell[k].zc);
+			theta=p/(_R_*mesh->U[0][k])/( pow((p/_p0_),((_gamma_-1.0)/_gamma_)) );
                   fprintf(fp,"%14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e\n",mesh->cell[k].xc,mesh->cell[k].yc,mesh->cell[k].zc,u,v,w,rho,p,phi,theta);
             }
 		}
 	}
 	fclose(fp);
 	
-#else
-	int l,m,n,k;
-	FILE *fp;
-	fp=fopen(filename,"w");
+	}else{
+	fp=fopen(fname,"w");
 
 	// Write file header
 	fprintf(fp,"VARIABLES = X, Y, Z, U \n");
@@ -226,26 +523,31 @@ int write_list(t_mesh *mesh, char *filename){
 		for(m=0;m<mesh->ycells;m++){
 			for(n=0;n<mesh->zcells;n++){
 			k = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-			fprintf(fp,"%14.14e %14.14e %14.14e %14.14e \n",mesh->cell[k].xc,mesh->cell[k].yc,mesh->cell[k].zc,mesh->cell[k].U[0]);
+			fprintf(fp,"%14.14e %14.14e %14.14e %14.14e \n",mesh->cell[k].xc,mesh->cell[k].yc,mesh->cell[k].zc,mesh->U[0][k]);
             }
 		}
 	}
 	fclose(fp);
 	
-#endif
+	}
 
 	
-	printf("%s A *.out file has been written: %s\n",OK,filename);
+	printf("%s A *.out file has been written: %s\n",OK,fname);
 
 	return 1;
 }
 
 int write_list_eq(t_mesh *mesh, char *filename){
-#if (EQUATION_SYSTEM == 2  && ST!=0)
 	int l,m,n,k;
 	double u,v,w,p,rho,phi,gamma,theta;
 	FILE *fp;
-	fp=fopen(filename,"w");
+	t_sim *sim;
+	char fname[1024];
+
+	sim=mesh->sim;
+	if(sim->eq_system == 2  && sim->st!=0){
+	rank_filename(mesh->comm,filename,fname,sizeof(fname));
+	fp=fopen(fname,"w");
 
 	// Write file header
 	fprintf(fp,"VARIABLES = X, Y, Z, u, v, w, rho, p, phi, theta \n");
@@ -255,29 +557,21 @@ int write_list_eq(t_mesh *mesh, char *filename){
 		for(m=0;m<mesh->ycells;m++){
 			for(n=0;n<mesh->zcells;n++){
 			k = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-			u=mesh->cell[k].Ue[1]/mesh->cell[k].Ue[0];
-			v=mesh->cell[k].Ue[2]/mesh->cell[k].Ue[0];
-			w=mesh->cell[k].Ue[3]/mesh->cell[k].Ue[0];
-			rho=mesh->cell[k].Ue[0];
-			phi=mesh->cell[k].Ue[5]/mesh->cell[k].Ue[0];
-			#if MULTICOMPONENT
-				#if MULTI_TYPE==1
-					gamma=phi;
-				#else
-					gamma=1.0+1.0/phi;
-				#endif
-			#else
-				gamma=_gamma_;
-			#endif
-			p=pressure_from_energy(gamma, mesh->cell[k].Ue[4], u, v, w, mesh->cell[k].Ue[0], mesh->cell[k].zc);
-			theta=p/(_R_*mesh->cell[k].Ue[0])/( pow((p/_p0_),((_gamma_-1.0)/_gamma_)) );
+			u=mesh->Ue[1][k]/mesh->Ue[0][k];
+			v=mesh->Ue[2][k]/mesh->Ue[0][k];
+			w=mesh->Ue[3][k]/mesh->Ue[0][k];
+			rho=mesh->Ue[0][k];
+			phi=mesh->Ue[5][k]/mesh->Ue[0][k];
+			gamma=mixture_gamma(sim->multicomponent,phi);
+			p=pressure_from_energy(sim->st, gamma, mesh->Ue[4][k], u, v, w, mesh->Ue[0][k], mesh->cell[k].zc);
+			theta=p/(_R_*mesh->Ue[0][k])/( pow((p/_p0_),((_gamma_-1.0)/_gamma_)) );
                   fprintf(fp,"%14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e %14.14e \n",mesh->cell[k].xc,mesh->cell[k].yc,mesh->cell[k].zc,u,v,w,rho,p,phi,theta);
             }
 		}
 	}
 
 	fclose(fp);
-#endif
+	}
 	return 1;
 }
 
@@ -287,9 +581,17 @@ int write_list_eq(t_mesh *mesh, char *filename){
 int write_geo_vtk(t_mesh *mesh, char *filename){
 
 
-	int i,j;
+	int i,j,l,m,n;
+	int field[5]={VTK_STX,VTK_STY,VTK_STZ,VTK_CELLTYPE,VTK_GHOST};
 	FILE *fp;
-	fp=fopen(filename,"w");
+	char fname[1024];
+
+	if(mesh->sim->vtk_format==1){
+		return write_vti_fields(mesh,filename,field,5);
+	}
+
+	rank_filename(mesh->comm,filename,fname,sizeof(fname));
+	fp=fopen(fname,"w");
 
 	// Write file header
 	fprintf(fp,"# vtk DataFile Version 2.0\n");
@@ -299,14 +601,22 @@ int write_geo_vtk(t_mesh *mesh, char *filename){
 
 	// Write node coordinates
 	fprintf(fp,"POINTS %d double \n",mesh->nnodes);
-	for (i=0;i<mesh->nnodes;i++){
-	   fprintf(fp,"%lf %lf %lf\n", mesh->node[i].x, mesh->node[i].y, mesh->node[i].z);
+	for (n=0;n<mesh->zcells+1;n++){
+		for (m=0;m<mesh->ycells+1;m++){
+			for (l=0;l<mesh->xcells+1;l++){
+				fprintf(fp,"%lf %lf %lf\n", (l+mesh->offset[0])*mesh->dx, (m+mesh->offset[1])*mesh->dy, (n+mesh->offset[2])*mesh->dz);
+			}
+		}
 	}
 
 	//Write cell-node connectivity
 	fprintf(fp,"CELLS %d %d \n",mesh->ncells,mesh->ncells*(8+1));
 	for(i=0;i<mesh->ncells;i++){
-		fprintf(fp,"8 %d %d %d %d %d %d %d %d\n",mesh->cell[i].n1,mesh->cell[i].n2,mesh->cell[i].n3,mesh->cell[i].n4,mesh->cell[i].n5,mesh->cell[i].n6,mesh->cell[i].n7,mesh->cell[i].n8);
+		l=mesh->cell[i].l;
+		m=mesh->cell[i].m;
+		n=mesh->cell[i].n;
+		fprintf(fp,"8 %d %d %d %d %d %d %d %d\n",node_id(mesh,l,m,n),node_id(mesh,l+1,m,n),node_id(mesh,l+1,m+1,n),node_id(mesh,l,m+1,n),
+			node_id(mesh,l,m,n+1),node_id(mesh,l+1,m,n+1),node_id(mesh,l+1,m+1,n+1),node_id(mesh,l,m+1,n+1));
 	}
 	////////////////////////////////////////////////////
 	////////////// C O N E C T I V I T Y ///////////////
@@ -351,7 +661,7 @@ int write_geo_vtk(t_mesh *mesh, char *filename){
 
 
 	fclose(fp);
-	printf("%s An VTK has been dumped: %s\n",OK,filename);
+	printf("%s An VTK has been dumped: %s\n",OK,fname);
 
 
 	return 1;
@@ -366,12 +676,15 @@ void screen_info(t_mesh *mesh, t_sim *sim){
 	mass_calculation(mesh,sim);
 	energy_calculation(mesh,sim);
 	printf(" Total mass: M= %14.14e\n",mesh->mass);
-#if EQUATION_SYSTEM == 2 
+	if(sim->eq_system == 2){
 	printf(" Total energy: E= %14.14e\n",mesh->energy);
-#endif
+	}
 	printf(" Mass error: (M-M0)/M0 = %14.14e\n",(mesh->mass-mesh->mass0)/mesh->mass0);
-#if EQUATION_SYSTEM == 2 
+	if(sim->eq_system == 2){
 	printf(" Energy error: (E-E0)/E0 = %14.14e\n",(mesh->energy-mesh->energy0)/mesh->energy0);
+	}
+#if PROFILE
+	profiler_report(mesh,sim);
 #endif
 	printf("\n");
 	
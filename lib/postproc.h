@@ -19,6 +19,7 @@ Content:
   #define POSTPROC_H
 
   int write_vtk(t_mesh *mesh,char *filename);
+  int write_vti(t_mesh *mesh,char *filename);
   int write_list(t_mesh *mesh,char *filename);
   int write_list_eq(t_mesh *mesh,char *filename);
   int write_geo_vtk(t_mesh *mesh, char *filename);
@@ -18,8 +18,13 @@ Content:
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <omp.h>
 
 #include "definitions.h"
@@ -27,14 +32,62 @@ Content:
 #include "preproc.h"
 #include "closures.h"
 #include "mathutils.h"
+#include "gridindex.h"
+
+
+#define INITIAL_MAGIC "EHOWINIT"
+
+//Header of the binary input files (initial.bin, equilibrium.bin). It is followed by nvar arrays of
+//doubles (u for scalar equations; u, v, w, rho, p, phi for Euler equations) over the whole grid
+typedef struct{
+	char magic[8];
+	int32_t version;
+	int32_t nvar;
+	int32_t cells[3];
+	int32_t reserved;
+	char names[8][16]; //names of the variables
+} t_initial_header;
+
+
+double **allocate_field(int nvar, int ncells){
+	double **field;
+	int k;
+
+	//One contiguous block per variable, aligned to MEM_ALIGN bytes
+	field=(double**)malloc(nvar*sizeof(double*));
+	for(k=0;k<nvar;k++){
+		if(posix_memalign((void**)&(field[k]),MEM_ALIGN,ncells*sizeof(double))!=0){
+			printf("%s Memory allocation of %d cells failed. The program will close. \n",ERR,ncells);
+			exit(1);
+		}
+	}
+
+	return field;
+}
+
+
+//Sets a field to zero with the static partition of the cells used by the loops over cells of the time
+//step, so that each memory page is placed in the NUMA node of the thread that works on it (first touch)
+static void first_touch(double **field, int nvar, int ncells){
+	int k,i;
+
+#pragma omp parallel default(none) private(k) shared(field,nvar,ncells)
+	{
+	for(k=0;k<nvar;k++){
+#pragma omp for schedule(static) nowait
+		for(i=0;i<ncells;i++){
+			field[k][i]=0.0;
+		}
+	}
+	}
+
+}
 
 
 int create_mesh(t_mesh *mesh, t_sim *sim){
-	int l,m,n,k,aux,k2d;
+	int l,m,n,k,d;
 	int xcells,ycells,zcells;
 	t_cell *cell;
-	t_wall *wall;
-	t_node *node;
 
 	//int semiSt; //auxiliar variable to recalculate boundary cells stencil
 	mesh->tke=0.0;
@@ -50,31 +103,24 @@ int create_mesh(t_mesh *mesh, t_sim *sim){
 	mesh->cell=(t_cell*)malloc(mesh->ncells*sizeof(t_cell));
 	cell=mesh->cell;
 
-      for(n=0;n<zcells;n++){
-            for(m=0;m<ycells;m++){
-                  for(l=0;l<xcells;l++){
-
-                        k= xcells*m + l + n*xcells*ycells;
-                        cell[k].id=999;
+	//The cells are initialized in parallel, with the same partition as the loops over cells (first touch)
+#pragma omp parallel for default(none) private(l,m,n) shared(mesh,cell,xcells,ycells) schedule(static)
+      for(k=0;k<mesh->ncells;k++){
+                        l=k%xcells;
+                        m=(k/xcells)%ycells;
+                        n=k/(xcells*ycells);
+                        cell[k].id=k;
                         cell[k].l=l;
                         cell[k].m=m;
                         cell[k].n=n;
 
-
-                        cell[k].w1_id=999;
-                        cell[k].w2_id=999;
-                        cell[k].w3_id=999;
-                        cell[k].w4_id=999;
-                        cell[k].w5_id=999;
-                        cell[k].w6_id=999;
-
                         cell[k].dx=mesh->dx;
                         cell[k].dy=mesh->dy;
                         cell[k].dz=mesh->dz;
 
-                        cell[k].xc=999;
-                        cell[k].yc=999;
-                        cell[k].zc=999;
+                        cell[k].xc=(l+mesh->offset[0]+0.5)*cell[k].dx;
+                        cell[k].yc=(m+mesh->offset[1]+0.5)*cell[k].dy;
+                        cell[k].zc=(n+mesh->offset[2]+0.5)*cell[k].dz;
 
 				cell[k].xim = 999;
 				cell[k].yim = 999;
@@ -87,141 +133,36 @@ int create_mesh(t_mesh *mesh, t_sim *sim){
                         cell[k].distsolz = 9999999;
 
                         cell[k].out = 0;
-
-                        cell[k].n1=999;
-                        cell[k].n2=999;
-                        cell[k].n3=999;
-                        cell[k].n4=999;
-                        cell[k].n5=999;
-                        cell[k].n6=999;
-                        cell[k].n7=999;
-                        cell[k].n8=999;
-                  }
-            }
       }
 
-	//Walls
-	mesh->nwalls=3*mesh->ncells+xcells*zcells+ycells*zcells+xcells*ycells;
-	mesh->wall=(t_wall*)malloc(mesh->nwalls*sizeof(t_wall));
-
-	wall=mesh->wall;
-	for(k=0;k<mesh->nwalls;k++){
-		wall[k].id=k;
-		wall[k].fR_star=(double*)malloc(sim->nvar*sizeof(double));
-		wall[k].fL_star=(double*)malloc(sim->nvar*sizeof(double));
-		wall[k].UR=(double*)malloc(sim->nvar*sizeof(double));
-		wall[k].UL=(double*)malloc(sim->nvar*sizeof(double));
-            wall[k].URe=(double*)malloc(sim->nvar*sizeof(double));
-		wall[k].ULe=(double*)malloc(sim->nvar*sizeof(double));
-	}
-
-	//Walls amd nodes of the cells
-      for(n=0;n<zcells;n++){
-            for(m=0;m<ycells;m++){
-                  for(l=0;l<xcells;l++){
-
-                        k = l + m*xcells + n*xcells*ycells;
-                        k2d=l + m*xcells;
-                        cell[k].id=k;
-                        cell[k].l=l;
-                        cell[k].m=m;
-
-
-                        cell[k].w1_id=3*(k2d)+m+n*(3*xcells*ycells+xcells+ycells);
-                        cell[k].w4_id=cell[k].w1_id+1;
-                        cell[k].w5_id=cell[k].w1_id+2;
-                        if (l==xcells-1){
-                              cell[k].w2_id=cell[k].w1_id+4 - 1;
-                        }else{
-                              cell[k].w2_id=cell[k].w1_id+4;
-                        }
-                        if (m==ycells-1){
-                              aux=(3*xcells*ycells+xcells+ycells)*(n+1);
-                              cell[k].w3_id=aux-xcells+l;
-                        }else{
-                              cell[k].w3_id=cell[k].w1_id+xcells*3+1;
-                        }
-                        if (n==zcells-1){
-                              cell[k].w6_id=mesh->nwalls-xcells*ycells+l+m*xcells;
-                        }else{
-                              cell[k].w6_id=cell[k].w5_id+(3*xcells*ycells+xcells+ycells);
-                        }
-
-                        cell[k].w1=&(mesh->wall[cell[k].w1_id]);
-                        cell[k].w2=&(mesh->wall[cell[k].w2_id]);
-                        cell[k].w3=&(mesh->wall[cell[k].w3_id]);
-                        cell[k].w4=&(mesh->wall[cell[k].w4_id]);
-                        cell[k].w5=&(mesh->wall[cell[k].w5_id]);
-                        cell[k].w6=&(mesh->wall[cell[k].w6_id]);
-
-                        cell[k].dx=mesh->dx;
-                        cell[k].dy=mesh->dy;
-                        cell[k].dz=mesh->dz;
-
-                        cell[k].xc=(l+0.5)*cell[k].dx;
-                        cell[k].yc=(m+0.5)*cell[k].dy;
-                        cell[k].zc=(n+0.5)*cell[k].dz;
-
-                        cell[k].n1=k2d +m +n*(xcells+1)*(ycells+1);
-                        cell[k].n2=cell[k].n1+1;
-                        cell[k].n3=cell[k].n2+xcells+1;
-                        cell[k].n4=cell[k].n2+xcells;
-                        cell[k].n5=cell[k].n1 + (xcells+1)*(ycells+1);
-                        cell[k].n6=cell[k].n5+1;
-                        cell[k].n7=cell[k].n6+xcells+1;
-                        cell[k].n8=cell[k].n6+xcells;
-
-                  }
-            }
-      }
-
-
-	//normal vectors of the walls
-  	for(k=0;k<mesh->ncells;k++){
-		mesh->wall[cell[k].w1_id].nx=0.0;
-		mesh->wall[cell[k].w4_id].nx=1.0;
-		mesh->wall[cell[k].w1_id].ny=1.0;
-		mesh->wall[cell[k].w4_id].ny=0.0;
-            mesh->wall[cell[k].w1_id].nz=0.0;
-		mesh->wall[cell[k].w4_id].nz=0.0;
-
-		//we know this is redundant,
-		//but it's easier and is pre-process
-		mesh->wall[cell[k].w3_id].nx=0.0;
-		mesh->wall[cell[k].w2_id].nx=1.0;
-		mesh->wall[cell[k].w3_id].ny=1.0;
-		mesh->wall[cell[k].w2_id].ny=0.0;
-            mesh->wall[cell[k].w3_id].nz=0.0;
-		mesh->wall[cell[k].w2_id].nz=0.0;
-
-            mesh->wall[cell[k].w5_id].nx=0.0;
-		mesh->wall[cell[k].w6_id].nx=0.0;
-		mesh->wall[cell[k].w5_id].ny=0.0;
-		mesh->wall[cell[k].w6_id].ny=0.0;
-            mesh->wall[cell[k].w5_id].nz=1.0;
-		mesh->wall[cell[k].w6_id].nz=1.0;
-
+	//Faces. They are not stored as objects: only the wall types (and the equilibrium states,
+	//if needed) are kept, in one array per direction. Neighbour cells are computed from the
+	//face id (gridindex.h) and fluxes are computed along pencils without being stored.
+	mesh->nfaces[0]=(xcells+1)*ycells*zcells;
+	mesh->nfaces[1]=xcells*(ycells+1)*zcells;
+	mesh->nfaces[2]=xcells*ycells*(zcells+1);
+	for(d=0;d<3;d++){
+		mesh->wtype[d]=(char*)malloc(mesh->nfaces[d]*sizeof(char));
+		mesh->boundId[d]=(char*)malloc(mesh->nfaces[d]*sizeof(char));
+		if(sim->st!=0&&sim->eq_system==2){
+		mesh->ULe[d]=allocate_field(sim->nvar,mesh->nfaces[d]);
+		mesh->URe[d]=allocate_field(sim->nvar,mesh->nfaces[d]);
+		mesh->pLe[d]=allocate_field(1,mesh->nfaces[d])[0];
+		mesh->pRe[d]=allocate_field(1,mesh->nfaces[d])[0];
+		first_touch(mesh->ULe[d],sim->nvar,mesh->nfaces[d]);
+		first_touch(mesh->URe[d],sim->nvar,mesh->nfaces[d]);
+		first_touch(&(mesh->pLe[d]),1,mesh->nfaces[d]);
+		first_touch(&(mesh->pRe[d]),1,mesh->nfaces[d]);
+		}else{
+		mesh->ULe[d]=NULL;
+		mesh->URe[d]=NULL;
+		mesh->pLe[d]=NULL;
+		mesh->pRe[d]=NULL;
+		}
 	}
 
-
-
-	//Nodes
+	//Nodes. Only their number is needed, coordinates are computed when writing the output
 	mesh->nnodes=(mesh->xcells+1)*(mesh->ycells+1)*(mesh->zcells+1);
-	mesh->node=(t_node*)malloc(mesh->nnodes*sizeof(t_node));
-
-	node=mesh->node;
-	//Loop for nodes
-      for(n=0;n<zcells+1;n++){
-            for(m=0;m<ycells+1;m++){
-                  for(l=0;l<xcells+1;l++){
-                        k=(xcells+1)*(ycells+1)*n+(xcells+1)*m+l;
-                        node[k].id=k;
-                        node[k].x=l*mesh->dx;
-                        node[k].y=m*mesh->dy;
-                        node[k].z=n*mesh->dz;
-                  }
-            }
-      }
 
 	//Boundary condition flags
 	//This is for BC imposition
@@ -255,264 +196,222 @@ int create_mesh(t_mesh *mesh, t_sim *sim){
 		mesh->periodicZ=0;
 	}
 
+	//Allocation of the state arrays of the mesh (one array per variable)
+	mesh->U=     allocate_field(sim->nvar,mesh->ncells);
+	mesh->U_aux= allocate_field(sim->nvar,mesh->ncells);
+	mesh->Ue=    allocate_field(sim->nvar,mesh->ncells);
+	mesh->S_corr=allocate_field(sim->nvar,mesh->ncells);
+	mesh->prese= allocate_field(1,mesh->ncells)[0];
+	mesh->divF=  allocate_field(sim->nvar,mesh->ncells);
+	first_touch(mesh->U,sim->nvar,mesh->ncells);
+	first_touch(mesh->U_aux,sim->nvar,mesh->ncells);
+	first_touch(mesh->Ue,sim->nvar,mesh->ncells);
+	first_touch(mesh->S_corr,sim->nvar,mesh->ncells);
+	first_touch(&(mesh->prese),1,mesh->ncells);
+	first_touch(mesh->divF,sim->nvar,mesh->ncells);
+	mesh->W=NULL;
+	if(sim->rec_vars==1){	//Cache of the primitive variables (see update_primitives())
+		mesh->W=allocate_field(NPRIM,mesh->ncells);
+		first_touch(mesh->W,NPRIM,mesh->ncells);
+	}
+	mesh->nghost=0;	//The ghost cell table is built by assign_image_cells()
+	mesh->ghosts=NULL;
+	mesh->gni=NULL;
+	mesh->gli=NULL;
+	mesh->gnr=NULL;
 
-	//Assigment of wall's neighbour cells
-      for(n=0;n<zcells;n++){
-            for(m=0;m<ycells;m++){
-                  for(l=0;l<xcells;l++){
-
-                        //Interior walls
-                        k = l + m*xcells + n*xcells*ycells;
-
-                        cell[k].w1->cellR_id=cell[k].id;
-                        cell[k].w4->cellR_id=cell[k].id;
-                        cell[k].w5->cellR_id=cell[k].id;
-
-                        cell[k].w2->cellL_id=cell[k].id;
-                        cell[k].w3->cellL_id=cell[k].id;
-                        cell[k].w6->cellL_id=cell[k].id;
 
-                        cell[k].w1->cellR=&(cell[k]);
-                        cell[k].w4->cellR=&(cell[k]);
-                        cell[k].w5->cellR=&(cell[k]);
-                        cell[k].w2->cellL=&(cell[k]);
-                        cell[k].w3->cellL=&(cell[k]);
-                        cell[k].w6->cellL=&(cell[k]);
+	printf("%s Memory has been allocated and mesh connectivity has been defined \n",OK);
 
-                        //Boundary walls need to stablish their external cells
-                        if(m==0){
-                              //If we are at the first row position (m=0)
-                              //the left cell of the boundary walls are the last row cells
-                              //assuming periodic boundaries (if not, the fluxes will be rewritten later on
-                              cell[k].w1->cellL_id=cell[k+(ycells-1)*xcells].id;  //xcells*(ycells-1)+l+n*zcell
-                              cell[k].w1->cellL=&(cell[k+(ycells-1)*xcells]);
-                        }
+	return 1;
+}
 
-                        if(m==ycells-1){
-                              //If we are at the last row position (m=ycells-1)
-                              //the right cell of the boundary walls are the first row cells
-                              //assuming periodic boundaries (if not, the fluxes will be rewritten later on
-                              cell[k].w3->cellR_id=cell[k-m*xcells].id;
-                              cell[k].w3->cellR=&(cell[k-m*xcells]);
-                        }
 
-                        if(l==0){
-                              cell[k].w4->cellL_id=cell[k+(xcells-1)].id;
-                              cell[k].w4->cellL=&(cell[k+(xcells-1)]);
-                        }
-                        if(l==xcells-1){
-                              cell[k].w2->cellR_id=cell[k-(xcells-1)].id;
-                              cell[k].w2->cellR=&(cell[k-(xcells-1)]);
-                        }
+//Conserved variables of the cell k from the primitive variables of an input file: q=(u) for scalar
+//equations and q=(u,v,w,rho,p,phi) for Euler equations. pres (if not NULL) keeps the pressure
+static inline void set_conserved(t_mesh *mesh, t_sim *sim, double **field, double *pres, int k, const double *q){
+	double gamma;
+
+	if(sim->eq_system==2){
+		gamma=mixture_gamma(sim->multicomponent,q[5]);
+		field[0][k]=q[3];
+		field[1][k]=q[0]*q[3];
+		field[2][k]=q[1]*q[3];
+		field[3][k]=q[2]*q[3];
+		field[4][k]=energy_from_pressure(sim->st,gamma,q[4],q[0],q[1],q[2],q[3],mesh->cell[k].zc);
+		field[5][k]=q[5]*q[3];
+		if(pres!=NULL){
+			pres[k]=q[4];
+		}
+	}else{
+		field[0][k]=q[0];
+	}
 
-                        if(n==0){
-                              cell[k].w5->cellL_id=cell[k+(zcells-1)*xcells*ycells].id;
-                              cell[k].w5->cellL=&(cell[k+(zcells-1)*xcells*ycells]);
-                        }
-                        if(n==zcells-1){
-                              cell[k].w6->cellR_id=cell[k-(zcells-1)*xcells*ycells].id;
-                              cell[k].w6->cellR=&(cell[k-(zcells-1)*xcells*ycells]);
-                        }
+}
 
-                  }
-            }
-      }
-	//Allocation of arrays of variables in cells and walls
 
+//Reads an ASCII input file (initial.out or equilibrium.out). The file contains the whole grid, with the
+//z index running fastest: each rank reads it and keeps the cells of its subdomain. Returns 0 if the
+//file does not exist
+static int read_ascii_field(t_mesh *mesh, t_sim *sim, const char *fname, double **field, double *pres){
+	int m,k,l,n,nq,ok;
+	double q[6];
+	FILE *fp;
 
-	for(k=0;k<mesh->ncells;k++){
-		mesh->cell[k].U=    (double*)malloc(sim->nvar*sizeof(double));
-		mesh->cell[k].U_aux=(double*)malloc(sim->nvar*sizeof(double));
-		mesh->cell[k].Ue   =(double*)malloc(sim->nvar*sizeof(double));
-		mesh->cell[k].S=    (double*)malloc(sim->nvar*sizeof(double));
-            mesh->cell[k].S_corr=    (double*)malloc(sim->nvar*sizeof(double));
+	fp=fopen(fname,"r");
+	if(fp==NULL){
+		return 0;
 	}
-
-	for(k=0;k<mesh->nwalls;k++){
-		mesh->wall[k].UR=(double*)malloc(sim->nvar*sizeof(double));
-		mesh->wall[k].UL=(double*)malloc(sim->nvar*sizeof(double));
+	// Skip the first two lines
+	if (fscanf(fp, "%*[^\n]\n") != 0) {
+	  printf("Warning: Failed to skip the first line.\n");
 	}
-
-	cell=mesh->cell;
-	for(n=0;n<mesh->ncells;n++){
-		for(k=0;k<sim->nvar;k++){
-			cell[n].S[k]=0.0 ;
-                  cell[n].S_corr[k]=0.0 ;
-		}
+	if (fscanf(fp, "%*[^\n]\n") != 0) {
+	  printf("Warning: Failed to skip the second line.\n");
 	}
 
-	for(n=0;n<mesh->ncells;n++){
-		cell[n].w1->z=cell[n].zc;
-		cell[n].w4->z=cell[n].zc;
-		cell[n].w2->z=cell[n].zc;
-		cell[n].w3->z=cell[n].zc;
-		cell[n].w5->z=cell[n].zc-0.5*cell[n].dz;
-		cell[n].w6->z=cell[n].zc+0.5*cell[n].dz;
+	nq=(sim->eq_system==2 ? 6 : 1);
+	for(l=0;l<mesh->gxcells;l++){
+		for(m=0;m<mesh->gycells;m++){
+			for(n=0;n<mesh->gzcells;n++){
+			k = local_cell(mesh,l,m,n);
+			if(nq==6){
+				ok=(fscanf(fp, "%*f %*f %*f %le %le %le %le %le %le", &q[0], &q[1], &q[2], &q[3], &q[4], &q[5]) == 6);
+			}else{
+				ok=(fscanf(fp, "%*f %*f %*f %le ", &q[0]) == 1);
+			}
+			if (!ok) {
+			printf("%s Error: Failed to read data from %s \n",WAR,fname);
+			getchar();
+			}
+			if(k<0){
+				continue; //the cell belongs to another subdomain
+			}
+			set_conserved(mesh,sim,field,pres,k,q);
+			}
+		}
 	}
 
-
-	printf("%s Memory has been allocated and mesh connectivity has been defined \n",OK);
+	fclose(fp);
 
 	return 1;
 }
 
 
-int read_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
-	int m,k,l,n,ct;
-	FILE *fp;
-	char fname[1024];
-      double u;
-#if EQUATION_SYSTEM == 2
-      double p,v,w,rho,phi,gamma;
-      #if ST!=0
-      FILE *fpe;
-      #endif
-#endif
-	
-	t_cell *cell;
-	cell=mesh->cell;
-	ct=0;
-	
-	snprintf(fname, sizeof(fname), "%s/initial.out", folder_path);
-	fp = fopen(fname,"r");
-
-#if EQUATION_SYSTEM == 2
-	#if ST!=0
-      
-      snprintf(fname, sizeof(fname), "%s/equilibrium.out", folder_path);
-	fpe = fopen(fname,"r");
-      
-	if (fpe != NULL){
-		// Skip the first two lines
-		if (fscanf(fpe, "%*[^\n]\n") != 0) {
-		  printf("Warning: Failed to skip the first line.\n");
-		}
-		if (fscanf(fpe, "%*[^\n]\n") != 0) {
-		  printf("Warning: Failed to skip the second line.\n");
-		}
+//Reads a binary input file (initial.bin or equilibrium.bin, see write_initial_bin() in
+//python/initial2bin.py). The file is a header followed by one array per variable over the whole grid, with
+//the x index running fastest as in the solver. It is mapped in memory and each thread converts its
+//own cells, so each rank only reads the pages of its subdomain. Returns 0 if the file does not exist
+static int read_binary_field(t_mesh *mesh, t_sim *sim, const char *fname, double **field, double *pres){
+	t_initial_header head;
+	const double *data;
+	void *map;
+	struct stat st;
+	long gcells,size;
+	int fd,nq,k,l,m,n,i;
+	int xcells,ycells,gx,gy,ox,oy,oz,ncells;
+	double q[6];
+
+	fd=open(fname,O_RDONLY);
+	if(fd<0){
+		return 0;
+	}
+	nq=(sim->eq_system==2 ? 6 : 1);
+	gcells=(long)mesh->gxcells*mesh->gycells*mesh->gzcells;
+	size=sizeof(t_initial_header)+nq*gcells*sizeof(double);
+	if(fstat(fd,&st)!=0||read(fd,&head,sizeof(head))!=sizeof(head)
+		||memcmp(head.magic,INITIAL_MAGIC,8)!=0||head.version!=1){
+		printf("%s %s is not a valid binary input file. The program will close when pressing a key.\n",ERR,fname);
+		getchar();
+		exit(1);
+	}
+	if(head.nvar!=nq||head.cells[0]!=mesh->gxcells||head.cells[1]!=mesh->gycells||head.cells[2]!=mesh->gzcells||st.st_size!=size){
+		printf("%s %s has %d variables and %d x %d x %d cells, but %d variables and %d x %d x %d cells are needed. The program will close when pressing a key.\n",
+			ERR,fname,head.nvar,head.cells[0],head.cells[1],head.cells[2],nq,mesh->gxcells,mesh->gycells,mesh->gzcells);
+		getchar();
+		exit(1);
+	}
+	map=mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(map==MAP_FAILED){
+		printf("%s %s could not be mapped in memory. The program will close when pressing a key.\n",ERR,fname);
+		getchar();
+		exit(1);
+	}
+	data=(const double*)((const char*)map+sizeof(t_initial_header));
 
-		for(l=0;l<mesh->xcells;l++){
-			for(m=0;m<mesh->ycells;m++){
-				for(n=0;n<mesh->zcells;n++){
-				k = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-				if (fscanf(fpe, "%*f %*f %*f %le %le %le %le %le %le", &u, &v, &w, &rho, &p, &phi) != 6) {
-				printf("%s Error: Failed to read data equilibrium data \n",WAR);
-				getchar();
-				}
-				#if MULTICOMPONENT
-					#if MULTI_TYPE==1
-					gamma=phi;
-					#else
-					gamma=1.0+1.0/phi;
-					#endif
-				#else
-					gamma=_gamma_;
-				#endif
-				cell[k].Ue[0]=rho;
-				cell[k].Ue[1]=u*cell[k].U[0];
-				cell[k].Ue[2]=v*cell[k].U[0];
-				cell[k].Ue[3]=w*cell[k].U[0];
-				cell[k].Ue[4]=energy_from_pressure(gamma,p,u,v,w,rho,cell[k].zc);
-				cell[k].Ue[5]=phi*rho;
-				cell[k].prese=p;
-				}
-			}
+	xcells=mesh->xcells;
+	ycells=mesh->ycells;
+	ncells=mesh->ncells;
+	gx=mesh->gxcells;
+	gy=mesh->gycells;
+	ox=mesh->offset[0];
+	oy=mesh->offset[1];
+	oz=mesh->offset[2];
+#pragma omp parallel for default(none) private(l,m,n,i,q) shared(mesh,sim,field,pres,data,xcells,ycells,ncells,gx,gy,ox,oy,oz,nq,gcells) schedule(static)
+	for(k=0;k<ncells;k++){
+		l=k%xcells+ox;
+		m=(k/xcells)%ycells+oy;
+		n=k/(xcells*ycells)+oz;
+		for(i=0;i<nq;i++){
+			q[i]=data[i*gcells+l+(long)m*gx+(long)n*gx*gy];
 		}
-
-		fclose(fpe);
-
-		printf("%s equilibrium.out file has been read \n",OK);
-	}else{
-		printf("%s File equilibrium.out not found. Initial and equilibrium data is set in update_initial() \n",WAR);
-		ct=1;
+		set_conserved(mesh,sim,field,pres,k,q);
 	}
-	#endif
-	
-	if (fp != NULL){
-		// Skip the first two lines
-		if (fscanf(fp, "%*[^\n]\n") != 0) {
-		  printf("Warning: Failed to skip the first line.\n");
-		}
-		if (fscanf(fp, "%*[^\n]\n") != 0) {
-		  printf("Warning: Failed to skip the second line.\n");
-		}
 
-		for(l=0;l<mesh->xcells;l++){
-			for(m=0;m<mesh->ycells;m++){
-				for(n=0;n<mesh->zcells;n++){
-				k = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-				if (fscanf(fp, "%*f %*f %*f %le %le %le %le %le %le", &u, &v, &w, &rho, &p, &phi) != 6) {
-				printf("%s Error: Failed to read data initial data \n",WAR);
-				getchar();
-				}
-				#if MULTICOMPONENT
-					#if MULTI_TYPE==1
-					gamma=phi;
-					#else
-					gamma=1.0+1.0/phi;
-					#endif
-				#else
-					gamma=_gamma_;
-				#endif
-				cell[k].U[0]=rho;
-				cell[k].U[1]=u*cell[k].U[0];
-				cell[k].U[2]=v*cell[k].U[0];
-				cell[k].U[3]=w*cell[k].U[0];
-				cell[k].U[4]=energy_from_pressure(gamma,p,u,v,w,rho,cell[k].zc);
-				cell[k].U[5]=phi*rho;
-				}
-			}
-		}
+	munmap(map,size);
 
-		fclose(fp);
+	return 1;
+}
 
-		printf("%s initial.out file has been read \n",OK);
 
-	}else{
+//Reads the initial condition (and the equilibrium state, for Euler equations with source terms) from
+//the case folder. The binary files (initial.bin, equilibrium.bin) are used if they exist, and the ASCII
+//ones (initial.out, equilibrium.out) otherwise. When both exist and the ASCII file is newer, the binary
+//file is out of date and the ASCII one is used. Returns 1 if a file is missing
+int read_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
+	int ct,i,found,ascii;
+	char fname[1024],fascii[1024];
+	struct stat stb,sta;
+	const char *name[2]={"equilibrium","initial"};
+	double **field[2],*pres[2];
 
-	printf("%s File initial.out not found. Initial and equilibrium data is set in update_initial() \n",WAR);
-	ct=1;
-	
-	}
-	
-#else 
-	if (fp != NULL){
-		// Skip the first two lines
-		if (fscanf(fp, "%*[^\n]\n") != 0) {
-		  printf("Warning: Failed to skip the first line.\n");
-		}
-		if (fscanf(fp, "%*[^\n]\n") != 0) {
-		  printf("Warning: Failed to skip the second line.\n");
+	ct=0;
+	field[0]=mesh->Ue;
+	pres[0]=mesh->prese;
+	field[1]=mesh->U;
+	pres[1]=NULL;
+
+	for(i=0;i<2;i++){
+		if(i==0&&(sim->eq_system!=2||sim->st==0)){
+			continue; //the equilibrium state is only used with source terms
 		}
-
-		for(l=0;l<mesh->xcells;l++){
-			for(m=0;m<mesh->ycells;m++){
-				for(n=0;n<mesh->zcells;n++){
-				k = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-				if (fscanf(fp, "%*f %*f %*f %le ", &u) != 1) {
-				printf("%s Error: Failed to read data initial data \n",WAR);
-				getchar();
-				}
-				cell[k].U[0]=u;
-				}
+		snprintf(fname, sizeof(fname), "%s/%s.bin", folder_path, name[i]);
+		snprintf(fascii, sizeof(fascii), "%s/%s.out", folder_path, name[i]);
+		ascii=(stat(fascii,&sta)==0);
+		found=0;
+		if(ascii&&stat(fname,&stb)==0&&sta.st_mtime>stb.st_mtime){
+			printf("%s %s.out is newer than %s.bin, which is ignored. Convert it again with python/initial2bin.py \n",WAR,name[i],name[i]);
+		}else{
+			found=read_binary_field(mesh,sim,fname,field[i],pres[i]);
+			if(found&&ascii){
+				printf("%s %s.bin is used instead of %s.out \n",WAR,name[i],name[i]);
 			}
 		}
-
-		fclose(fp);
-
-		printf("%s initial.out file has been read \n",OK);
-
-	}else{
-
-	printf("%s File initial.out not found. Initial and equilibrium data is set in update_initial() \n",WAR);
-	ct=1;
-	
+		if(!found){
+			snprintf(fname, sizeof(fname), "%s", fascii);
+			found=read_ascii_field(mesh,sim,fname,field[i],pres[i]);
+		}
+		if(found){
+			printf("%s %s file has been read \n",OK,strrchr(fname,'/')+1);
+		}else{
+			printf("%s File %s.out not found. Initial and equilibrium data is set in update_initial() \n",WAR,name[i]);
+			ct=1;
+		}
 	}
 
-#endif
-	
 	return ct;
-	
+
 }
 
 
@@ -520,26 +419,26 @@ int read_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
 int update_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
 	int k,ct;
       double xc;
-#if EQUATION_SYSTEM == 2 
       int m;
       double zc,d1,d2,rc,aux1,aux2;
       double p,u,v,w,rho,phi,gamma,tt,p0,tt0,rho0;
-#else
       double yc,r;
-#endif
 
 	t_cell *cell;
 	cell=mesh->cell;
 
 #if READ_INITIAL
 	ct=read_initial(mesh,sim,folder_path);
-	if(ct==1){
 #else
 	printf("%s Read initial data from file case/initial.out is disabled \n",WAR);
+	ct=1;
 #endif
 
-#if EQUATION_SYSTEM == 2 
+	if(ct==1){
+
+	if(sim->eq_system == 2){
 
+#pragma omp parallel for default(none) private(m,xc,zc,d1,d2,rc,aux1,aux2,p,u,v,w,rho,phi,gamma,tt,p0,tt0,rho0) shared(mesh,sim,cell) schedule(static)
       for(k=0;k<mesh->ncells;k++){
 
 
@@ -565,17 +464,17 @@ int update_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
 
 
 			gamma=_gamma_;
-			cell[k].Ue[0]=rho;
-			cell[k].Ue[1]=u*cell[k].Ue[0];
-			cell[k].Ue[2]=v*cell[k].Ue[0];
-			cell[k].Ue[3]=w*cell[k].Ue[0];
-			cell[k].Ue[4]=energy_from_pressure(gamma,p,u,v,w,rho,cell[k].zc);
-			cell[k].Ue[5]=phi;
+			mesh->Ue[0][k]=rho;
+			mesh->Ue[1][k]=u*mesh->Ue[0][k];
+			mesh->Ue[2][k]=v*mesh->Ue[0][k];
+			mesh->Ue[3][k]=w*mesh->Ue[0][k];
+			mesh->Ue[4][k]=energy_from_pressure(sim->st,gamma,p,u,v,w,rho,cell[k].zc);
+			mesh->Ue[5][k]=phi;
 
-                  cell[k].prese=p;
+                  mesh->prese[k]=p;
 
 			for(m=0;m<sim->nvar;m++){
-				cell[k].U[m]=cell[k].Ue[m];
+				mesh->U[m][k]=mesh->Ue[m][k];
 			}
 
 
@@ -602,25 +501,25 @@ int update_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
                   phi=0.0;
 
 			gamma=_gamma_;
-			cell[k].U[0]=rho;
-			cell[k].U[1]=u*cell[k].U[0];
-			cell[k].U[2]=v*cell[k].U[0];
-			cell[k].U[3]=w*cell[k].U[0];
-			cell[k].U[4]=energy_from_pressure(gamma,p,u,v,w,rho,cell[k].zc);
-			cell[k].U[5]=phi;
+			mesh->U[0][k]=rho;
+			mesh->U[1][k]=u*mesh->U[0][k];
+			mesh->U[2][k]=v*mesh->U[0][k];
+			mesh->U[3][k]=w*mesh->U[0][k];
+			mesh->U[4][k]=energy_from_pressure(sim->st,gamma,p,u,v,w,rho,cell[k].zc);
+			mesh->U[5][k]=phi;
 
 
             }else{
 
-                  cell[k].Ue[0]=-1.0;
-                  cell[k].Ue[1]=0.0;
-                  cell[k].Ue[2]=0.0;
-                  cell[k].Ue[3]=0.0;
-                  cell[k].Ue[4]=0.0;
-                  cell[k].Ue[5]=0.0;
+                  mesh->Ue[0][k]=-1.0;
+                  mesh->Ue[1][k]=0.0;
+                  mesh->Ue[2][k]=0.0;
+                  mesh->Ue[3][k]=0.0;
+                  mesh->Ue[4][k]=0.0;
+                  mesh->Ue[5][k]=0.0;
 
 			for(m=0;m<sim->nvar;m++){
-				cell[k].U[m]=cell[k].Ue[m];
+				mesh->U[m][k]=mesh->Ue[m][k];
 			}
 
 
@@ -628,15 +527,8 @@ int update_initial(t_mesh *mesh, t_sim *sim, const char *folder_path){
 
       }
 
-#if READ_INITIAL
-	}
-#endif
-
-#endif
-
-
-
-#if EQUATION_SYSTEM == 1
+	}else{
+#pragma omp parallel for default(none) private(xc,yc,r) shared(mesh,cell) schedule(static)
 for(k=0;k<mesh->ncells;k++){
 
       xc=5.0;
@@ -646,206 +538,428 @@ for(k=0;k<mesh->ncells;k++){
 	r=sqrt((cell[k].xc-xc)*(cell[k].xc-xc)+(cell[k].yc-yc)*(cell[k].yc-yc));
 
       if (r<0.5) {
-            cell[k].U[0]=2.0;
+            mesh->U[0][k]=2.0;
       }else{
-            cell[k].U[0]=1.0;
+            mesh->U[0][k]=1.0;
       }
 
 }
 
-#if READ_INITIAL
 	}
-#endif
 
-#endif
+	}
 
-#if EQUATION_SYSTEM == 0 
-for(k=0;k<mesh->ncells;k++){
 
-      xc=5.0;
-      yc=5.0;
-      //zc=5.0;
-      //r=sqrt((cell[k].xc-xc)*(cell[k].xc-xc)+(cell[k].yc-yc)*(cell[k].yc-yc)+(cell[k].zc-zc)*(cell[k].zc-zc));
-	r=sqrt((cell[k].xc-xc)*(cell[k].xc-xc)+(cell[k].yc-yc)*(cell[k].yc-yc));
+	return 1;
+}
 
-      if (r<0.5) {
-            cell[k].U[0]=2.0;
-      }else{
-            cell[k].U[0]=1.0;
-      }
 
+
+int assign_wall_type(t_mesh *mesh){
+	t_cell *cell;
+	int d,f,side,idL,idR,idIn,l,m,n;
+	char wtype,boundId;
+
+	cell=mesh->cell;
+	for(d=0;d<3;d++){
+#pragma omp parallel for default(none) private(side,idL,idR,idIn,l,m,n,wtype,boundId) shared(mesh,cell,d) schedule(static)
+		for(f=0;f<mesh->nfaces[d];f++){
+			side=face_cells(mesh,d,f,&idL,&idR,&l,&m,&n);
+			if(side!=0&&domain_boundary(mesh,side)==0){
+				side=0; //boundary with a neighbour subdomain: inner wall
+			}
+			wtype=1;          //by default: 1= normal RP wall
+			boundId=0;    //0 when the wall is not at any boundary. Otherwise: 1, 2, 3, 4, 5, 6.
+
+			#if ALLOW_SOLIDS==1
+
+			if(cell[idL].type==0 && cell[idR].type!=0){
+				wtype=4;
+				boundId=(d==0 ? 4 : (d==1 ? 1 : 5));
+			}else if(cell[idR].type==0 && cell[idL].type!=0){
+				wtype=4;
+				boundId=(d==0 ? 2 : (d==1 ? 3 : 6));
+			}else if(cell[idL].type==0 && cell[idR].type==0){
+				wtype=0;
+			}
+
+			#endif
+
+			//Boundary walls take the type of the boundary condition of the inner cell
+			if(side!=0){
+				if(side==1 || side==4 || side==5){
+					idIn=idR;
+				}else{
+					idIn=idL;
+				}
+				if(cell[idIn].type!=0){
+					wtype=mesh->bc[side-1];
+					boundId=side;
+				}else{
+					wtype=0;
+				}
+			}
+
+			mesh->wtype[d][f]=wtype;
+			mesh->boundId[d][f]=boundId;
+		}
+	}
+
+	return 1;
 }
 
-#if READ_INITIAL
+int build_work_lists(t_mesh *mesh){
+	//Lists of the fluid cells and the pencils with flux of each direction, in increasing order (the
+	//ghost cells are listed by build_ghost_table() in ibmutils.c). A pencil without flux (all its
+	//faces have wtype 0) only contains solid or ghost cells, whose residual is not used, so it is
+	//skipped by the sweeps
+
+	int i,d,q,j,ncells,base,stride,fbase,fstride,l,m,n;
+	t_cell *cell;
+
+	cell=mesh->cell;
+	mesh->active=(int*)malloc(mesh->ncells*sizeof(int));
+	mesh->nactive=0;
+	for(i=0;i<mesh->ncells;i++){
+		if(cell[i].type!=0&&cell[i].ghost!=1){
+			mesh->active[mesh->nactive++]=i;
+		}
 	}
-#endif
 
-#endif
+	for(d=0;d<3;d++){
+		mesh->pencils[d]=(int*)malloc(pencil_count(mesh,d)*sizeof(int));
+		mesh->npencils[d]=0;
+		for(q=0;q<pencil_count(mesh,d);q++){
+			ncells=pencil_index(mesh,d,q,&base,&stride,&fbase,&fstride,&l,&m,&n);
+			for(j=0;j<=ncells;j++){
+				if(mesh->wtype[d][fbase+j*fstride]!=0){
+					mesh->pencils[d][mesh->npencils[d]++]=q;
+					break;
+				}
+			}
+		}
+	}
 
+	printf("%s Work lists: %d fluid cells, %d ghost cells and %d/%d/%d pencils with flux (of %d cells and %d/%d/%d pencils)\n",OK,
+		mesh->nactive,mesh->nghost,mesh->npencils[0],mesh->npencils[1],mesh->npencils[2],
+		mesh->ncells,pencil_count(mesh,0),pencil_count(mesh,1),pencil_count(mesh,2));
 
 	return 1;
 }
 
+#if ALLOW_SOLIDS==1
+//Tags cell c as ghost cell if its center is below triangle m of solid l, closer than dp to the surface
+//and with its projection inside the triangle. A cell already outside of another triangle is not tagged.
+//The triangles are tested in the order of the solids and of the STL files, as the result depends on it
+static void tag_cell_triangle(t_cell *c, t_triangle *tri, int l, int m, double dp){
+	int q;
+	double proj,dist,s1,s2,s3;
+	double dif[3],xc[3],v1[3],v2[3],v3[3],vp1[3],vp2[3],vp3[3],dc1[3],dc2[3],dc3[3];
+
+	dif[0]=c->xc-tri->p1[0]; //vector from cell center to node P1
+	dif[1]=c->yc-tri->p1[1];
+	dif[2]=c->zc-tri->p1[2];
+	proj=dif[0]*tri->nr[0]+dif[1]*tri->nr[1]+dif[2]*tri->nr[2]; //vector from cell center to triangle P1, projected onto normal direction
+	dist=proj/tri->absnr;
+	if (proj>0 && c->ghost>0 && fabs(dist)<c->distabs){ // if a cell has been tagged as "ghost" and is now found outside of other triangle, it is reverted as "fluid cell"
+		c->ghost=0;
+	}
+	if (proj<=0&&c->out<1) { //when proj<0 and the cell is not already outside of other triangle, the cell center is inside the solid (below the surface)
+		if (fabs(dist)<dp) {
+			xc[0]=c->xc - dist*tri->nr[0]; //Formula: Xc = Xcell - proj * n / abs(n) allows to compute the intersection point on the triangle, xc
+			xc[1]=c->yc - dist*tri->nr[1];
+			xc[2]=c->zc - dist*tri->nr[2];
+
+			// Below, the point-in-triangle algorithm (3D version) is used to detect if the intersection point, xc, is inside the triangle
+			for(q=0;q<3;q++){
+				v1[q]=tri->p2[q]-tri->p1[q]; // the vectors between nodes
+				v2[q]=tri->p3[q]-tri->p2[q];
+				v3[q]=tri->p1[q]-tri->p3[q];
+				dc1[q]=xc[q]-tri->p1[q];
+				dc2[q]=xc[q]-tri->p2[q];
+				dc3[q]=xc[q]-tri->p3[q];
+			}
 
+			vector_product(v1,dc1,vp1); // the point-in-triangle algorithm  is based on cross products to determine whether point is inside or not
+			vector_product(v2,dc2,vp2);
+			vector_product(v3,dc3,vp3);
+
+			s1=dot_product(vp1,vp2);
+			s2=dot_product(vp2,vp3);
+			s3=dot_product(vp3,vp1);
+
+			if (s1>0 && s2>0 &&  s3>0) { // when all are positive (same vector product direction), the point xc is inside the triangle
+				if(fabs(dist)<c->distabs){  // the condition before may happen for many triangles, so we keep the closest to the interface
+					c->ghost=1;
+					c->solid_id=l;
+					c->triangle_id=m;
+					c->tri=tri;
+					if(fabs(dist)<TOL14){
+						dist=-TOL14; //to ensure negativity of dist, that might be zero and therefore +-0
+					}
+					c->distabs=fabs(dist);
+					c->xim = xc[0] - dist*tri->nr[0];
+					c->yim = xc[1] - dist*tri->nr[1];
+					c->zim = xc[2] - dist*tri->nr[2];
+				}
+			}
+		}
+	}else{
+		c->out=1;
+	}
 
-int assign_wall_type(t_mesh *mesh){
-	t_wall *wall;
-	int m,l,n,k;
-
-    for(n=0;n<mesh->nwalls;n++){
-            wall=&(mesh->wall[n]);
-            wall->wtype=1;          //by default: 1= normal RP wall
-            wall->boundId=999;    //999 when the wall is not at any boundary. Otherwise: 1, 2, 3, 4, 5, 6.
-
-            #if ALLOW_SOLIDS==1
-
-
-            if(wall->nx>TOL4){
-                  if(wall->cellL->type==0 && wall->cellR->type!=0){
-                        wall->wtype=4;
-                        wall->boundId=4;
-                  }else if(wall->cellR->type==0 && wall->cellL->type!=0){
-                        wall->wtype=4;
-                        wall->boundId=2;
-                  }else if(wall->cellL->type==0 && wall->cellR->type==0){
-                        wall->wtype=0;
-                  }
-            }else if(wall->ny>TOL4){
-                  if(wall->cellL->type==0 && wall->cellR->type!=0){
-                        wall->wtype=4;
-                        wall->boundId=1;
-                  }else if(wall->cellR->type==0 && wall->cellL->type!=0){
-                        wall->wtype=4;
-                        wall->boundId=3;
-                  }else if(wall->cellL->type==0 && wall->cellR->type==0){
-                        wall->wtype=0;
-                  }
-            }else{
-                  if(wall->cellL->type==0 && wall->cellR->type!=0){
-                        wall->wtype=4;
-                        wall->boundId=5;
-                  }else if(wall->cellR->type==0 && wall->cellL->type!=0){
-                        wall->wtype=4;
-                        wall->boundId=6;
-                  }else if(wall->cellL->type==0 && wall->cellR->type==0){
-                        wall->wtype=0;
-                  }
-            }
+}
 
 
+//Ghost cells. The triangles are sorted into a uniform grid of bins of _ibmbin_ cells per direction, each
+//bin keeping the triangles whose bounding box overlaps it, in the order of the solids and STL files. The
+//bins are then processed in parallel: each cell is tested against the triangles whose bounding box
+//contains it, in the same order as in a serial loop over the triangles
+static void tag_ghost_cells(t_mesh *mesh, t_solid *solids){
+	t_cell *cell;
+	t_triangle *triangle;
+	int nb[3],nbins,b,bl,bm,bn,i,j,k,l,m,n,e,nentries;
+	int *start,*pos,*esolid,*etri;
+	double dp;
 
-            #endif
+	cell=mesh->cell;
+	nb[0]=(mesh->xcells+_ibmbin_-1)/_ibmbin_;
+	nb[1]=(mesh->ycells+_ibmbin_-1)/_ibmbin_;
+	nb[2]=(mesh->zcells+_ibmbin_-1)/_ibmbin_;
+	nbins=nb[0]*nb[1]*nb[2];
+	start=(int*)calloc(nbins+1,sizeof(int));
+	pos=(int*)malloc(nbins*sizeof(int));
+
+	//Bins overlapped by each triangle: first counted, then filled
+	for(l=0;l<solids->nsolid;l++){
+		triangle=solids->stl[l].triangle;
+		for(m=0;m<solids->stl[l].ntri;m++){
+			for(bn=triangle[m].imin[2]/_ibmbin_;bn<=triangle[m].imax[2]/_ibmbin_;bn++){
+				for(bm=triangle[m].imin[1]/_ibmbin_;bm<=triangle[m].imax[1]/_ibmbin_;bm++){
+					for(bl=triangle[m].imin[0]/_ibmbin_;bl<=triangle[m].imax[0]/_ibmbin_;bl++){
+						start[bl+bm*nb[0]+bn*nb[0]*nb[1]+1]++;
+					}
+				}
+			}
+		}
+	}
+	for(b=0;b<nbins;b++){
+		start[b+1]+=start[b];
+		pos[b]=start[b];
+	}
+	nentries=start[nbins];
+	esolid=(int*)malloc(MAX(nentries,1)*sizeof(int));
+	etri=(int*)malloc(MAX(nentries,1)*sizeof(int));
+	for(l=0;l<solids->nsolid;l++){
+		triangle=solids->stl[l].triangle;
+		for(m=0;m<solids->stl[l].ntri;m++){
+			for(bn=triangle[m].imin[2]/_ibmbin_;bn<=triangle[m].imax[2]/_ibmbin_;bn++){
+				for(bm=triangle[m].imin[1]/_ibmbin_;bm<=triangle[m].imax[1]/_ibmbin_;bm++){
+					for(bl=triangle[m].imin[0]/_ibmbin_;bl<=triangle[m].imax[0]/_ibmbin_;bl++){
+						b=bl+bm*nb[0]+bn*nb[0]*nb[1];
+						esolid[pos[b]]=l;
+						etri[pos[b]]=m;
+						pos[b]++;
+					}
+				}
+			}
+		}
+	}
 
-    }
+	dp=MAX(mesh->dx,mesh->dy);
+	dp=MAX(dp,mesh->dz);
+	dp=_stol_*dp;
+
+#pragma omp parallel for default(none) private(bl,bm,bn,i,j,k,l,m,n,e,triangle) shared(mesh,solids,cell,nb,nbins,start,esolid,etri,dp) schedule(dynamic)
+	for(b=0;b<nbins;b++){
+		bl=b%nb[0];
+		bm=(b/nb[0])%nb[1];
+		bn=b/(nb[0]*nb[1]);
+		for(e=start[b];e<start[b+1];e++){
+			l=esolid[e];
+			m=etri[e];
+			triangle=solids->stl[l].triangle;
+			for(k=MAX(triangle[m].imin[2],bn*_ibmbin_);k<=MIN(triangle[m].imax[2],(bn+1)*_ibmbin_-1);k++){
+				for(j=MAX(triangle[m].imin[1],bm*_ibmbin_);j<=MIN(triangle[m].imax[1],(bm+1)*_ibmbin_-1);j++){
+					for(i=MAX(triangle[m].imin[0],bl*_ibmbin_);i<=MIN(triangle[m].imax[0],(bl+1)*_ibmbin_-1);i++){
+						n=mesh->xcells*j + i + k*mesh->xcells*mesh->ycells;
+						tag_cell_triangle(&(cell[n]),&(triangle[m]),l,m,dp);
+					}
+				}
+			}
+		}
+	}
 
+	free(start);
+	free(pos);
+	free(esolid);
+	free(etri);
 
+}
 
-      m=0;
-      for(l=0;l<mesh->xcells;l++){
-            for(n=0;n<mesh->zcells;n++){
-                  //k=mesh->xcells*m+l;
-                  k= mesh->xcells*m + l + n*mesh->xcells*mesh->ycells;
-                  wall=&(mesh->wall[mesh->cell[k].w1_id]);
-                  if(mesh->cell[k].type!=0){
-                        wall->wtype=mesh->bc[0];
-                        wall->boundId=1;
-                  }else{
-                        wall->wtype=0;
-                  }
 
-            }
-      }
+//Nearest ghost cell to each cell of a grid line (len cells starting at k0, separated by stride), in
+//cell positions along the line (-1 if there is none). When two ghost cells are at the same distance, the
+//later one is taken. Returns the number of ghost cells in the line
+static int nearest_ghost_line(t_cell *cell, int k0, int stride, int len, int *near){
+	int i,last,ct;
 
-      m=mesh->ycells-1;
-      for(l=0;l<mesh->xcells;l++){
-            for(n=0;n<mesh->zcells;n++){
-                  k= mesh->xcells*m + l + n*mesh->xcells*mesh->ycells;
-                  wall=&(mesh->wall[mesh->cell[k].w3_id]);
-                  if(mesh->cell[k].type!=0){
-                        wall->wtype=mesh->bc[2];
-                        wall->boundId=3;
-                  }else{
-                        wall->wtype=0;
-                  }
-            }
-      }
+	ct=0;
+	last=-1;
+	for(i=0;i<len;i++){
+		if(cell[k0+i*stride].ghost==1){
+			last=i;
+			ct++;
+		}
+		near[i]=last;
+	}
+	last=-1;
+	for(i=len-1;i>=0;i--){
+		if(cell[k0+i*stride].ghost==1){
+			last=i;
+		}
+		if(last>-1&&(near[i]<0||last-i<=i-near[i])){
+			near[i]=last;
+		}
+	}
 
+	return ct;
+}
 
-      l=mesh->xcells-1;
-      for(m=0;m<mesh->ycells;m++){
-            for(n=0;n<mesh->zcells;n++){
-                  k= mesh->xcells*m + l + n*mesh->xcells*mesh->ycells;
-                  wall=&(mesh->wall[mesh->cell[k].w2_id]);
-                  if(mesh->cell[k].type!=0){
-                        wall->wtype=mesh->bc[1];
-                        wall->boundId=2;
-                  }else{
-                        wall->wtype=0;
-                  }
-            }
-      }
 
+//Solid cells. Each cell of the bounding box of a solid that is not a ghost cell looks for the nearest
+//ghost cell along its x and y lines; the cell is inside the solid when, in both directions, the vector
+//to that ghost cell points out of the surface (and the line has at least two ghost cells, to prevent
+//isolated ghost cells from generating solid lines). The nearest ghost cells of a whole line are found in
+//two sweeps, so the cost is linear in the number of cells of the bounding box
+static void classify_solid_cells(t_mesh *mesh, t_solid *solids){
+	t_cell *cell;
+	unsigned char *insidex;
+	int *near;
+	int l,i,j,k,n,q,p,ct,nlines,len;
 
-      l=0;
-      for(m=0;m<mesh->ycells;m++){
-            for(n=0;n<mesh->zcells;n++){
-                  k= mesh->xcells*m + l + n*mesh->xcells*mesh->ycells;
-                  wall=&(mesh->wall[mesh->cell[k].w4_id]);
-                  if(mesh->cell[k].type!=0){
-                        wall->wtype=mesh->bc[3];
-                        wall->boundId=4;
-                  }else{
-                        wall->wtype=0;
-                  }
-            }
-      }
+	cell=mesh->cell;
+	insidex=(unsigned char*)calloc(mesh->ncells,sizeof(unsigned char));
+	len=MAX(mesh->xcells,mesh->ycells);
 
-      n=0;
-      for(m=0;m<mesh->ycells;m++){
-            for(l=0;l<mesh->xcells;l++){
-                  k= mesh->xcells*m + l + n*mesh->xcells*mesh->ycells;
-                  wall=&(mesh->wall[mesh->cell[k].w5_id]);
-                  if(mesh->cell[k].type!=0){
-                        wall->wtype=mesh->bc[4];
-                        wall->boundId=5;
-                  }else{
-                        wall->wtype=0;
-                  }
-            }
-      }
+	for(l=0;l<solids->nsolid;l++){
+		nlines=(solids->stl[l].imax[1]-solids->stl[l].imin[1]+1)*(solids->stl[l].imax[2]-solids->stl[l].imin[2]+1);
+#pragma omp parallel default(none) private(near,i,j,k,n,q,p,ct) shared(mesh,solids,cell,insidex,l,nlines,len)
+		{
+		near=(int*)malloc(len*sizeof(int));
+
+		//x lines
+#pragma omp for schedule(static)
+		for(p=0;p<nlines;p++){
+			j=solids->stl[l].imin[1]+p%(solids->stl[l].imax[1]-solids->stl[l].imin[1]+1);
+			k=solids->stl[l].imin[2]+p/(solids->stl[l].imax[1]-solids->stl[l].imin[1]+1);
+			n=mesh->xcells*j + k*mesh->xcells*mesh->ycells;
+			ct=nearest_ghost_line(cell,n,1,mesh->xcells,near);
+			if(ct>1){
+				for(i=solids->stl[l].imin[0];i<=solids->stl[l].imax[0];i++){
+					if(cell[n+i].ghost!=1){
+						q=n+near[i];
+						if((cell[q].xc-cell[n+i].xc)*cell[q].tri->nr[0]>0.0){ //when the vector points out the surface, the cell is inside
+							insidex[n+i]=1;
+						}
+					}
+				}
+			}
+		}
 
-      n=mesh->zcells-1;;
-      for(m=0;m<mesh->ycells;m++){
-            for(l=0;l<mesh->xcells;l++){
-                  k= mesh->xcells*m + l + n*mesh->xcells*mesh->ycells;
-                  wall=&(mesh->wall[mesh->cell[k].w6_id]);
-                  if(mesh->cell[k].type!=0){
-                        wall->wtype=mesh->bc[5];
-                        wall->boundId=6;
-                  }else{
-                        wall->wtype=0;
-                  }
-            }
-      }
+		//y lines. Each cell is in a single y line, so they can be updated without conflicts
+#pragma omp for schedule(static)
+		for(p=0;p<(solids->stl[l].imax[0]-solids->stl[l].imin[0]+1)*(solids->stl[l].imax[2]-solids->stl[l].imin[2]+1);p++){
+			i=solids->stl[l].imin[0]+p%(solids->stl[l].imax[0]-solids->stl[l].imin[0]+1);
+			k=solids->stl[l].imin[2]+p/(solids->stl[l].imax[0]-solids->stl[l].imin[0]+1);
+			n=i + k*mesh->xcells*mesh->ycells;
+			ct=nearest_ghost_line(cell,n,mesh->xcells,mesh->ycells,near);
+			if(ct>1){
+				for(j=solids->stl[l].imin[1];j<=solids->stl[l].imax[1];j++){
+					if(cell[n+j*mesh->xcells].ghost!=1&&insidex[n+j*mesh->xcells]==1){
+						q=n+near[j]*mesh->xcells;
+						if((cell[q].yc-cell[n+j*mesh->xcells].yc)*cell[q].tri->nr[1]>0.0){
+							cell[n+j*mesh->xcells].type=0; //when intersections are detected in X and Y ray tracing, then the cell is set as solid.
+						}
+					}
+				}
+			}
+		}
 
+		free(near);
+		}
+	}
+
+	free(insidex);
 
-	return 1;
 }
 
+
+//Distance (in cells) from each non-solid cell to the nearest solid cell of its line in direction d, in
+//two sweeps along each line. It is left unchanged when there are no solid cells in the line
+static void solid_distance(t_mesh *mesh, int d){
+	t_cell *cell;
+	int cells[3],stride[3],*last;
+	int p,i,k0,a,b,dist,lastsolid;
+
+	cell=mesh->cell;
+	cells[0]=mesh->xcells;
+	cells[1]=mesh->ycells;
+	cells[2]=mesh->zcells;
+	stride[0]=1;
+	stride[1]=mesh->xcells;
+	stride[2]=mesh->xcells*mesh->ycells;
+	a=(d+1)%3; //the two other directions, which give the lines
+	b=(d+2)%3;
+
+#pragma omp parallel default(none) private(last,p,i,k0,dist,lastsolid) shared(mesh,cell,cells,stride,a,b,d)
+	{
+	last=(int*)malloc(cells[d]*sizeof(int));
+#pragma omp for schedule(static)
+	for(p=0;p<cells[a]*cells[b];p++){
+		k0=(p%cells[a])*stride[a]+(p/cells[a])*stride[b];
+		lastsolid=-1;
+		for(i=0;i<cells[d];i++){
+			if(cell[k0+i*stride[d]].type==0){
+				lastsolid=i;
+			}
+			last[i]=lastsolid;
+		}
+		lastsolid=-1;
+		for(i=cells[d]-1;i>=0;i--){
+			if(cell[k0+i*stride[d]].type==0){
+				lastsolid=i;
+			}else if(last[i]>-1||lastsolid>-1){
+				dist=(last[i]>-1 ? i-last[i] : cells[d]);
+				if(lastsolid>-1){
+					dist=MIN(dist,lastsolid-i);
+				}
+				if(d==0){
+					cell[k0+i*stride[d]].distsolx=MIN(cell[k0+i*stride[d]].distsolx,dist);
+				}else if(d==1){
+					cell[k0+i*stride[d]].distsoly=MIN(cell[k0+i*stride[d]].distsoly,dist);
+				}else{
+					cell[k0+i*stride[d]].distsolz=MIN(cell[k0+i*stride[d]].distsolz,dist);
+				}
+			}
+		}
+	}
+	free(last);
+	}
+
+}
+#endif
+
+
 int assign_cell_type(t_mesh *mesh,t_solid *solids){ // Define ghost and solid cells
 	t_cell *cell;	
 	int k;
 #if ALLOW_SOLIDS==1
-	int m,l,n,i,j,q,i1,i2,i3,na,df,df0,ct;
-      double aux1,aux2;
-      double proj,dist,s1,s2,s3;
-      double dif[3],xc[3],v1[3],v2[3],v3[3],vp1[3],vp2[3],vp3[3],dc1[3],dc2[3],dc3[3];
-      double dp;
-      int solx,soly,solz;
-      t_triangle *triangle;
+	int l,i,j,n,q,ct;
 #endif
 
       cell=mesh->cell;
+#pragma omp parallel for default(none) shared(mesh,cell) schedule(static)
       for(k=0;k<mesh->ncells;k++){
             cell[k].type=1;          //by default 1.    1= computed cell, 0= solid cell (not computed cell)
             cell[k].ghost=0;
@@ -858,202 +972,13 @@ int assign_cell_type(t_mesh *mesh,t_solid *solids){ // Define ghost and solid ce
 
       if(solids->nsolid<1){
             printf("%s In function assign_cell_type() no solids are considered\n",WAR);
-      }else{
-
-            for(l=0;l<solids->nsolid;l++){ // loop for each solid
-                  triangle=solids->stl[l].triangle;
-                  //printf("Solid %d: boundary cells are being computed...\n\n",l);
-                  for(m=0;m<solids->stl[l].ntri;m++){ // loop for each triangle
-                        //if(triangle[m].outside==0){
-                              for(q=0;q<3;q++){
-                                    v1[q]=triangle[m].p2[q]-triangle[m].p1[q]; // the vectors between nodes are defined
-                                    v2[q]=triangle[m].p3[q]-triangle[m].p2[q];
-                                    v3[q]=triangle[m].p1[q]-triangle[m].p3[q];
-                              }
-                              dp=MAX(mesh->dx,mesh->dy);
-                              dp=MAX(dp,mesh->dz);
-                              dp=_stol_*dp ; //2.0*fabs(cell[n].dx*triangle[m].nr[0]+cell[n].dy*triangle[m].nr[1]+cell[n].dz*triangle[m].nr[2])/triangle[m].absnr;
-                              //dp=_stol_*mesh->dx;
-
-                              //loop over cells inside the bounding box of the triangle
-                              for(i=triangle[m].imin[0];i<=triangle[m].imax[0];i++){
-                                    for(j=triangle[m].imin[1];j<=triangle[m].imax[1];j++){
-                                          for(k=triangle[m].imin[2];k<=triangle[m].imax[2];k++){
-                                                //printf("triangle %d, cell (%d %d %d) \n",m,i,j,k);
-                                                n= mesh->xcells*j + i + k*mesh->xcells*mesh->ycells;
-                                                dif[0]=cell[n].xc-triangle[m].p1[0]; //vector from cell center to node P1 (x-component)
-                                                dif[1]=cell[n].yc-triangle[m].p1[1]; //vector from cell center to node P1 (y-component)
-                                                dif[2]=cell[n].zc-triangle[m].p1[2]; //vector from cell center to node P1 (z-component)
-                                                proj=dif[0]*triangle[m].nr[0]+dif[1]*triangle[m].nr[1]+dif[2]*triangle[m].nr[2]; //vector from cell center to triangle P1, projected onto normal direction
-                                                dist=proj/triangle[m].absnr;
-                                                if (proj>0 && cell[n].ghost>0 && fabs(dist)<cell[n].distabs){ // if a cell has been tagged as "ghost" and is now found outside of other triangle, it is reverted as "fluid cell"
-                                                      cell[n].ghost=0;
-                                                }
-                                                if (proj<=0&&cell[n].out<1) { //when proj<0 and the cell is not already outside of other triangle, the cell center is inside the solid (below the surface)
-                                                      if (fabs(dist)<dp) {
-                                                            xc[0]=cell[n].xc - dist*triangle[m].nr[0]; //Formula: Xc = Xcell - proj * n / abs(n) allows to compute the intersection point on the triangle, xc
-                                                            xc[1]=cell[n].yc - dist*triangle[m].nr[1];
-                                                            xc[2]=cell[n].zc - dist*triangle[m].nr[2];
-
-                                                            // Below, the point-in-triangle algorithm (3D version) is used to detect if the intersection point, xc, is inside the triangle
-                                                            for(q=0;q<3;q++){
-                                                                  dc1[q]=xc[q]-triangle[m].p1[q];
-                                                                  dc2[q]=xc[q]-triangle[m].p2[q];
-                                                                  dc3[q]=xc[q]-triangle[m].p3[q];
-                                                            }
-
-                                                            vector_product(v1,dc1,vp1); // the point-in-triangle algorithm  is based on cross products to determine whether point is inside or not
-                                                            vector_product(v2,dc2,vp2);
-                                                            vector_product(v3,dc3,vp3);
-
-                                                            s1=dot_product(vp1,vp2);
-                                                            s2=dot_product(vp2,vp3);
-                                                            s3=dot_product(vp3,vp1);
-
-                                                            if (s1>0 && s2>0 &&  s3>0) { // when all are positive (same vector product direction), the point xc is inside the triangle
-                                                                  //cell[n].type=0;
-                                                                  if(fabs(dist)<cell[n].distabs){  // the condition before may happen for many triangles, so we keep the closest to the interface
-                                                                        cell[n].ghost=1;
-                                                                        cell[n].solid_id=l;
-                                                                        cell[n].triangle_id=m;
-                                                                        cell[n].tri=&(triangle[m]);
-                                                                        if(fabs(dist)<TOL14){
-                                                                              dist=-TOL14; //to ensure negativity of dist, that might be zero and therefore +-0
-                                                                        }
-                                                                        cell[n].distabs=fabs(dist);
-                                                                        //printf("triangle %14.14e \n",dist);
-                                                                        cell[n].xim = xc[0] - dist*triangle[m].nr[0];
-                                                                        cell[n].yim = xc[1] - dist*triangle[m].nr[1];
-                                                                        cell[n].zim = xc[2] - dist*triangle[m].nr[2];
-                                                                  }
-                                                            }
-                                                      }
-
-                                                }else{
-                                                            cell[n].out=1;
-
-                                                }
-
-                                          }
-                                    }
-                              }
-                              //getchar();
-
-                        //}
-
-                  }
-            }
-
-            //printf("%s Ghost cells have been identified \n\n",OK);
-
-
-            for(l=0;l<solids->nsolid;l++){ //loop over cells inside the solid bounding box
-                  for(i=solids->stl[l].imin[0];i<=solids->stl[l].imax[0];i++){
-                              for(j=solids->stl[l].imin[1];j<=solids->stl[l].imax[1];j++){
-                                    for(k=solids->stl[l].imin[2];k<=solids->stl[l].imax[2];k++){
-
-                                          n= mesh->xcells*j + i + k*mesh->xcells*mesh->ycells;
-                                          if(cell[n].ghost!=1){
-
-                                                solx=0;
-                                                soly=0;
-                                                solz=0;
-
-                                                df0=mesh->xcells;
-                                                q=-1;
-                                                ct=0; // we define a counter and only if ct is greater or equal to 2, solids are defined, to prevent from individual ghost cells generating solid lines
-                                                for (i1=0;i1<mesh->xcells;i1++){ //loop over lines to determine the closest interface to a point, in x-direction
-                                                      na=mesh->xcells*j + i1 + k*mesh->xcells*mesh->ycells;
-                                                      if(cell[na].ghost==1){
-                                                            ct+=1; //counter to check the number of ghost cells in a line
-                                                            df=abs(i1-i); //distance from i1 to i
-                                                            if(df<=df0){
-                                                                  df0=df;
-                                                                  q=na; //this is the index of the nearest ghost cell to cell n
-                                                            }
-                                                      }
-                                                }
-                                                if(q>-1&&ct>1){
-                                                      aux1=cell[q].xc-cell[n].xc;
-                                                      aux2=aux1*cell[q].tri->nr[0];
-                                                      if(aux2>0.0){ //when the vector points out the surface, the cell is inside
-                                                            solx=1;//cell[n].type=0;
-                                                      }
-                                                }
-
-                                                //if(cell[n].xc>0.75&&cell[n].type==0){
-                                                //      printf("cell %d: q is %d, located at x=%lf \n",n,q,cell[q].xc);
-                                                //      printf("ny=%lf \n",cell[q].tri->nr[0]);
-                                                //      getchar();
-                                                //}
-
-                                                //same than above, for "y"
-                                                if(cell[n].type!=0){
-                                                df0=mesh->ycells;
-                                                q=-1;
-                                                ct=0;
-                                                for (i2=0;i2<mesh->ycells;i2++){
-                                                      na=mesh->xcells*i2 + i + k*mesh->xcells*mesh->ycells;
-                                                      if(cell[na].ghost==1){
-                                                            ct+=1;
-                                                            df=abs(i2-j);
-                                                            if(df<=df0){
-                                                                  df0=df;
-                                                                  q=na;
-                                                            }
-                                                      }
-                                                }
-                                                if(q>-1&&ct>1){
-                                                      aux1=cell[q].yc-cell[n].yc;
-                                                      aux2=aux1*cell[q].tri->nr[1];
-                                                      if(aux2>0.0){
-                                                            soly=1;//cell[n].type=0;
-                                                      }
-                                                }
-                                                }
-
-                                                //same than above, for "z"
-                                                if(cell[n].type!=0){
-                                                df0=mesh->zcells;
-                                                q=-1;
-                                                ct=0;
-                                                for (i3=0;i3<mesh->zcells;i3++){
-                                                      na=mesh->xcells*j + i + i3*mesh->xcells*mesh->ycells;
-                                                      if(cell[na].ghost==1){
-                                                            ct+=1;
-                                                            df=abs(i3-k);
-                                                            if(df<=df0){
-                                                                  df0=df;
-                                                                  q=na;
-                                                            }
-                                                      }
-                                                }
-                                                if(q>-1&&ct>1){
-                                                      aux1=cell[q].zc-cell[n].zc;
-                                                      aux2=aux1*cell[q].tri->nr[2];
-                                                      if(aux2>0.0){
-                                                            solz=1;//cell[n].type=0;
-                                                      }
-                                                }
-                                                }
-
-                                                if(solx==1&&soly==1){ //when intersections are detected in X and Y ray tracing, then the cell is set as solid.
-                                                      cell[n].type=0;
-                                                }
-
-
-                                          }
-
-                                    }
-
-                              }
-
-                  }
+      }else{
 
+            tag_ghost_cells(mesh,solids);
 
-            }
+            classify_solid_cells(mesh,solids);
 
-            //looking for orphan cells
+            //looking for orphan cells. The cells are updated in place, so this pass is kept serial
             for(l=0;l<solids->nsolid;l++){ //loop over cells inside the solid bounding box
                   for(i=solids->stl[l].imin[0];i<=solids->stl[l].imax[0];i++){
                               for(j=solids->stl[l].imin[1];j<=solids->stl[l].imax[1];j++){
@@ -1064,23 +989,10 @@ int assign_cell_type(t_mesh *mesh,t_solid *solids){ // Define ghost and solid ce
 
                                           ct=0;
                                           if(cell[n].type==0){
-                                                if(cell[n].w1->cellL->type==0){
-                                                      ct+=1;
-                                                }
-                                                if(cell[n].w2->cellR->type==0){
-                                                      ct+=1;
-                                                }
-                                                if(cell[n].w3->cellR->type==0){
-                                                      ct+=1;
-                                                }
-                                                if(cell[n].w4->cellL->type==0){
-                                                      ct+=1;
-                                                }
-                                                if(cell[n].w5->cellL->type==0){
-                                                      ct+=1;
-                                                }
-                                                if(cell[n].w6->cellR->type==0){
-                                                      ct+=1;
+                                                for(q=1;q<=6;q++){
+                                                      if(cell[cell_neighbour(mesh,n,q)].type==0){
+                                                            ct+=1;
+                                                      }
                                                 }
                                                 //if(ct<2||cell[n].out==1){ //when a solid cell has only ONE solid neighbor OR it is ouside the surface, it is re-converted to fluid cell.
                                                 if(ct<2){ //when a solid cell has only ONE solid neighbor, it is re-converted to fluid cell.
@@ -1097,43 +1009,10 @@ int assign_cell_type(t_mesh *mesh,t_solid *solids){ // Define ghost and solid ce
                   }
             }
 
-            //printf("%s Solid cells have been identified \n\n",OK);
-
-
-      // distance from all cells to the closest solid cell, in the cartesian directions, is computed
-      for(k=0;k<mesh->ncells;k++){
-            if(cell[k].type!=0){
-            m=cell[k].m;
-            n=cell[k].n;
-            for (l=0;l<mesh->xcells;l++){
-                  na = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-                  if(cell[na].type==0){
-                        cell[k].distsolx=MIN(cell[k].distsolx,abs(cell[k].l-l))  ;
-                  }
-            }
-            l=cell[k].l;
-            n=cell[k].n;
-            for (m=0;m<mesh->ycells;m++){
-                  na = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-                  if(cell[na].type==0){
-                        cell[k].distsoly=MIN(cell[k].distsoly,abs(cell[k].m-m)) ;
-                  }
-            }
-            l=cell[k].l;
-            m=cell[k].m;
-            for (n=0;n<mesh->zcells;n++){
-                  na = l + m*mesh->xcells + n*mesh->xcells*mesh->ycells;
-                  if(cell[na].type==0){
-                        cell[k].distsolz=MIN(cell[k].distsolz,abs(cell[k].n-n)) ;
-                  }
-            }
-            //if(cell[k].distsoly<100){
-            //      printf("celda %d, dist: %d \n",k,cell[k].distsoly);
-            //}
-
-            }
-      }
-
+            // distance from all cells to the closest solid cell, in the cartesian directions, is computed
+            solid_distance(mesh,0);
+            solid_distance(mesh,1);
+            solid_distance(mesh,2);
 
       }
 
@@ -1145,164 +1024,284 @@ int assign_cell_type(t_mesh *mesh,t_solid *solids){ // Define ghost and solid ce
 }
 
 int update_stencils(t_mesh *mesh,t_sim *sim){
-	int l,m,n,k,p,k2d;
-	int xcells,ycells,zcells;
+	int k;
 	t_cell *cell;
 
-	int semiSt; //auxiliar variable to recalculate boundary cells stencil
-
-	//Cells
-	xcells=mesh->xcells;
-	ycells=mesh->ycells;
-      zcells=mesh->zcells;
 	cell=mesh->cell;
 
-
       //Set cell stencils
-	//Initially all the cells have a stencil of size order
+	//All the cells have a stencil of size order: near the boundaries of the domain, the pencils
+	//are padded with ghost cells (see fill_ghost_cells()). Stencils are only reduced near solids
+#pragma omp parallel for default(none) shared(mesh,sim,cell) schedule(static)
 	for(k=0;k<mesh->ncells;k++){
 		cell[k].st_sizeX=sim->order;
 		cell[k].st_sizeY=sim->order;
-            cell[k].st_sizeZ=sim->order;
-	}
-
-	//But there are special cases at boundary cells
-	semiSt=(sim->order-1)*0.5;
-      for(n=0;n<zcells;n++){
-            for(m=0;m<ycells;m++){
-                  for(l=0;l<xcells;l++){
-                        k = l + m*xcells + n*xcells*ycells;
-                        k2d=l + m*xcells;
-                        if(mesh->periodicX==0){
-                              //x setencils
-                              if(l<semiSt){
-                                    cell[k].st_sizeX=MIN(cell[k].st_sizeX,2*l+1); //poner if elseif else y añadir en todas min(st_size,dist*2+1)
-                              }else if(xcells-(l+1)<semiSt){
-                                    cell[k].st_sizeX=MIN(cell[k].st_sizeX,2*(xcells-(l+1))+1);
-                              }
-                              cell[k].st_sizeX=MIN(cell[k].st_sizeX,2*cell[k].distsolx-1);
-
-                        }
-                        if(mesh->periodicY==0){
-                              //y stencils
-                              if(m<semiSt){
-                                    cell[k].st_sizeY=MIN(cell[k].st_sizeY,2*m+1);
-                              }else if(ycells-(m+1)<semiSt){
-                                    cell[k].st_sizeY=MIN(cell[k].st_sizeY,2*(ycells-(m+1))+1);
-                              }
-                              cell[k].st_sizeY=MIN(cell[k].st_sizeY,2*cell[k].distsoly-1);
-                        }
-                        if(mesh->periodicZ==0){
-                              //y stencils
-                              if(n<semiSt){
-                                    cell[k].st_sizeZ=MIN(cell[k].st_sizeZ,2*n+1);
-                              }else if(zcells-(n+1)<semiSt){
-                                    cell[k].st_sizeZ=MIN(cell[k].st_sizeZ,2*(zcells-(n+1))+1);
-                              }
-                              cell[k].st_sizeZ=MIN(cell[k].st_sizeZ,2*cell[k].distsolz-1);
-                        }
-				
-				if(mesh->xcells<sim->order){cell[k].st_sizeX=1;}
-				if(mesh->ycells<sim->order){cell[k].st_sizeY=1;}
-				if(mesh->zcells<sim->order){cell[k].st_sizeZ=1;}
-					
-                  }
-            }
-	}
-	//Initialization of cell stencils
-	for(k=0;k<mesh->ncells;k++){
-		for(p=0;p<9;p++){
-			cell[k].stX[p]=-1;
-			cell[k].stY[p]=-1;
-                  cell[k].stZ[p]=-1;
+		cell[k].st_sizeZ=sim->order;
+#if ALLOW_SOLIDS
+		if(mesh->periodicX==0){
+			cell[k].st_sizeX=MIN(cell[k].st_sizeX,2*cell[k].distsolx-1);
+		}
+		if(mesh->periodicY==0){
+			cell[k].st_sizeY=MIN(cell[k].st_sizeY,2*cell[k].distsoly-1);
 		}
+		if(mesh->periodicZ==0){
+			cell[k].st_sizeZ=MIN(cell[k].st_sizeZ,2*cell[k].distsolz-1);
+		}
+#endif
+
+		//Directions with fewer cells than the stencil are reconstructed at first order
+		if(mesh->gxcells<sim->order){cell[k].st_sizeX=1;}
+		if(mesh->gycells<sim->order){cell[k].st_sizeY=1;}
+		if(mesh->gzcells<sim->order){cell[k].st_sizeZ=1;}
 	}
 
-      for(n=0;n<zcells;n++){
-            for(m=0;m<ycells;m++){
-                  for(l=0;l<xcells;l++){
+      return 1;
 
-                        k = l + m*xcells + n*xcells*ycells;
-                        k2d=l + m*xcells;
+}
 
-                        //x setencils
-                        for(p=0;p<cell[k].st_sizeX;p++){
-                              if(mesh->periodicX==0){
-                                    cell[k].stX[p]=l-((cell[k].st_sizeX-1)/2)+p;
-                              }else{
-                                    cell[k].stX[p]=l-((cell[k].st_sizeX-1)/2)+p;
-                                    if(cell[k].stX[p]<0){
-                                          cell[k].stX[p]+=xcells*(1);
-                                    }
-                                    if(cell[k].stX[p]>xcells-1){
-                                          cell[k].stX[p]+=xcells*(-1);
 
-                                    }
+//Bounding box of a triangle in cell indices (imin, imax), extended to a stencil for small triangles, and
+//length of its normal. Triangles with a node outside of the domain are marked as outside
+static void triangle_bounds(t_mesh *mesh, t_triangle *tri, double *xmin, double *xmax){
+	int k,cells;
+	double aux1,aux2,aux3,aux4,h,L;
+
+	tri->absnr=sqrt(tri->nr[0]*tri->nr[0]+tri->nr[1]*tri->nr[1]+tri->nr[2]*tri->nr[2]);
+	tri->outside=0;
+
+	for(k=0;k<3;k++){
+		aux1=MIN(tri->p1[k],tri->p2[k]);
+		aux2=MIN(aux1,tri->p3[k]);
+		aux3=MAX(tri->p1[k],tri->p2[k]);
+		aux4=MAX(aux3,tri->p3[k]);
+		xmin[k]=aux2;
+		xmax[k]=aux4;
+
+		if(k==0){
+			h=mesh->dx; cells=mesh->xcells; L=mesh->Lx;
+		}else if(k==1){
+			h=mesh->dy; cells=mesh->ycells; L=mesh->Ly;
+		}else{
+			h=mesh->dz; cells=mesh->zcells; L=mesh->Lz;
+		}
+		tri->imin[k]= aux2/h;
+		tri->imax[k]= aux4/h;
+		if(tri->imax[k]-tri->imin[k] < MAX(mesh->sim->order-1,1)){
+			tri->imin[k] = (aux2+aux4)/(2.0*mesh->dx) - (mesh->sim->order-1)/2;
+			tri->imax[k] = tri->imin[k] + mesh->sim->order;
+		}
+		tri->imin[k]=MAX(tri->imin[k],0);
+		tri->imin[k]=MIN(tri->imin[k],cells-1);
+		tri->imax[k]=MAX(tri->imax[k],0);
+		tri->imax[k]=MIN(tri->imax[k],cells-1);
+		if(aux2<0.0||aux4>L){
+			tri->outside=1;
+		}
+	}
 
-                              }
-                              cell[k].stX[p]+=xcells*m;
-                              cell[k].stX[p]+=xcells*ycells*n;
-                        }
+}
 
 
-                        //y stencils
-                        for(p=0;p<cell[k].st_sizeY;p++){
-                              if(mesh->periodicY==0){
-                                    cell[k].stY[p]=m-((cell[k].st_sizeY-1)/2)+p;
-                              }else{
-                                    cell[k].stY[p]=m-((cell[k].st_sizeY-1)/2)+p;
-                                    if(cell[k].stY[p]<0){
-                                          cell[k].stY[p]+=ycells*(1);
-                                    }
-                                    if(cell[k].stY[p]>ycells-1){
-                                          cell[k].stY[p]+=ycells*(-1);
+//Unit normal of a triangle from its nodes (right-hand rule), for STL files that store a zero normal
+static void triangle_normal(t_triangle *tri){
+	double v1[3],v2[3],norm;
+	int q;
 
-                                    }
+	if(tri->nr[0]!=0.0||tri->nr[1]!=0.0||tri->nr[2]!=0.0){
+		return;
+	}
+	for(q=0;q<3;q++){
+		v1[q]=tri->p2[q]-tri->p1[q];
+		v2[q]=tri->p3[q]-tri->p1[q];
+	}
+	vector_product(v1,v2,tri->nr);
+	norm=sqrt(dot_product(tri->nr,tri->nr));
+	if(norm>0.0){
+		for(q=0;q<3;q++){
+			tri->nr[q]/=norm;
+		}
+	}
 
-                              }
-                              cell[k].stY[p]=xcells*cell[k].stY[p]+l;
-                              cell[k].stY[p]+=xcells*ycells*n;
-                        }
+}
 
-                        //z stencils
-                        for(p=0;p<cell[k].st_sizeZ;p++){
-                              if(mesh->periodicZ==0){
-                                    cell[k].stZ[p]=n-((cell[k].st_sizeZ-1)/2)+p;
-                              }else{
-                                    cell[k].stZ[p]=n-((cell[k].st_sizeZ-1)/2)+p;
-                                    if(cell[k].stZ[p]<0){
-                                          cell[k].stZ[p]+=zcells*(1);
-                                    }
-                                    if(cell[k].stZ[p]>zcells-1){
-                                          cell[k].stZ[p]+=zcells*(-1);
 
-                                    }
+//Binary STL: 80 bytes of header, the number of triangles (32 bits) and 50 bytes per triangle (normal
+//and nodes as floats, and 2 bytes of attributes). The file is mapped in memory and the triangles are
+//converted in parallel
+static int read_stl_binary(t_mesh *mesh, t_stl *stl, int fd, long size){
+	const unsigned char *map;
+	t_triangle *triangle;
+	float v[12];
+	double xmin[3],xmax[3];
+	double x0,y0,z0,x1,y1,z1;
+	int j,q;
+
+	map=(const unsigned char*)mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+	if(map==MAP_FAILED){
+		return 0;
+	}
+	stl->triangle=(t_triangle*)malloc(MAX(stl->ntri,1)*sizeof(t_triangle));
+	triangle=stl->triangle;
+
+	x0=y0=z0=9999999999999.0;
+	x1=y1=z1=-9999999999999.0;
+#pragma omp parallel for default(none) private(v,q,xmin,xmax) shared(mesh,stl,map,triangle) reduction(min:x0,y0,z0) reduction(max:x1,y1,z1) schedule(static)
+	for(j=0;j<stl->ntri;j++){
+		memcpy(v,map+84+50*(long)j,sizeof(v));
+		for(q=0;q<3;q++){
+			triangle[j].nr[q]=v[q];
+			triangle[j].p1[q]=v[3+q];
+			triangle[j].p2[q]=v[6+q];
+			triangle[j].p3[q]=v[9+q];
+		}
+		triangle_normal(&(triangle[j]));
+		triangle_bounds(mesh,&(triangle[j]),xmin,xmax);
+		x0=MIN(x0,xmin[0]); y0=MIN(y0,xmin[1]); z0=MIN(z0,xmin[2]);
+		x1=MAX(x1,xmax[0]); y1=MAX(y1,xmax[1]); z1=MAX(z1,xmax[2]);
+	}
+	stl->Xmin[0]=x0; stl->Xmin[1]=y0; stl->Xmin[2]=z0;
+	stl->Xmax[0]=x1; stl->Xmax[1]=y1; stl->Xmax[2]=z1;
 
-                              }
-                              cell[k].stZ[p]=ycells*xcells*cell[k].stZ[p]+k2d;
-                        }
+	munmap((void*)map,size);
+	return 1;
+}
 
 
+//Position of the next "facet" keyword of an ASCII STL file at or after p (end if there is none).
+//The "facet" of "endfacet" is skipped
+static const char *next_facet(const char *text, const char *p, const char *end){
 
+	while(p+5<end){
+		p=(const char*)memchr(p,'f',end-p-5);
+		if(p==NULL){
+			return end;
+		}
+		if(strncmp(p,"facet",5)==0&&isspace((unsigned char)p[5])&&(p==text||!isalpha((unsigned char)p[-1]))){
+			return p;
+		}
+		p++;
+	}
+	return end;
+}
 
-                  }
-            }
 
-      }
+//Reads the normal and the nodes of the facet that starts at p. Returns 0 if the facet is not complete
+static int parse_facet(const char *p, const char *end, t_triangle *tri){
+	double *x[4];
+	char *q;
+	int i,j;
+
+	x[0]=tri->nr;
+	x[1]=tri->p1;
+	x[2]=tri->p2;
+	x[3]=tri->p3;
+	p+=5;
+	while(isspace((unsigned char)*p)) p++;
+	if(strncmp(p,"normal",6)!=0){
+		return 0;
+	}
+	p+=6;
+	for(i=0;i<4;i++){
+		if(i>0){ //next vertex
+			while(p<end&&strncmp(p,"vertex",6)!=0){
+				if(strncmp(p,"endfacet",8)==0) return 0;
+				p++;
+			}
+			if(p>=end) return 0;
+			p+=6;
+		}
+		for(j=0;j<3;j++){
+			x[i][j]=strtod(p,&q);
+			if(q==p){
+				return 0;
+			}
+			p=q;
+		}
+	}
+	return 1;
+}
 
 
-      return 1;
+//ASCII STL. The file is read at once and split into chunks, which are parsed in parallel: the facets
+//of each chunk are counted first, so that each chunk knows where to store its triangles
+static int read_stl_ascii(t_mesh *mesh, t_stl *stl, int fd, long size){
+	char *text;
+	const char *p,*end,*cend;
+	t_triangle *triangle;
+	double xmin[3],xmax[3];
+	double x0,y0,z0,x1,y1,z1;
+	long *first,done;
+	int nchunks,c,j,bad;
+
+	text=(char*)malloc(size+1);
+	for(done=0;done<size;){
+		c=read(fd,text+done,size-done);
+		if(c<=0){
+			free(text);
+			return 0;
+		}
+		done+=c;
+	}
+	text[size]='\0';
+	end=text+size;
+
+	nchunks=4*omp_get_max_threads();
+	first=(long*)calloc(nchunks+1,sizeof(long));
+#pragma omp parallel for default(none) private(p,cend) shared(text,end,size,nchunks,first) schedule(dynamic)
+	for(c=0;c<nchunks;c++){
+		cend=text+size*(c+1)/nchunks;
+		for(p=next_facet(text,text+size*c/nchunks,end);p<cend;p=next_facet(text,p+5,end)){
+			first[c+1]++;
+		}
+	}
+	for(c=0;c<nchunks;c++){
+		first[c+1]+=first[c];
+	}
+	stl->ntri=first[nchunks];
+	stl->triangle=(t_triangle*)malloc(MAX(stl->ntri,1)*sizeof(t_triangle));
+	triangle=stl->triangle;
+
+	bad=0;
+	x0=y0=z0=9999999999999.0;
+	x1=y1=z1=-9999999999999.0;
+#pragma omp parallel for default(none) private(p,cend,j,xmin,xmax) shared(mesh,text,end,size,nchunks,first,triangle) reduction(+:bad) reduction(min:x0,y0,z0) reduction(max:x1,y1,z1) schedule(dynamic)
+	for(c=0;c<nchunks;c++){
+		cend=text+size*(c+1)/nchunks;
+		j=first[c];
+		for(p=next_facet(text,text+size*c/nchunks,end);p<cend;p=next_facet(text,p+5,end)){
+			if(parse_facet(p,end,&(triangle[j]))==0){
+				bad++;
+				memset(&(triangle[j]),0,sizeof(t_triangle));
+			}
+			triangle_normal(&(triangle[j]));
+			triangle_bounds(mesh,&(triangle[j]),xmin,xmax);
+			x0=MIN(x0,xmin[0]); y0=MIN(y0,xmin[1]); z0=MIN(z0,xmin[2]);
+			x1=MAX(x1,xmax[0]); y1=MAX(y1,xmax[1]); z1=MAX(z1,xmax[2]);
+			j++;
+		}
+	}
+	stl->Xmin[0]=x0; stl->Xmin[1]=y0; stl->Xmin[2]=z0;
+	stl->Xmax[0]=x1; stl->Xmax[1]=y1; stl->Xmax[2]=z1;
 
+	free(first);
+	free(text);
+	if(bad>0){
+		printf("%s %d facets of %s are not complete. The program will close when pressing a key.\n",ERR,bad,stl->name);
+		getchar();
+		exit(1);
+	}
+	return 1;
 }
 
 
 int read_solids(t_mesh *mesh, t_solid *solids, const char *folder_path) {
-    int i, j, k;
+    int i, k, fd, binary, ok;
+    unsigned int ntri;
+    long size;
+    struct stat st;
     FILE *fp;
     char fname[1024];
     char buffer[256];
-    double aux1, aux2, aux3, aux4;
-    t_triangle *triangle;
     t_stl *stl;
 
     snprintf(fname, sizeof(fname), "%s/solid_list.txt", folder_path);
@@ -1336,182 +1335,40 @@ int read_solids(t_mesh *mesh, t_solid *solids, const char *folder_path) {
 
         for (i = 0; i < solids->nsolid; i++) {
             snprintf(stl[i].name, sizeof(stl[i].name), "%s", solids->filename[i]);
-            fp = fopen(stl[i].name, "r");
-            if (fp == NULL) {
-                printf("Error opening file %s.\n", solids->filename[i]);
-                continue;
-            }
-
-            // Count the number of triangles
             stl[i].ntri = 0;
-            while (fgets(buffer, sizeof(buffer), fp)) {
-                if (strncmp(buffer, "facet normal", 12) == 0) {
-                    stl[i].ntri++;
-                }
-            }
-            
-            printf("The number of triangles of solid %d is  %d\n", i, stl[i].ntri);
-            
-            fseek(fp, 0, SEEK_SET); // Reset file pointer to start
-
-            stl[i].triangle = (t_triangle *)malloc(stl[i].ntri * sizeof(t_triangle));
-            triangle = stl[i].triangle;
-
-            // Initialize bounding box
+            stl[i].nver = 0;
+            stl[i].triangle = NULL;
             for (k = 0; k < 3; k++) {
                 stl[i].Xmin[k] = 9999999999999.0;
                 stl[i].Xmax[k] = -9999999999999.0;
             }
 
-            int current_triangle = 0;
-            while (fgets(buffer, sizeof(buffer), fp)) {
-                if (strncmp(buffer, "facet normal", 12) == 0) {
-                    // Read the normal vector
-                    sscanf(buffer, "facet normal %lf %lf %lf",
-                           &triangle[current_triangle].nr[0],
-                           &triangle[current_triangle].nr[1],
-                           &triangle[current_triangle].nr[2]);
-
-                    // Skip the "outer loop" line
-                    if (fgets(buffer, sizeof(buffer), fp) == NULL) {
-                        fprintf(stderr, "Error or premature end of file when reading 'outer loop'\n");
-                        break;
-                    }
-
-                    // Read the first vertex
-                    if (fgets(buffer, sizeof(buffer), fp) != NULL) {
-                        sscanf(buffer, " %*s %lf %lf %lf",
-                               &triangle[current_triangle].p1[0],
-                               &triangle[current_triangle].p1[1],
-                               &triangle[current_triangle].p1[2]);
-                    } else {
-                        fprintf(stderr, "Error or premature end of file when reading first vertex\n");
-                        break;
-                    }
-
-                    // Read the second vertex
-                    if (fgets(buffer, sizeof(buffer), fp) != NULL) {
-                        sscanf(buffer, " %*s %lf %lf %lf",
-                               &triangle[current_triangle].p2[0],
-                               &triangle[current_triangle].p2[1],
-                               &triangle[current_triangle].p2[2]);
-                    } else {
-                        fprintf(stderr, "Error or premature end of file when reading second vertex\n");
-                        break;
-                    }
-
-                    // Read the third vertex
-                    if (fgets(buffer, sizeof(buffer), fp) != NULL) {
-                        sscanf(buffer, " %*s %lf %lf %lf",
-                               &triangle[current_triangle].p3[0],
-                               &triangle[current_triangle].p3[1],
-                               &triangle[current_triangle].p3[2]);
-                    } else {
-                        fprintf(stderr, "Error or premature end of file when reading third vertex\n");
-                        break;
-                    }
-
-                    // Skip the "endloop" line
-                    if (fgets(buffer, sizeof(buffer), fp) == NULL) {
-                        fprintf(stderr, "Error or premature end of file when reading 'endloop'\n");
-                        break;
-                    }
-
-                    // Skip the "endfacet" line
-                    if (fgets(buffer, sizeof(buffer), fp) == NULL) {
-                        fprintf(stderr, "Error or premature end of file when reading 'endfacet'\n");
-                        break;
-                    }
-
-                    // Move to the next triangle
-                    current_triangle++;
-                }
+            // Binary STL files are recognized by their size (84 bytes + 50 bytes per triangle), since
+            // many of them also start with "solid"
+            fd = open(stl[i].name, O_RDONLY);
+            if (fd < 0 || fstat(fd, &st) != 0) {
+                printf("Error opening file %s.\n", solids->filename[i]);
+                if (fd >= 0) close(fd);
+                continue;
             }
-  
-
-            fclose(fp);
-            
-            for(j=0;j<solids->stl[i].ntri;j++){
-                printf("Normal %lf %lf %lf \n",triangle[j].nr[0], triangle[j].nr[1], triangle[j].nr[2]);
-                printf("vertex %lf %lf %lf \n",triangle[j].p1[0], triangle[j].p1[1], triangle[j].p1[2]);
-                printf("vertex %lf %lf %lf \n",triangle[j].p2[0], triangle[j].p2[1], triangle[j].p2[2]);
-                printf("vertex %lf %lf %lf \n",triangle[j].p3[0], triangle[j].p3[1], triangle[j].p3[2]);
+            size = st.st_size;
+            binary = 0;
+            if (size >= 84 && pread(fd, &ntri, sizeof(ntri), 80) == sizeof(ntri) && size == 84 + 50 * (long)ntri) {
+                binary = 1;
+                stl[i].ntri = ntri;
+                ok = read_stl_binary(mesh, &(stl[i]), fd, size);
+            } else {
+                ok = read_stl_ascii(mesh, &(stl[i]), fd, size);
             }
-
-            // Process triangles
-            for (j = 0; j < stl[i].ntri; j++) {
-                triangle[j].absnr = sqrt(triangle[j].nr[0] * triangle[j].nr[0] + triangle[j].nr[1] * triangle[j].nr[1] + triangle[j].nr[2] * triangle[j].nr[2]);
-                triangle[j].outside = 0;
-
-                  for(k=0;k<3;k++){
-                        aux1=MIN(triangle[j].p1[k],triangle[j].p2[k]);
-                        aux2=MIN(aux1,triangle[j].p3[k]);
-                        stl[i].Xmin[k]=MIN(aux2,stl[i].Xmin[k]);
-
-                        aux3=MAX(triangle[j].p1[k],triangle[j].p2[k]);
-                        aux4=MAX(aux3,triangle[j].p3[k]);
-                        stl[i].Xmax[k]=MAX(aux4,stl[i].Xmax[k]);
-
-
-
-                        if(k==0){
-                              triangle[j].imin[k]= aux2/mesh->dx;// DEBERIAMOS CONSIDERAR UN dx/2 
-                              triangle[j].imax[k]= aux4/mesh->dx;
-                              if(triangle[j].imax[k]-triangle[j].imin[k] < MAX(mesh->sim->order-1,1)){
-                                    triangle[j].imin[k] = (aux2+aux4)/(2.0*mesh->dx) - (mesh->sim->order-1)/2;
-                                    triangle[j].imax[k] = triangle[j].imin[k] + mesh->sim->order;
-                                    //printf("triangle %d: dif %d   \n\n", j,triangle[j].imax[k]-triangle[j].imin[k]);
-                                    //printf("triangle %d: %d %d  \n\n", j,triangle[j].imin[k],triangle[j].imax[k]);
-                              }
-                              triangle[j].imin[k]=MAX(triangle[j].imin[k],0);                   // to do: poner flag si el triangulo esta fuera, para sacarlo del calculo, y quitar esos min/max. Poner una minima separacion entre imin/imax
-                              triangle[j].imin[k]=MIN(triangle[j].imin[k],mesh->xcells-1);
-                              triangle[j].imax[k]=MAX(triangle[j].imax[k],0);
-                              triangle[j].imax[k]=MIN(triangle[j].imax[k],mesh->xcells-1);
-                              if(aux2<0.0||aux4>mesh->Lx){
-                                    triangle[j].outside=1;
-                              }
-                              //printf("triangle %d: %lf %lf  \n", j,aux2,aux4);
-                              //printf("triangle %d: %d %d  \n\n", j,triangle[j].imin[k],triangle[j].imax[k]);
-                        }else if(k==1){
-                              triangle[j].imin[k]= aux2/mesh->dy;
-                              triangle[j].imax[k]= aux4/mesh->dy;
-                              if(triangle[j].imax[k]-triangle[j].imin[k] < MAX(mesh->sim->order-1,1)){
-                                    triangle[j].imin[k] = (aux2+aux4)/(2.0*mesh->dx) - (mesh->sim->order-1)/2;
-                                    triangle[j].imax[k] = triangle[j].imin[k] + mesh->sim->order;
-                              }
-                              triangle[j].imin[k]=MAX(triangle[j].imin[k],0);
-                              triangle[j].imin[k]=MIN(triangle[j].imin[k],mesh->ycells-1);
-                              triangle[j].imax[k]=MAX(triangle[j].imax[k],0);
-                              triangle[j].imax[k]=MIN(triangle[j].imax[k],mesh->ycells-1);
-                              if(aux2<0.0||aux4>mesh->Ly){
-                                    triangle[j].outside=1;
-                              }
-                              //printf("triangle %d: %lf %lf  \n", j,aux2,aux4);
-                              //printf("triangle %d: %d %d  \n", j,triangle[j].imin[k],triangle[j].imax[k]);
-                        }else{
-                              triangle[j].imin[k]= aux2/mesh->dz;
-                              triangle[j].imax[k]= aux4/mesh->dz;
-                              if(triangle[j].imax[k]-triangle[j].imin[k] < MAX(mesh->sim->order-1,1)){
-                                    triangle[j].imin[k] = (aux2+aux4)/(2.0*mesh->dx) - (mesh->sim->order-1)/2;
-                                    triangle[j].imax[k] = triangle[j].imin[k] + mesh->sim->order;
-                              }
-                              triangle[j].imin[k]=MAX(triangle[j].imin[k],0);
-                              triangle[j].imin[k]=MIN(triangle[j].imin[k],mesh->zcells-1);
-                              triangle[j].imax[k]=MAX(triangle[j].imax[k],0);
-                              triangle[j].imax[k]=MIN(triangle[j].imax[k],mesh->zcells-1);
-                              if(aux2<0.0||aux4>mesh->Lz){
-                                    triangle[j].outside=1;
-                              }
-                              //printf("triangle %d: %lf %lf  \n", j,aux2,aux4);
-                              //printf("triangle %d: %d %d  \n", j,triangle[j].imin[k],triangle[j].imax[k]);
-                        }
-                        //triangle[j].imin[k]=(int)
-
-                  }
-                  //printf("triangle %d: %d \n", j,triangle[j].outside);
-
+            close(fd);
+            if (ok == 0) {
+                printf("%s %s could not be read. The program will close when pressing a key.\n", ERR, stl[i].name);
+                getchar();
+                exit(1);
             }
-            //getchar();
+            stl[i].nver = 3 * stl[i].ntri;
+
+            printf("The number of triangles of solid %d is  %d (%s STL)\n", i, stl[i].ntri, binary ? "binary" : "ASCII");
 
             for(k=0;k<3;k++){
                   if(k==0){
@@ -1521,8 +1378,6 @@ int read_solids(t_mesh *mesh, t_solid *solids, const char *folder_path) {
                         stl[i].imin[k]=MIN(stl[i].imin[k],mesh->xcells-1);
                         stl[i].imax[k]=MAX(stl[i].imax[k],0);
                         stl[i].imax[k]=MIN(stl[i].imax[k],mesh->xcells-1);
-                        //printf("stl %d: %lf %lf  \n", i,aux2,aux4);
-                        //printf("stl %d: %d %d  \n", i,stl[i].imin[k],stl[i].imax[k]);
                   }else if(k==1){
                         stl[i].imin[k]= stl[i].Xmin[k]/mesh->dy;
                         stl[i].imax[k]= stl[i].Xmax[k]/mesh->dy;
@@ -1530,8 +1385,6 @@ int read_solids(t_mesh *mesh, t_solid *solids, const char *folder_path) {
                         stl[i].imin[k]=MIN(stl[i].imin[k],mesh->ycells-1);
                         stl[i].imax[k]=MAX(stl[i].imax[k],0);
                         stl[i].imax[k]=MIN(stl[i].imax[k],mesh->ycells-1);
-                        //printf("stl %d: %lf %lf  \n", i,aux2,aux4);
-                        //printf("stl %d: %d %d  \n", i,stl[i].imin[k],stl[i].imax[k]);
                   }else{
                         stl[i].imin[k]= stl[i].Xmin[k]/mesh->dz;
                         stl[i].imax[k]= stl[i].Xmax[k]/mesh->dz;
@@ -1539,8 +1392,6 @@ int read_solids(t_mesh *mesh, t_solid *solids, const char *folder_path) {
                         stl[i].imin[k]=MIN(stl[i].imin[k],mesh->zcells-1);
                         stl[i].imax[k]=MAX(stl[i].imax[k],0);
                         stl[i].imax[k]=MIN(stl[i].imax[k],mesh->zcells-1);
-                        //printf("stl %d: %lf %lf  \n", i,aux2,aux4);
-                        //printf("stl %d: %d %d  \n", i,stl[i].imin[k],stl[i].imax[k]);
                   }
             }
             printf(" The bounding box of solid %d is: \n (x,y,z)_min=(%lf,%lf,%lf)\n (x,y,z)_max=(%lf,%lf,%lf) \n", i,solids->stl[i].Xmin[0],solids->stl[i].Xmin[1],solids->stl[i].Xmin[2],solids->stl[i].Xmax[0],solids->stl[i].Xmax[1],solids->stl[i].Xmax[2]);
@@ -1754,78 +1605,12 @@ int read_solids_txt(t_mesh *mesh,t_solid *solids, const char *folder_path){
 	return 1;
 }
 
-void set_velocity_field(t_mesh *mesh, t_sim *sim){
-	/**This is only for linear transport and
-	 * it only works with rho = 1.0
-	 * */
-
-	int i;
-	t_wall *wall;
-	t_cell *cell;
-	double lambda_max,dl;
-	double rho;
-
-	rho=1.0;
-	cell=mesh->cell;
-	for(i=0;i<mesh->ncells;i++){
-		cell->U[0]=rho;
-		cell++;
-	}
-	lambda_max=0.0;
-	wall=mesh->wall;
-	for(i=0;i<mesh->nwalls;i++){
-            if(wall->nx<TOL4 && wall->nz<TOL4){
-            //y-wall
-                  wall->fR_star[0]=(wall->cellR->U[2]+wall->cellL->U[2])*0.5;
-                  wall->fL_star[0]= wall->fR_star[0];
-            }else if (wall->nz<TOL4) {
-                  //x-wall
-                  wall->fR_star[0]=(wall->cellR->U[1]+wall->cellL->U[1])*0.5;
-                  wall->fL_star[0]= wall->fR_star[0];
-            }else{
-                  //z-wall
-                  wall->fR_star[0]=(wall->cellR->U[3]+wall->cellL->U[3])*0.5;
-                  wall->fL_star[0]= wall->fR_star[0];
-            }
-
-		lambda_max=MAX(lambda_max,wall->fR_star[0]);
-		wall++;
-	}
-
-	dl=MIN(mesh->dx,mesh->dy);
-
-	sim->dt=sim->CFL*dl/lambda_max;
-
-}
-
-void set_velocity(t_mesh *mesh, t_sim *sim){
-
-	int i;
-	t_wall *wall;
-
-	wall=mesh->wall;
-	for(i=0;i<mesh->nwalls;i++){
-            if(wall->nx<TOL4 && wall->nz<TOL4){
-            //y-wall
-                  wall->vel=mesh->u_y;
-            }else if (wall->nz<TOL4) {
-                  //x-wall
-                  wall->vel=mesh->u_x;
-            }else{
-                  //z-wall
-                  wall->vel=mesh->u_z;
-            }
-
-		wall++;
-	}
-
-}
-
-
 void read_config(t_mesh *mesh, t_sim *sim, const char *folder_path){
 	
 	FILE *file_input;
-	char fname[1024],errormsg[1024];
+	char fname[1024],errormsg[1024],key[1024];
+	int *param;
+	double *dparam;
 	
 	sprintf(errormsg,"Read error in configure.input \n");
 	
@@ -1859,6 +1644,60 @@ void read_config(t_mesh *mesh, t_sim *sim, const char *folder_path){
 	if (fscanf(file_input, "%*s %lf", &mesh->u_x) != 1) { printf("%s",errormsg); }
 	if (fscanf(file_input, "%*s %lf", &mesh->u_y) != 1) { printf("%s",errormsg); }
 	if (fscanf(file_input, "%*s %lf", &mesh->u_z) != 1) { printf("%s",errormsg); }
+
+	//Optional parameters, given as pairs (name value) after the mandatory ones. Lines starting
+	//with / are section headers. The default values are given in definitions.h
+	sim->rk_scheme=0;
+	sim->eq_system=EQUATION_SYSTEM;
+	sim->solver=SOLVER;
+	sim->type_rec=TYPE_REC;
+	sim->rec_vars=REC_VARIABLES;
+	sim->st=ST;
+	sim->multicomponent=MULTICOMPONENT;
+	sim->print_rho=print_RHO;
+	sim->print_velocity=print_VELOCITY;
+	sim->print_energy=print_ENERGY;
+	sim->print_pressure=print_PRESSURE;
+	sim->print_overpressure=print_OVERPRESSURE;
+	sim->print_solutes=print_SOLUTES;
+	sim->print_potentialtem=print_POTENTIALTEM;
+	sim->vtk_format=VTK_FORMAT;
+	sim->checkpoint_time=0.0;
+	sim->checkpoint_walltime=0.0;
+	sim->restart=0;
+	while(fscanf(file_input, "%1023s", key) == 1){
+		if(key[0]=='/'){
+			continue;
+		}
+		param=NULL;
+		if(strcmp(key,"TimeScheme")==0) param=&sim->rk_scheme;
+		if(strcmp(key,"EquationSystem")==0) param=&sim->eq_system;
+		if(strcmp(key,"Solver")==0) param=&sim->solver;
+		if(strcmp(key,"Reconstruction")==0) param=&sim->type_rec;
+		if(strcmp(key,"ReconstructionVariables")==0) param=&sim->rec_vars;
+		if(strcmp(key,"SourceTerm")==0) param=&sim->st;
+		if(strcmp(key,"Multicomponent")==0) param=&sim->multicomponent;
+		if(strcmp(key,"PrintRho")==0) param=&sim->print_rho;
+		if(strcmp(key,"PrintVelocity")==0) param=&sim->print_velocity;
+		if(strcmp(key,"PrintEnergy")==0) param=&sim->print_energy;
+		if(strcmp(key,"PrintPressure")==0) param=&sim->print_pressure;
+		if(strcmp(key,"PrintOverpressure")==0) param=&sim->print_overpressure;
+		if(strcmp(key,"PrintSolutes")==0) param=&sim->print_solutes;
+		if(strcmp(key,"PrintPotentialTemperature")==0) param=&sim->print_potentialtem;
+		if(strcmp(key,"VTKFormat")==0) param=&sim->vtk_format;
+		if(strcmp(key,"Restart")==0) param=&sim->restart;
+		dparam=NULL;
+		if(strcmp(key,"CheckpointTime")==0) dparam=&sim->checkpoint_time;
+		if(strcmp(key,"CheckpointWallTime")==0) dparam=&sim->checkpoint_walltime;
+		if(param!=NULL){
+			if (fscanf(file_input, "%d", param) != 1) { printf("%s",errormsg); }
+		}else if(dparam!=NULL){
+			if (fscanf(file_input, "%lf", dparam) != 1) { printf("%s",errormsg); }
+		}else{
+			printf("%s Unknown parameter %s in configure.input will be ignored\n",WAR,key);
+			if (fscanf(file_input, "%*s") != 0) { printf("%s",errormsg); }
+		}
+	}
       fclose(file_input);
 
 }
@@ -1874,15 +1713,18 @@ void print_info(t_mesh *mesh, t_sim *sim, const char *folder_path){
       printf(" \n");
       printf(" \e[4mSIMULATION SETUP:\e[0m\n");
 	printf(" Folder path: %s \n",folder_path);
-#if TYPE_REC==0
+	if(sim->type_rec==0){
 	printf(" WENO reconstruction of order %d is chosen. \n",sim->order);
-#endif
-#if TYPE_REC==1
+	}
+	if(sim->type_rec==1){
 	printf(" TENO reconstruction of order %d is chosen. \n",sim->order);
-#endif
-#if TYPE_REC==2
+	}
+	if(sim->type_rec==2){
 	printf("%s UWC (optimal weights) reconstruction of order %d is chosen. \n",WAR,sim->order);
-#endif
+	}
+	if(sim->rec_vars==1&&sim->eq_system==2){
+	printf(" The primitive variables are reconstructed. \n");
+	}
       printf(" Final time: %lf\n",sim->tf);
       printf(" CFL: %lf\n",sim->CFL);
       printf(" Number of cells X: %d\n",mesh->xcells);
@@ -1896,35 +1738,68 @@ void print_info(t_mesh *mesh, t_sim *sim, const char *folder_path){
       printf(" Face_4(-x): %d \n",mesh->bc[3]);
       printf(" Face_5(-z): %d \n",mesh->bc[4]);
       printf(" Face_6(+z): %d \n",mesh->bc[5]);
-#if EQUATION_SYSTEM == 0
+      if(sim->eq_system == 0){
       printf("%s LINEAR TRANPORT IS ACTIVE. \n",WAR);
       printf(" Linear transport velocity: \n");
       printf(" u_x: %lf \n",mesh->u_x);
       printf(" u_y: %lf \n",mesh->u_y);
       printf(" u_z: %lf \n",mesh->u_z);
-#endif
+      }
 
       printf(" \n");
 
       printf("%s Configuration file has been read \n",OK);
 
-#if ST!=1&&SOLVER==2
+	if(sim->eq_system<0||sim->eq_system>2){
+	printf("%s The system of equations is not selected adequately. Press any key to exit... \n",ERR);
+	getchar();
+	exit(1);
+	}
+
+	if(sim->type_rec<0||sim->type_rec>2){
+	printf("%s The reconstruction method is not selected adequately. Press any key to exit... \n",ERR);
+	getchar();
+	exit(1);
+	}
+
+	if(sim->rec_vars<0||sim->rec_vars>1){
+	printf("%s The reconstruction variables are not selected adequately. Press any key to exit... \n",ERR);
+	getchar();
+	exit(1);
+	}
+
+	if(sim->eq_system!=2){	//Source terms and multicomponent flow only apply to the Euler equations
+	sim->st=0;
+	sim->multicomponent=0;
+	sim->rec_vars=0;
+	}
+
+	if(sim->rec_vars==1&&sim->st!=0){	//The equilibrium and its fluctuations are defined with the conserved variables
+	printf("%s The primitive variables can only be reconstructed without source terms. The conserved variables are reconstructed instead. \n",WAR);
+	sim->rec_vars=0;
+	}
+
+	if(sim->eq_system==2){
+
+	if(sim->st!=1&&sim->solver==2){
 	printf("%s HLLS solver cannot be used when ST=0, ST=2 or ST=3. Please use HLL or HLLC. Press any key to exit... \n",ERR);
 	getchar();
 	exit(1);
-#endif
+	}
 
-#if SOLVER>2
+	if(sim->solver<0||sim->solver>2||sim->st<0||sim->st>3){
 	printf("%s The solver is not selected adequately. Press any key to exit... \n",ERR);
 	getchar();
 	exit(1);
-#endif
+	}
 
-#if MULTICOMPONENT>0&&SOLVER==1
+	if(sim->multicomponent>0&&sim->solver==1){
 	printf("%s HLLC solver cannot handle multicomponent flow. Please use HLL (SOLVER = 0). Press any key to exit... \n",ERR);
 	getchar();
 	exit(1);
-#endif
+	}
+
+	}
 
       if((mesh->bc[1]==1 && mesh->bc[3]!=1)||(mesh->bc[1]!=1 && mesh->bc[3]==1)){
             printf("%s Cyclic BC in X not properly set, only one of the boundaries is set as cyclic. The program will close when pressing a key. \n",ERR);
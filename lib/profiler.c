@@ -0,0 +1,238 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - profiler.c
+
+Content:
+  -This file contains the functions of the profiler: reports of the accumulated time of each
+   phase, million cell updates per second (MCUPS) and load imbalance of the flux sweeps, and the
+   summary written at the end of the run (profile.json). With several MPI ranks, the times are
+   those of the first rank and the MCUPS are given for the whole grid
+
+*/
+
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <omp.h>
+
+
+#include "definitions.h"
+#include "structures.h"
+#include "profiler.h"
+
+
+static const char *phase_name[PROF_NPHASES]={"fluxes","reconstruction","riemann","source","rk_stage","update_cell","update_dt","ghost_cells","write_vtk","write_list","write_tke","halo_exchange","output_stage","checkpoint"};
+
+//1 for the phases timed by every thread inside the flux sweeps, 0 for those timed by the master thread
+static const int phase_threaded[PROF_NPHASES]={0,1,1,1,1,0,0,0,0,0,0,0,0,0};
+
+
+void profiler_init(t_sim *sim){
+
+	t_profiler *prof;
+
+	prof=&(sim->prof);
+#ifdef _OPENMP
+	prof->nthreads=omp_get_max_threads();
+#else
+	prof->nthreads=1;
+#endif
+	prof->time=(double*)malloc(prof->nthreads*PROF_STRIDE*sizeof(double));
+	profiler_start(sim);
+
+}
+
+
+//Resets the timers. It is called at the beginning of the time loop
+void profiler_start(t_sim *sim){
+
+	t_profiler *prof;
+	int i;
+
+	prof=&(sim->prof);
+	for(i=0;i<prof->nthreads*PROF_STRIDE;i++){
+		prof->time[i]=0.0;
+	}
+	prof->t_start=prof_time();
+	prof->t_report=prof->t_start;
+	prof->steps=0;
+	prof->steps_report=0;
+
+}
+
+
+//Total, mean and maximum over the threads of the time of a phase. The phases timed by the
+//master thread only have the total
+static void phase_stats(t_profiler *prof, int phase, double *total, double *mean, double *max){
+
+	int th;
+	double t;
+
+	*total=0.0;
+	*max=0.0;
+	for(th=0;th<prof->nthreads;th++){
+		t=prof->time[th*PROF_STRIDE+phase];
+		*total+=t;
+		*max=MAX(*max,t);
+	}
+	if(phase_threaded[phase]){
+		*mean=*total/prof->nthreads;
+	}else{
+		*mean=*total;
+	}
+
+}
+
+
+//Ratio between the maximum and the mean busy time of the threads in the flux sweeps (1 is perfect balance)
+static double sweep_imbalance(t_profiler *prof){
+
+	int th,phase;
+	double busy,sum,max;
+
+	sum=0.0;
+	max=0.0;
+	for(th=0;th<prof->nthreads;th++){
+		busy=0.0;
+		for(phase=0;phase<PROF_NPHASES;phase++){
+			if(phase_threaded[phase]){
+				busy+=prof->time[th*PROF_STRIDE+phase];
+			}
+		}
+		sum+=busy;
+		max=MAX(max,busy);
+	}
+	if(sum>0.0){
+		return max/(sum/prof->nthreads);
+	}else{
+		return 1.0;
+	}
+
+}
+
+
+//Number of cells of the whole grid (all the ranks)
+static long global_cells(t_mesh *mesh){
+
+	return (long)mesh->gxcells*mesh->gycells*mesh->gzcells;
+
+}
+
+
+static double mcups(long ncells, long steps, double time){
+
+	if(time>0.0){
+		return 1.0e-6*ncells*steps/time;
+	}else{
+		return 0.0;
+	}
+
+}
+
+
+//Screen report. It is called at each dump
+void profiler_report(t_mesh *mesh, t_sim *sim){
+
+	t_profiler *prof;
+	double now,total,mean,max;
+	int phase;
+
+	prof=&(sim->prof);
+	now=prof_time();
+
+	printf(" Wall time: %.3lf s, %ld steps. MCUPS: %.3lf (since last dump: %.3lf). Load imbalance of the sweeps: %.3lf\n",
+		now-prof->t_start,prof->steps,
+		mcups(global_cells(mesh),prof->steps,now-prof->t_start),
+		mcups(global_cells(mesh),prof->steps-prof->steps_report,now-prof->t_report),
+		sweep_imbalance(prof));
+	for(phase=0;phase<PROF_NPHASES;phase++){
+		phase_stats(prof,phase,&total,&mean,&max);
+		if(phase_threaded[phase]){
+			printf("   %-15s %10.3lf s (mean thread), %10.3lf s (max thread)\n",phase_name[phase],mean,max);
+		}else if(total>0.0){
+			printf("   %-15s %10.3lf s\n",phase_name[phase],total);
+		}
+	}
+
+	prof->t_report=now;
+	prof->steps_report=prof->steps;
+
+}
+
+
+//Final report and profile summary in JSON format, with the time of each phase per thread
+void profiler_summary(t_mesh *mesh, t_sim *sim, const char *filename){
+
+	t_profiler *prof;
+	double now,total,mean,max;
+	int phase,th;
+	FILE *fp;
+
+	prof=&(sim->prof);
+	now=prof_time();
+
+	printf("\n");
+	printf(" \e[4mPROFILE:\e[0m\n");
+	profiler_report(mesh,sim);
+	printf("   Busy time of each thread in the sweeps (s):");
+	for(th=0;th<prof->nthreads;th++){
+		total=0.0;
+		for(phase=0;phase<PROF_NPHASES;phase++){
+			if(phase_threaded[phase]){
+				total+=prof->time[th*PROF_STRIDE+phase];
+			}
+		}
+		printf(" %.3lf",total);
+	}
+	printf("\n");
+
+	if(mesh->comm->rank!=0){
+		return; //the summary is written by the first rank
+	}
+	fp=fopen(filename,"w");
+	if(fp==NULL){
+		printf("%s The profile summary could not be written in %s\n",WAR,filename);
+		return;
+	}
+	fprintf(fp,"{\n");
+	fprintf(fp,"  \"threads\": %d,\n",prof->nthreads);
+	fprintf(fp,"  \"ranks\": %d,\n",mesh->comm->nranks);
+	fprintf(fp,"  \"cells\": %ld,\n",global_cells(mesh));
+	fprintf(fp,"  \"xcells\": %d,\n  \"ycells\": %d,\n  \"zcells\": %d,\n",mesh->gxcells,mesh->gycells,mesh->gzcells);
+	fprintf(fp,"  \"order\": %d,\n",sim->order);
+	fprintf(fp,"  \"rk_stages\": %d,\n",sim->rk_steps);
+	fprintf(fp,"  \"equation_system\": %d,\n",sim->eq_system);
+	fprintf(fp,"  \"solver\": %d,\n",sim->solver);
+	fprintf(fp,"  \"reconstruction\": %d,\n",sim->type_rec);
+	fprintf(fp,"  \"steps\": %ld,\n",prof->steps);
+	fprintf(fp,"  \"wall_time\": %.6e,\n",now-prof->t_start);
+	fprintf(fp,"  \"mcups\": %.6e,\n",mcups(global_cells(mesh),prof->steps,now-prof->t_start));
+	fprintf(fp,"  \"load_imbalance\": %.6e,\n",sweep_imbalance(prof));
+	fprintf(fp,"  \"phases\": {\n");
+	for(phase=0;phase<PROF_NPHASES;phase++){
+		phase_stats(prof,phase,&total,&mean,&max);
+		fprintf(fp,"    \"%s\": {\"threaded\": %d, \"total\": %.6e, \"mean\": %.6e, \"max\": %.6e, \"threads\": [",
+			phase_name[phase],phase_threaded[phase],total,mean,max);
+		for(th=0;th<prof->nthreads;th++){
+			fprintf(fp,"%s%.6e",(th==0 ? "" : ", "),prof->time[th*PROF_STRIDE+phase]);
+		}
+		fprintf(fp,"]}%s\n",(phase==PROF_NPHASES-1 ? "" : ","));
+	}
+	fprintf(fp,"  }\n");
+	fprintf(fp,"}\n");
+	fclose(fp);
+
+	printf("%s The profile summary has been written: %s\n",OK,filename);
+
+}
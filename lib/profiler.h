@@ -0,0 +1,89 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - profiler.h
+
+Content:
+  -This file contains the function prototypes for profiler.c and the timers of the phases of
+   the computation. Each thread accumulates the time of a phase in its own slot. The phases
+   computed inside the flux sweeps are timed per pencil by every thread, the rest are timed by
+   the master thread. With PROFILE 0 the timers are empty.
+
+*/
+
+
+#ifndef PROFILER_H
+  #define PROFILER_H
+
+  #include <time.h>
+  #ifdef _OPENMP
+  #include <omp.h>
+  #endif
+
+  //Phases of the computation
+  enum{
+	PROF_FLUXES,     //compute_fluxes(), wall-clock time of the three sweeps
+	PROF_RECONST,    //load and reconstruction of the pencils (per thread)
+	PROF_RIEMANN,    //Riemann solvers and flux divergence (per thread)
+	PROF_SOURCE,     //source terms (per thread)
+	PROF_STAGE,      //Runge-Kutta stage applied in the z-sweep (per thread)
+	PROF_UPDATE,     //update_cell() and update_cellK1()
+	PROF_DT,         //update_dt()
+	PROF_GHOST,      //update_ghost_cells()
+	PROF_WRITE_VTK,  //write_vtk() (by the writer thread with ASYNC_OUTPUT)
+	PROF_WRITE_LIST, //write_list() and write_list_eq() (by the writer thread with ASYNC_OUTPUT)
+	PROF_WRITE_TKE,  //tke_calculation() and tke.out
+	PROF_HALO,       //packing of the halos and waits for the neighbour subdomains (USE_MPI)
+	PROF_OUTPUT,     //copies of the state for the background writer and waits for a free copy (ASYNC_OUTPUT)
+	PROF_CHECKPOINT, //write_checkpoint()
+	PROF_NPHASES
+  };
+
+  //Distance between the slots of two threads, so that they do not share cache lines
+  #define PROF_STRIDE 32
+
+  //Wall-clock time in seconds
+  static inline double prof_time(void){
+  #ifdef _OPENMP
+	return omp_get_wtime();
+  #else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+1.0e-9*ts.tv_nsec;
+  #endif
+  }
+
+  //Adds the time elapsed since t0 to the phase in the slot of the calling thread, and restarts t0
+  static inline void profiler_lap(t_profiler *prof, int phase, double *t0){
+	double t1;
+	int th;
+
+	t1=prof_time();
+	th=0;
+  #ifdef _OPENMP
+	th=omp_get_thread_num();
+  #endif
+	prof->time[th*PROF_STRIDE+phase]+=t1-(*t0);
+	*t0=t1;
+  }
+
+  #if PROFILE
+	#define PROF_START(t0) ((t0)=prof_time())
+	#define PROF_LAP(sim,phase,t0) profiler_lap(&((sim)->prof),(phase),&(t0))
+  #else
+	#define PROF_START(t0) ((t0)=0.0)
+	#define PROF_LAP(sim,phase,t0) ((void)(t0))
+  #endif
+
+  void profiler_init(t_sim *sim);
+  void profiler_start(t_sim *sim);
+  void profiler_report(t_mesh *mesh, t_sim *sim);
+  void profiler_summary(t_mesh *mesh, t_sim *sim, const char *filename);
+
+#endif
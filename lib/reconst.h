@@ -20,12 +20,13 @@ Content:
   #define RECONST_H
 
 
-  double weno3L(double *phi);
-  double weno3R(double *phi);
-  double weno5L(double *phi);
-  double weno5R(double *phi);
-  double weno7L(double *phi);
-  double weno7R(double *phi);
+#if SIMD_DISPATCH && defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+  #define SIMD_DISPATCH_ATTR __attribute__((target_clones("avx512f","avx2","default")))
+#else
+  #define SIMD_DISPATCH_ATTR
+#endif
+
+  void select_reconstruction(t_sim *sim);
 
 
 
@@ -0,0 +1,871 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - reconst_template.h
+
+Content:
+  -This file contains all the functions implementing the reconstruction methods for high-order schemes.
+   It is a template: it is included by reconst.c once for each value of TYPE_REC, which is defined
+   as a constant before the inclusion. Function names are suffixed with KERNEL().
+  
+*/
+
+
+#if ALLOW_SOLIDS
+//Scalar reconstruction of a single cell. It is only used for the cells near solids, which have
+//a reduced stencil
+static double KERNEL(weno3R)(double *phi){
+
+	double g0, g1;		//gamma optimal weight/	
+	double w0, w1;		//WENO weight
+#if TYPE_REC < 2
+	double b0, b1;		//beta
+	double a0, a1;		//alpha
+#if TYPE_REC == 1
+	double c0, c1;
+#endif
+#endif
+	double UR;
+
+	g0=2.0/3.0;
+	g1=1.0/3.0;
+
+#if TYPE_REC == 0
+
+	b0=(phi[1]-phi[0])*(phi[1]-phi[0]);
+	b1=(phi[2]-phi[1])*(phi[2]-phi[1]);
+
+	a0=g0/((b0+epsilon)*(b0+epsilon));
+	a1=g1/((b1+epsilon)*(b1+epsilon));
+
+	w0=a0/(a0+a1);
+	w1=a1/(a0+a1);
+
+#elif TYPE_REC == 1  //TENO
+
+	b0=(phi[1]-phi[0])*(phi[1]-phi[0]);
+	b1=(phi[2]-phi[1])*(phi[2]-phi[1]);
+
+	a0=1.0/pow((b0+epsilon2),_Q_);
+	a1=1.0/pow((b1+epsilon2),_Q_);
+
+	c0 = a0/(a0 + a1);
+      c1 = a1/(a0 + a1);
+
+      c0 = c0 < _CT_ ? 0. : 1.;
+      c1 = c1 < _CT_ ? 0. : 1.;
+
+	a0 = g0*c0;
+	a1 = g1*c1;
+
+	w0 = a0/(a0 + a1);
+	w1 = a1/(a0 + a1);
+
+#else
+
+	w0=g0;
+	w1=g1;
+
+#endif
+
+	UR=w0*(0.5*phi[1]+0.5*phi[0])+w1*(-0.5*phi[2]+1.5*phi[1]);
+
+
+	return UR;
+}
+
+static double KERNEL(weno3L)(double *phi){
+
+	double g0, g1;		//gamma optimal weight/	
+	double w0, w1;		//WENO weight
+#if TYPE_REC < 2
+	double b0, b1;		//beta
+	double a0, a1;		//alpha
+#if TYPE_REC == 1
+	double c0, c1;
+#endif
+#endif
+	double UL;
+
+	g0=1.0/3.0;
+	g1=2.0/3.0;
+
+#if TYPE_REC == 0
+
+	b0=(phi[1]-phi[0])*(phi[1]-phi[0]);
+	b1=(phi[2]-phi[1])*(phi[2]-phi[1]);
+
+	a0=g0/((b0+epsilon)*(b0+epsilon));
+	a1=g1/((b1+epsilon)*(b1+epsilon));
+
+	w0=a0/(a0+a1);
+	w1=a1/(a0+a1);
+
+#elif TYPE_REC == 1  //TENO
+
+	b0=(phi[1]-phi[0])*(phi[1]-phi[0]);
+	b1=(phi[2]-phi[1])*(phi[2]-phi[1]);
+
+	a0=1.0/pow((b0+epsilon2),_Q_);
+	a1=1.0/pow((b1+epsilon2),_Q_);
+
+	c0 = a0/(a0 + a1);
+	c1 = a1/(a0 + a1);
+
+	c0 = c0 < _CT_ ? 0. : 1.;
+	c1 = c1 < _CT_ ? 0. : 1.;
+
+	a0 = g0*c0;
+	a1 = g1*c1;
+
+	w0 = a0/(a0 + a1);
+	w1 = a1/(a0 + a1);
+
+#else //UWC
+
+	w0=g0;
+	w1=g1;
+
+#endif
+
+	UL=w0*(-0.5*phi[0]+1.5*phi[1])+w1*(0.5*phi[1]+0.5*phi[2]);
+
+
+	return UL;
+}
+
+static double KERNEL(weno5R)(double *phi){
+
+	double g0, g1, g2;		//gamma optimal weight/
+	double w0, w1, w2;		//WENO weight
+#if TYPE_REC < 2
+	double b0, b1, b2;		//beta
+	double a0, a1, a2;		//alpha
+#if TYPE_REC == 1
+	double c0, c1, c2;
+#endif
+#endif
+	double UR;
+
+	g0=3.0/10.0;
+	g1=3.0/5.0;
+	g2=1.0/10.0;
+
+#if TYPE_REC == 0    //WENO
+
+	b0=13.0/12.0*(phi[0]-2*phi[1]+phi[2])*(phi[0]-2*phi[1]+phi[2])+0.25*(phi[0]-4*phi[1]+3*phi[2])*(phi[0]-4*phi[1]+3*phi[2]);
+	b1=13.0/12.0*(phi[1]-2*phi[2]+phi[3])*(phi[1]-2*phi[2]+phi[3])+0.25*(phi[1]-phi[3])*(phi[1]-phi[3]);
+	b2=13.0/12.0*(phi[2]-2*phi[3]+phi[4])*(phi[2]-2*phi[3]+phi[4])+0.25*(3*phi[2]-4*phi[3]+phi[4])*(3*phi[2]-4*phi[3]+phi[4]);
+
+
+	a0=g0/((b0+epsilon)*(b0+epsilon));
+	a1=g1/((b1+epsilon)*(b1+epsilon));
+	a2=g2/((b2+epsilon)*(b2+epsilon));
+
+
+	w0=a0/(a0 + a1 + a2);
+	w1=a1/(a0 + a1 + a2);
+      w2=a2/(a0 + a1 + a2);
+
+#elif TYPE_REC == 1  //TENO
+
+	b0=13.0/12.0*(phi[0]-2*phi[1]+phi[2])*(phi[0]-2*phi[1]+phi[2])+0.25*(phi[0]-4*phi[1]+3*phi[2])*(phi[0]-4*phi[1]+3*phi[2]);
+	b1=13.0/12.0*(phi[1]-2*phi[2]+phi[3])*(phi[1]-2*phi[2]+phi[3])+0.25*(phi[1]-phi[3])*(phi[1]-phi[3]);
+	b2=13.0/12.0*(phi[2]-2*phi[3]+phi[4])*(phi[2]-2*phi[3]+phi[4])+0.25*(3*phi[2]-4*phi[3]+phi[4])*(3*phi[2]-4*phi[3]+phi[4]);
+
+
+	a0=1.0/pow((b0+epsilon2),_Q_);
+	a1=1.0/pow((b1+epsilon2),_Q_);
+	a2=1.0/pow((b2+epsilon2),_Q_);
+
+	c0 = a0/(a0 + a1 + a2);
+	c1 = a1/(a0 + a1 + a2);
+	c2 = a2/(a0 + a1 + a2);
+
+	c0 = c0 < _CT_ ? 0. : 1.;
+	c1 = c1 < _CT_ ? 0. : 1.;
+	c2 = c2 < _CT_ ? 0. : 1.;
+
+	a0 = g0*c0;
+	a1 = g1*c1;
+	a2 = g2*c2;
+
+	w0 = a0/(a0 + a1 + a2);
+	w1 = a1/(a0 + a1 + a2);
+	w2 = a2/(a0 + a1 + a2);
+
+#else //UWC
+
+	w0=g0;
+	w1=g1;
+	w2=g2;
+
+
+#endif
+
+	UR=w0*(1.0/3.0*phi[2]+5.0/6.0*phi[1]-1.0/6.0*phi[0]) + w1*(-1.0/6.0*phi[3]+5.0/6.0*phi[2]+1.0/3.0*phi[1]) + w2*(1.0/3.0*phi[4]-7.0/6.0*phi[3]+11.0/6.0*phi[2]) ;
+
+
+	return UR;
+}
+
+static double KERNEL(weno5L)(double *phi){
+
+	double g0, g1, g2;		//gamma optimal weight/
+	double w0, w1, w2;		//WENO weight
+#if TYPE_REC < 2
+	double b0, b1, b2;		//beta
+	double a0, a1, a2;		//alpha
+#if TYPE_REC == 1
+	double c0, c1, c2;
+#endif
+#endif
+	double UL;
+
+	g0=1.0/10.0;
+	g1=3.0/5.0;
+	g2=3.0/10.0;
+
+#if TYPE_REC == 0
+
+	b0=13.0/12.0*(phi[0]-2*phi[1]+phi[2])*(phi[0]-2*phi[1]+phi[2])+0.25*(phi[0]-4*phi[1]+3*phi[2])*(phi[0]-4*phi[1]+3*phi[2]);
+	b1=13.0/12.0*(phi[1]-2*phi[2]+phi[3])*(phi[1]-2*phi[2]+phi[3])+0.25*(phi[1]-phi[3])*(phi[1]-phi[3]);
+	b2=13.0/12.0*(phi[2]-2*phi[3]+phi[4])*(phi[2]-2*phi[3]+phi[4])+0.25*(3*phi[2]-4*phi[3]+phi[4])*(3*phi[2]-4*phi[3]+phi[4]);
+
+
+	a0=g0/((b0+epsilon)*(b0+epsilon));
+	a1=g1/((b1+epsilon)*(b1+epsilon));
+	a2=g2/((b2+epsilon)*(b2+epsilon));
+
+
+	w0=a0/(a0 + a1 + a2);
+	w1=a1/(a0 + a1 + a2);
+	w2=a2/(a0 + a1 + a2);
+
+#elif TYPE_REC == 1  //TENO
+
+	b0=13.0/12.0*(phi[0]-2*phi[1]+phi[2])*(phi[0]-2*phi[1]+phi[2])+0.25*(phi[0]-4*phi[1]+3*phi[2])*(phi[0]-4*phi[1]+3*phi[2]);
+	b1=13.0/12.0*(phi[1]-2*phi[2]+phi[3])*(phi[1]-2*phi[2]+phi[3])+0.25*(phi[1]-phi[3])*(phi[1]-phi[3]);
+	b2=13.0/12.0*(phi[2]-2*phi[3]+phi[4])*(phi[2]-2*phi[3]+phi[4])+0.25*(3*phi[2]-4*phi[3]+phi[4])*(3*phi[2]-4*phi[3]+phi[4]);
+
+
+	a0=1.0/pow((b0+epsilon2),_Q_);
+	a1=1.0/pow((b1+epsilon2),_Q_);
+	a2=1.0/pow((b2+epsilon2),_Q_);
+
+	c0 = a0/(a0 + a1 + a2);
+	c1 = a1/(a0 + a1 + a2);
+	c2 = a2/(a0 + a1 + a2);
+
+	c0 = c0 < _CT_ ? 0. : 1.;
+	c1 = c1 < _CT_ ? 0. : 1.;
+	c2 = c2 < _CT_ ? 0. : 1.;
+
+	a0 = g0*c0;
+	a1 = g1*c1;
+	a2 = g2*c2;
+
+	w0 = a0/(a0 + a1 + a2);
+	w1 = a1/(a0 + a1 + a2);
+	w2 = a2/(a0 + a1 + a2);
+
+#else
+
+	w0=g0;
+	w1=g1;
+	w2=g2;
+
+#endif
+
+
+	UL=w2*(1.0/3.0*phi[2]+5.0/6.0*phi[3]-1.0/6.0*phi[4]) + w1*(-1.0/6.0*phi[1]+5.0/6.0*phi[2]+1.0/3.0*phi[3]) + w0*(1.0/3.0*phi[0]-7.0/6.0*phi[1]+11.0/6.0*phi[2]) ;
+
+
+	return UL;
+}
+
+static double KERNEL(weno7R)(double *phi){
+
+	double g0, g1, g2, g3;		//gamma optimal weight/
+	double w0, w1, w2, w3;		//WENO weight
+#if TYPE_REC < 2
+	double b0, b1, b2, b3;		//beta
+	double a0, a1, a2, a3;		//alpha
+#if TYPE_REC == 1
+	double c0, c1, c2, c3;
+#endif
+#endif
+	double UR;
+
+	g0=4.0/35.0;
+	g1=18.0/35.0;
+      g2=12.0/35.0;
+      g3=1.0/35.0;
+
+
+#if TYPE_REC == 0
+
+	b0 = phi[0]*(547.0*phi[0] - 3882.0*phi[1] + 4642.0*phi[2] - 1854.0*phi[3]) + phi[1]*(7043.0*phi[1] - 17246.0*phi[2] + 7042.0*phi[3]) + phi[2]*(11003.0*phi[2] - 9402.0*phi[3]) + phi[3]*2107.0*phi[3];
+	b1 = phi[1]*(267.0*phi[1] - 1642.0*phi[2] + 1602.0*phi[3] - 494.0*phi[4]) + phi[2]*(2843.0*phi[2] - 5966.0*phi[3] + 1922.0*phi[4]) + phi[3]*(3443.0*phi[3] - 2522.0*phi[4]) + phi[4]*547.0*phi[4];
+	b2 = phi[2]*(547.0*phi[2] - 2522.0*phi[3] + 1922.0*phi[4] - 494.0*phi[5]) + phi[3]*(3443.0*phi[3] - 5966.0*phi[4] + 1602*phi[5]) + phi[4]*(2843.0*phi[4] - 1642*phi[5]) + phi[5]*267.0*phi[5];
+	b3 = phi[3]*(2107.0*phi[3] - 9402.0*phi[4] + 7042.0*phi[5] - 1854.0*phi[6]) + phi[4]*(11003.0*phi[4] - 17246.0*phi[5] + 4642.0*phi[6]) + phi[5]*(7043.0*phi[5] - 3882.0*phi[6]) + phi[6]*547.0*phi[6];
+
+	a0=g0/((b0+epsilon)*(b0+epsilon));
+	a1=g1/((b1+epsilon)*(b1+epsilon));
+	a2=g2/((b2+epsilon)*(b2+epsilon));
+	a3=g3/((b3+epsilon)*(b3+epsilon));
+
+
+	w0=a0/(a0 + a1 + a2 + a3);
+	w1=a1/(a0 + a1 + a2 + a3);
+	w2=a2/(a0 + a1 + a2 + a3);
+	w3=a3/(a0 + a1 + a2 + a3);
+
+#elif TYPE_REC == 1  //TENO
+
+	b0 = phi[0]*(547.0*phi[0] - 3882.0*phi[1] + 4642.0*phi[2] - 1854.0*phi[3]) + phi[1]*(7043.0*phi[1] - 17246.0*phi[2] + 7042.0*phi[3]) + phi[2]*(11003.0*phi[2] - 9402.0*phi[3]) + phi[3]*2107.0*phi[3];
+	b1 = phi[1]*(267.0*phi[1] - 1642.0*phi[2] + 1602.0*phi[3] - 494.0*phi[4]) + phi[2]*(2843.0*phi[2] - 5966.0*phi[3] + 1922.0*phi[4]) + phi[3]*(3443.0*phi[3] - 2522.0*phi[4]) + phi[4]*547.0*phi[4];
+	b2 = phi[2]*(547.0*phi[2] - 2522.0*phi[3] + 1922.0*phi[4] - 494.0*phi[5]) + phi[3]*(3443.0*phi[3] - 5966.0*phi[4] + 1602*phi[5]) + phi[4]*(2843.0*phi[4] - 1642*phi[5]) + phi[5]*267.0*phi[5];
+	b3 = phi[3]*(2107.0*phi[3] - 9402.0*phi[4] + 7042.0*phi[5] - 1854.0*phi[6]) + phi[4]*(11003.0*phi[4] - 17246.0*phi[5] + 4642.0*phi[6]) + phi[5]*(7043.0*phi[5] - 3882.0*phi[6]) + phi[6]*547.0*phi[6];
+
+	a0=1.0/pow((b0+epsilon2),_Q_);
+	a1=1.0/pow((b1+epsilon2),_Q_);
+	a2=1.0/pow((b2+epsilon2),_Q_);
+	a3=1.0/pow((b3+epsilon2),_Q_);
+
+	c0 = a0/(a0 + a1 + a2 + a3);
+	c1 = a1/(a0 + a1 + a2 + a3);
+	c2 = a2/(a0 + a1 + a2 + a3);
+	c3 = a3/(a0 + a1 + a2 + a3);
+
+	c0 = c0 < _CT_ ? 0. : 1.;
+	c1 = c1 < _CT_ ? 0. : 1.;
+	c2 = c2 < _CT_ ? 0. : 1.;
+	c3 = c3 < _CT_ ? 0. : 1.;
+
+	a0 = g0*c0;
+	a1 = g1*c1;
+	a2 = g2*c2;
+	a3 = g3*c3;
+
+	w0 = a0/(a0 + a1 + a2 + a3);
+	w1 = a1/(a0 + a1 + a2 + a3);
+	w2 = a2/(a0 + a1 + a2 + a3);
+	w3 = a3/(a0 + a1 + a2 + a3);
+
+#else //UWC
+
+	w0=g0;
+	w1=g1;
+	w2=g2;
+	w3=g3;
+
+#endif
+
+	UR= w0*(1.0/4.0*phi[3]  + 13.0/12.0*phi[2] - 5.0/12.0*phi[1] + 1.0/12.0*phi[0]) + w1*(-1.0/12.0*phi[4] + 7.0/12.0*phi[3] + 7.0/12.0*phi[2] - 1.0/12.0*phi[1]) + w2*(1.0/12.0*phi[5] - 5.0/12.0*phi[4] + 13.0/12.0*phi[3] + 1.0/4.0*phi[2]) + w3*(-1.0/4.0*phi[6] + 13.0/12.0*phi[5] - 23.0/12.0*phi[4] + 25.0/12.0*phi[3]);
+
+
+	return UR;
+}
+
+static double KERNEL(weno7L)(double *phi){
+
+	double g0, g1, g2, g3;		//gamma optimal weight/
+	double w0, w1, w2, w3;		//WENO weight
+#if TYPE_REC < 2
+	double b0, b1, b2, b3;		//beta
+	double a0, a1, a2, a3;		//alpha
+#if TYPE_REC == 1
+	double c0, c1, c2, c3;
+#endif
+#endif
+	double UL;
+
+	g0=1.0/35.0;
+	g1=12.0/35.0;
+	g2=18.0/35.0;
+	g3=4.0/35.0;
+
+
+#if TYPE_REC == 0
+
+	b0 = phi[0]*(547.0*phi[0] - 3882.0*phi[1] + 4642.0*phi[2] - 1854.0*phi[3]) + phi[1]*(7043.0*phi[1] - 17246.0*phi[2] + 7042.0*phi[3]) + phi[2]*(11003.0*phi[2] - 9402.0*phi[3]) + phi[3]*2107.0*phi[3];
+	b1 = phi[1]*(267.0*phi[1] - 1642.0*phi[2] + 1602.0*phi[3] - 494.0*phi[4]) + phi[2]*(2843.0*phi[2] - 5966.0*phi[3] + 1922.0*phi[4]) + phi[3]*(3443.0*phi[3] - 2522.0*phi[4]) + phi[4]*547.0*phi[4];
+	b2 = phi[2]*(547.0*phi[2] - 2522.0*phi[3] + 1922.0*phi[4] - 494.0*phi[5]) + phi[3]*(3443.0*phi[3] - 5966.0*phi[4] + 1602*phi[5]) + phi[4]*(2843.0*phi[4] - 1642*phi[5]) + phi[5]*267.0*phi[5];
+	b3 = phi[3]*(2107.0*phi[3] - 9402.0*phi[4] + 7042.0*phi[5] - 1854.0*phi[6]) + phi[4]*(11003.0*phi[4] - 17246.0*phi[5] + 4642.0*phi[6]) + phi[5]*(7043.0*phi[5] - 3882.0*phi[6]) + phi[6]*547.0*phi[6];
+
+	a0=g0/((b0+epsilon)*(b0+epsilon));
+	a1=g1/((b1+epsilon)*(b1+epsilon));
+	a2=g2/((b2+epsilon)*(b2+epsilon));
+	a3=g3/((b3+epsilon)*(b3+epsilon));
+
+	w0=a0/(a0 + a1 + a2 + a3);
+	w1=a1/(a0 + a1 + a2 + a3);
+	w2=a2/(a0 + a1 + a2 + a3);
+	w3=a3/(a0 + a1 + a2 + a3);
+
+#elif TYPE_REC == 1  //TENO
+
+	b0 = phi[0]*(547.0*phi[0] - 3882.0*phi[1] + 4642.0*phi[2] - 1854.0*phi[3]) + phi[1]*(7043.0*phi[1] - 17246.0*phi[2] + 7042.0*phi[3]) + phi[2]*(11003.0*phi[2] - 9402.0*phi[3]) + phi[3]*2107.0*phi[3];
+	b1 = phi[1]*(267.0*phi[1] - 1642.0*phi[2] + 1602.0*phi[3] - 494.0*phi[4]) + phi[2]*(2843.0*phi[2] - 5966.0*phi[3] + 1922.0*phi[4]) + phi[3]*(3443.0*phi[3] - 2522.0*phi[4]) + phi[4]*547.0*phi[4];
+	b2 = phi[2]*(547.0*phi[2] - 2522.0*phi[3] + 1922.0*phi[4] - 494.0*phi[5]) + phi[3]*(3443.0*phi[3] - 5966.0*phi[4] + 1602*phi[5]) + phi[4]*(2843.0*phi[4] - 1642*phi[5]) + phi[5]*267.0*phi[5];
+	b3 = phi[3]*(2107.0*phi[3] - 9402.0*phi[4] + 7042.0*phi[5] - 1854.0*phi[6]) + phi[4]*(11003.0*phi[4] - 17246.0*phi[5] + 4642.0*phi[6]) + phi[5]*(7043.0*phi[5] - 3882.0*phi[6]) + phi[6]*547.0*phi[6];
+
+	a0=1.0/pow((b0+epsilon2),_Q_);
+	a1=1.0/pow((b1+epsilon2),_Q_);
+	a2=1.0/pow((b2+epsilon2),_Q_);
+	a3=1.0/pow((b3+epsilon2),_Q_);
+
+	c0 = a0/(a0 + a1 + a2 + a3);
+	c1 = a1/(a0 + a1 + a2 + a3);
+	c2 = a2/(a0 + a1 + a2 + a3);
+	c3 = a3/(a0 + a1 + a2 + a3);
+
+	c0 = c0 < _CT_ ? 0. : 1.;
+	c1 = c1 < _CT_ ? 0. : 1.;
+	c2 = c2 < _CT_ ? 0. : 1.;
+	c3 = c3 < _CT_ ? 0. : 1.;
+
+	a0 = g0*c0;
+	a1 = g1*c1;
+	a2 = g2*c2;
+	a3 = g3*c3;
+
+	w0 = a0/(a0 + a1 + a2 + a3);
+	w1 = a1/(a0 + a1 + a2 + a3);
+	w2 = a2/(a0 + a1 + a2 + a3);
+	w3 = a3/(a0 + a1 + a2 + a3);
+
+#else //UWC
+
+	w0=g0;
+	w1=g1;
+	w2=g2;
+	w3=g3;
+
+#endif
+
+	UL = w0*(-1.0/4.0*phi[0] + 13.0/12.0*phi[1] - 23.0/12.0*phi[2] + 25.0/12.0*phi[3]) + w1*(1.0/12.0*phi[1] - 5.0/12.0*phi[2] + 13.0/12.0*phi[3] + 1.0/4.0*phi[4]) + w2*(-1.0/12.0*phi[2] + 7.0/12.0*phi[3]  + 7.0/12.0*phi[4] - 1.0/12.0*phi[5]) + w3*(1.0/4.0*phi[3] + 13.0/12.0*phi[4] - 5.0/12.0*phi[5] + 1.0/12.0*phi[6]);
+
+
+	return UL;
+}
+
+
+static double KERNEL(reconstruct_L)(double *phi, int order){
+	//Reconstruction at the right hand side of the cell (left state of its upper wall).
+	//phi points to the first cell of the stencil of size order
+
+	if(order==3){
+		return KERNEL(weno3L)(phi);
+	}else if(order==5){
+		return KERNEL(weno5L)(phi);
+	}else if(order==7){
+		return KERNEL(weno7L)(phi);
+	}else{
+		return phi[0];
+	}
+
+}
+
+
+static double KERNEL(reconstruct_R)(double *phi, int order){
+	//Reconstruction at the left hand side of the cell (right state of its lower wall).
+	//phi points to the first cell of the stencil of size order
+
+	if(order==3){
+		return KERNEL(weno3R)(phi);
+	}else if(order==5){
+		return KERNEL(weno5R)(phi);
+	}else if(order==7){
+		return KERNEL(weno7R)(phi);
+	}else{
+		return phi[0];
+	}
+
+}
+#endif
+
+
+/*
+ Batch reconstruction kernels. They reconstruct n cells at once from a line buffer
+ (e.g. a pencil): the stencil of the cell p is phi[p],...,phi[p+order-1]. Both the
+ left and right states of each cell are computed, sharing the smoothness indicators.
+ They follow the scalar functions above, which are kept as the reference, and are
+ written as simd loops so that they are vectorized by the compiler. When
+ SIMD_DISPATCH is active, they are compiled for AVX-512, AVX2 and the baseline
+ instruction set, and the version is selected at runtime.
+*/
+
+
+
+SIMD_DISPATCH_ATTR
+static void KERNEL(weno3_batch)(const double * restrict phi, double * restrict UL, double * restrict UR, int n){
+
+	int p;
+
+#pragma omp simd
+	for(p=0;p<n;p++){
+		double gL0, gL1, gR0, gR1;		//gamma optimal weights, left and right
+		double wL0, wL1, wR0, wR1;		//WENO weights, left and right
+#if TYPE_REC < 2
+		double b0, b1;		//beta, shared by the left and right reconstructions
+		double aL0, aL1, aR0, aR1;		//alpha
+#if TYPE_REC == 0
+		double d0, d1;
+#else
+		double a0, a1;
+		double c0, c1;
+#endif
+#endif
+
+		gL0=1.0/3.0;
+		gL1=2.0/3.0;
+		gR0=2.0/3.0;
+		gR1=1.0/3.0;
+
+#if TYPE_REC < 2
+
+		b0=(phi[p+1]-phi[p+0])*(phi[p+1]-phi[p+0]);
+		b1=(phi[p+2]-phi[p+1])*(phi[p+2]-phi[p+1]);
+
+#endif
+#if TYPE_REC == 0    //WENO
+
+		d0=(b0+epsilon)*(b0+epsilon);
+		d1=(b1+epsilon)*(b1+epsilon);
+
+		aL0=gL0/d0;
+		aL1=gL1/d1;
+
+		wL0=aL0/(aL0+aL1);
+		wL1=aL1/(aL0+aL1);
+
+		aR0=gR0/d0;
+		aR1=gR1/d1;
+
+		wR0=aR0/(aR0+aR1);
+		wR1=aR1/(aR0+aR1);
+
+#elif TYPE_REC == 1  //TENO
+
+		a0=1.0/teno_pow(b0+epsilon2);
+		a1=1.0/teno_pow(b1+epsilon2);
+
+		c0 = a0/(a0+a1);
+		c1 = a1/(a0+a1);
+
+		c0 = c0 < _CT_ ? 0. : 1.;
+		c1 = c1 < _CT_ ? 0. : 1.;
+
+		aL0 = gL0*c0;
+		aL1 = gL1*c1;
+
+		wL0 = aL0/(aL0+aL1);
+		wL1 = aL1/(aL0+aL1);
+
+		aR0 = gR0*c0;
+		aR1 = gR1*c1;
+
+		wR0 = aR0/(aR0+aR1);
+		wR1 = aR1/(aR0+aR1);
+
+#else //UWC
+
+		wL0=gL0;
+		wL1=gL1;
+		wR0=gR0;
+		wR1=gR1;
+
+#endif
+
+		UL[p]=wL0*(-0.5*phi[p+0]+1.5*phi[p+1])+wL1*(0.5*phi[p+1]+0.5*phi[p+2]);
+		UR[p]=wR0*(0.5*phi[p+1]+0.5*phi[p+0])+wR1*(-0.5*phi[p+2]+1.5*phi[p+1]);
+	}
+
+}
+
+
+SIMD_DISPATCH_ATTR
+static void KERNEL(weno5_batch)(const double * restrict phi, double * restrict UL, double * restrict UR, int n){
+
+	int p;
+
+#pragma omp simd
+	for(p=0;p<n;p++){
+		double gL0, gL1, gL2, gR0, gR1, gR2;		//gamma optimal weights, left and right
+		double wL0, wL1, wL2, wR0, wR1, wR2;		//WENO weights, left and right
+#if TYPE_REC < 2
+		double b0, b1, b2;		//beta, shared by the left and right reconstructions
+		double aL0, aL1, aL2, aR0, aR1, aR2;		//alpha
+#if TYPE_REC == 0
+		double d0, d1, d2;
+#else
+		double a0, a1, a2;
+		double c0, c1, c2;
+#endif
+#endif
+
+		gL0=1.0/10.0;
+		gL1=3.0/5.0;
+		gL2=3.0/10.0;
+		gR0=3.0/10.0;
+		gR1=3.0/5.0;
+		gR2=1.0/10.0;
+
+#if TYPE_REC < 2
+
+		b0=13.0/12.0*(phi[p+0]-2*phi[p+1]+phi[p+2])*(phi[p+0]-2*phi[p+1]+phi[p+2])+0.25*(phi[p+0]-4*phi[p+1]+3*phi[p+2])*(phi[p+0]-4*phi[p+1]+3*phi[p+2]);
+		b1=13.0/12.0*(phi[p+1]-2*phi[p+2]+phi[p+3])*(phi[p+1]-2*phi[p+2]+phi[p+3])+0.25*(phi[p+1]-phi[p+3])*(phi[p+1]-phi[p+3]);
+		b2=13.0/12.0*(phi[p+2]-2*phi[p+3]+phi[p+4])*(phi[p+2]-2*phi[p+3]+phi[p+4])+0.25*(3*phi[p+2]-4*phi[p+3]+phi[p+4])*(3*phi[p+2]-4*phi[p+3]+phi[p+4]);
+
+#endif
+#if TYPE_REC == 0    //WENO
+
+		d0=(b0+epsilon)*(b0+epsilon);
+		d1=(b1+epsilon)*(b1+epsilon);
+		d2=(b2+epsilon)*(b2+epsilon);
+
+		aL0=gL0/d0;
+		aL1=gL1/d1;
+		aL2=gL2/d2;
+
+		wL0=aL0/(aL0 + aL1 + aL2);
+		wL1=aL1/(aL0 + aL1 + aL2);
+		wL2=aL2/(aL0 + aL1 + aL2);
+
+		aR0=gR0/d0;
+		aR1=gR1/d1;
+		aR2=gR2/d2;
+
+		wR0=aR0/(aR0 + aR1 + aR2);
+		wR1=aR1/(aR0 + aR1 + aR2);
+		wR2=aR2/(aR0 + aR1 + aR2);
+
+#elif TYPE_REC == 1  //TENO
+
+		a0=1.0/teno_pow(b0+epsilon2);
+		a1=1.0/teno_pow(b1+epsilon2);
+		a2=1.0/teno_pow(b2+epsilon2);
+
+		c0 = a0/(a0 + a1 + a2);
+		c1 = a1/(a0 + a1 + a2);
+		c2 = a2/(a0 + a1 + a2);
+
+		c0 = c0 < _CT_ ? 0. : 1.;
+		c1 = c1 < _CT_ ? 0. : 1.;
+		c2 = c2 < _CT_ ? 0. : 1.;
+
+		aL0 = gL0*c0;
+		aL1 = gL1*c1;
+		aL2 = gL2*c2;
+
+		wL0 = aL0/(aL0 + aL1 + aL2);
+		wL1 = aL1/(aL0 + aL1 + aL2);
+		wL2 = aL2/(aL0 + aL1 + aL2);
+
+		aR0 = gR0*c0;
+		aR1 = gR1*c1;
+		aR2 = gR2*c2;
+
+		wR0 = aR0/(aR0 + aR1 + aR2);
+		wR1 = aR1/(aR0 + aR1 + aR2);
+		wR2 = aR2/(aR0 + aR1 + aR2);
+
+#else //UWC
+
+		wL0=gL0;
+		wL1=gL1;
+		wL2=gL2;
+		wR0=gR0;
+		wR1=gR1;
+		wR2=gR2;
+
+#endif
+
+		UL[p]=wL2*(1.0/3.0*phi[p+2]+5.0/6.0*phi[p+3]-1.0/6.0*phi[p+4]) + wL1*(-1.0/6.0*phi[p+1]+5.0/6.0*phi[p+2]+1.0/3.0*phi[p+3]) + wL0*(1.0/3.0*phi[p+0]-7.0/6.0*phi[p+1]+11.0/6.0*phi[p+2]) ;
+		UR[p]=wR0*(1.0/3.0*phi[p+2]+5.0/6.0*phi[p+1]-1.0/6.0*phi[p+0]) + wR1*(-1.0/6.0*phi[p+3]+5.0/6.0*phi[p+2]+1.0/3.0*phi[p+1]) + wR2*(1.0/3.0*phi[p+4]-7.0/6.0*phi[p+3]+11.0/6.0*phi[p+2]) ;
+	}
+
+}
+
+
+SIMD_DISPATCH_ATTR
+static void KERNEL(weno7_batch)(const double * restrict phi, double * restrict UL, double * restrict UR, int n){
+
+	int p;
+
+#pragma omp simd
+	for(p=0;p<n;p++){
+		double gL0, gL1, gL2, gL3, gR0, gR1, gR2, gR3;		//gamma optimal weights, left and right
+		double wL0, wL1, wL2, wL3, wR0, wR1, wR2, wR3;		//WENO weights, left and right
+#if TYPE_REC < 2
+		double b0, b1, b2, b3;		//beta, shared by the left and right reconstructions
+		double aL0, aL1, aL2, aL3, aR0, aR1, aR2, aR3;		//alpha
+#if TYPE_REC == 0
+		double d0, d1, d2, d3;
+#else
+		double a0, a1, a2, a3;
+		double c0, c1, c2, c3;
+#endif
+#endif
+
+		gL0=1.0/35.0;
+		gL1=12.0/35.0;
+		gL2=18.0/35.0;
+		gL3=4.0/35.0;
+		gR0=4.0/35.0;
+		gR1=18.0/35.0;
+		gR2=12.0/35.0;
+		gR3=1.0/35.0;
+
+#if TYPE_REC < 2
+
+		b0 = phi[p+0]*(547.0*phi[p+0] - 3882.0*phi[p+1] + 4642.0*phi[p+2] - 1854.0*phi[p+3]) + phi[p+1]*(7043.0*phi[p+1] - 17246.0*phi[p+2] + 7042.0*phi[p+3]) + phi[p+2]*(11003.0*phi[p+2] - 9402.0*phi[p+3]) + phi[p+3]*2107.0*phi[p+3];
+		b1 = phi[p+1]*(267.0*phi[p+1] - 1642.0*phi[p+2] + 1602.0*phi[p+3] - 494.0*phi[p+4]) + phi[p+2]*(2843.0*phi[p+2] - 5966.0*phi[p+3] + 1922.0*phi[p+4]) + phi[p+3]*(3443.0*phi[p+3] - 2522.0*phi[p+4]) + phi[p+4]*547.0*phi[p+4];
+		b2 = phi[p+2]*(547.0*phi[p+2] - 2522.0*phi[p+3] + 1922.0*phi[p+4] - 494.0*phi[p+5]) + phi[p+3]*(3443.0*phi[p+3] - 5966.0*phi[p+4] + 1602*phi[p+5]) + phi[p+4]*(2843.0*phi[p+4] - 1642*phi[p+5]) + phi[p+5]*267.0*phi[p+5];
+		b3 = phi[p+3]*(2107.0*phi[p+3] - 9402.0*phi[p+4] + 7042.0*phi[p+5] - 1854.0*phi[p+6]) + phi[p+4]*(11003.0*phi[p+4] - 17246.0*phi[p+5] + 4642.0*phi[p+6]) + phi[p+5]*(7043.0*phi[p+5] - 3882.0*phi[p+6]) + phi[p+6]*547.0*phi[p+6];
+
+#endif
+#if TYPE_REC == 0    //WENO
+
+		d0=(b0+epsilon)*(b0+epsilon);
+		d1=(b1+epsilon)*(b1+epsilon);
+		d2=(b2+epsilon)*(b2+epsilon);
+		d3=(b3+epsilon)*(b3+epsilon);
+
+		aL0=gL0/d0;
+		aL1=gL1/d1;
+		aL2=gL2/d2;
+		aL3=gL3/d3;
+
+		wL0=aL0/(aL0 + aL1 + aL2 + aL3);
+		wL1=aL1/(aL0 + aL1 + aL2 + aL3);
+		wL2=aL2/(aL0 + aL1 + aL2 + aL3);
+		wL3=aL3/(aL0 + aL1 + aL2 + aL3);
+
+		aR0=gR0/d0;
+		aR1=gR1/d1;
+		aR2=gR2/d2;
+		aR3=gR3/d3;
+
+		wR0=aR0/(aR0 + aR1 + aR2 + aR3);
+		wR1=aR1/(aR0 + aR1 + aR2 + aR3);
+		wR2=aR2/(aR0 + aR1 + aR2 + aR3);
+		wR3=aR3/(aR0 + aR1 + aR2 + aR3);
+
+#elif TYPE_REC == 1  //TENO
+
+		a0=1.0/teno_pow(b0+epsilon2);
+		a1=1.0/teno_pow(b1+epsilon2);
+		a2=1.0/teno_pow(b2+epsilon2);
+		a3=1.0/teno_pow(b3+epsilon2);
+
+		c0 = a0/(a0 + a1 + a2 + a3);
+		c1 = a1/(a0 + a1 + a2 + a3);
+		c2 = a2/(a0 + a1 + a2 + a3);
+		c3 = a3/(a0 + a1 + a2 + a3);
+
+		c0 = c0 < _CT_ ? 0. : 1.;
+		c1 = c1 < _CT_ ? 0. : 1.;
+		c2 = c2 < _CT_ ? 0. : 1.;
+		c3 = c3 < _CT_ ? 0. : 1.;
+
+		aL0 = gL0*c0;
+		aL1 = gL1*c1;
+		aL2 = gL2*c2;
+		aL3 = gL3*c3;
+
+		wL0 = aL0/(aL0 + aL1 + aL2 + aL3);
+		wL1 = aL1/(aL0 + aL1 + aL2 + aL3);
+		wL2 = aL2/(aL0 + aL1 + aL2 + aL3);
+		wL3 = aL3/(aL0 + aL1 + aL2 + aL3);
+
+		aR0 = gR0*c0;
+		aR1 = gR1*c1;
+		aR2 = gR2*c2;
+		aR3 = gR3*c3;
+
+		wR0 = aR0/(aR0 + aR1 + aR2 + aR3);
+		wR1 = aR1/(aR0 + aR1 + aR2 + aR3);
+		wR2 = aR2/(aR0 + aR1 + aR2 + aR3);
+		wR3 = aR3/(aR0 + aR1 + aR2 + aR3);
+
+#else //UWC
+
+		wL0=gL0;
+		wL1=gL1;
+		wL2=gL2;
+		wL3=gL3;
+		wR0=gR0;
+		wR1=gR1;
+		wR2=gR2;
+		wR3=gR3;
+
+#endif
+
+		UL[p] = wL0*(-1.0/4.0*phi[p+0] + 13.0/12.0*phi[p+1] - 23.0/12.0*phi[p+2] + 25.0/12.0*phi[p+3]) + wL1*(1.0/12.0*phi[p+1] - 5.0/12.0*phi[p+2] + 13.0/12.0*phi[p+3] + 1.0/4.0*phi[p+4]) + wL2*(-1.0/12.0*phi[p+2] + 7.0/12.0*phi[p+3]  + 7.0/12.0*phi[p+4] - 1.0/12.0*phi[p+5]) + wL3*(1.0/4.0*phi[p+3] + 13.0/12.0*phi[p+4] - 5.0/12.0*phi[p+5] + 1.0/12.0*phi[p+6]);
+		UR[p]= wR0*(1.0/4.0*phi[p+3]  + 13.0/12.0*phi[p+2] - 5.0/12.0*phi[p+1] + 1.0/12.0*phi[p+0]) + wR1*(-1.0/12.0*phi[p+4] + 7.0/12.0*phi[p+3] + 7.0/12.0*phi[p+2] - 1.0/12.0*phi[p+1]) + wR2*(1.0/12.0*phi[p+5] - 5.0/12.0*phi[p+4] + 13.0/12.0*phi[p+3] + 1.0/4.0*phi[p+2]) + wR3*(-1.0/4.0*phi[p+6] + 13.0/12.0*phi[p+5] - 23.0/12.0*phi[p+4] + 25.0/12.0*phi[p+3]);
+	}
+
+}
+
+
+static void KERNEL(reconstruct_batch)(double *u, double *UL, double *UR, int n, int order){
+	//Reconstruction at the right (UL) and left (UR) hand side of n consecutive cells, all with a
+	//stencil of size order. u points to the first cell, so that u[-(order-1)/2] must be accessible
+
+	int p;
+
+	if(order==3){
+		KERNEL(weno3_batch)(u-1,UL,UR,n);
+	}else if(order==5){
+		KERNEL(weno5_batch)(u-2,UL,UR,n);
+	}else if(order==7){
+		KERNEL(weno7_batch)(u-3,UL,UR,n);
+	}else{
+		for(p=0;p<n;p++){
+			UL[p]=u[p];
+			UR[p]=u[p];
+		}
+	}
+
+}
+
+
+static void KERNEL(reconstruct_pencil)(t_pencil *pc, int nvar, int order){
+
+	int k,lo;
+#if ALLOW_SOLIDS
+	int p,st;
+#endif
+
+	//All the cells are reconstructed at once with the same stencil, using the batch kernels.
+	//Both states of each cell are computed together, so the smoothness indicators are
+	//evaluated once per cell and variable. The pencil is padded with ghost or halo cells, and
+	//the cells -1 (lo) and ncells (hi) are included when they are beyond a boundary face
+	lo=pc->lo;
+	for(k=0;k<nvar;k++){
+		KERNEL(reconstruct_batch)(pc->U[k]-lo,pc->UL[k]-lo,pc->UR[k]-lo,pc->ncells+lo+pc->hi,order);
+	}
+
+#if ALLOW_SOLIDS
+	//Cells with a reduced stencil (near solids) are recomputed
+	for(p=0;p<pc->ncells;p++){
+		st=pc->st_size[p];
+		if(st!=order){
+			for(k=0;k<nvar;k++){
+				pc->UL[k][p]=KERNEL(reconstruct_L)(&(pc->U[k][p-(st-1)/2]),st);
+				pc->UR[k][p]=KERNEL(reconstruct_R)(&(pc->U[k][p-(st-1)/2]),st);
+			}
+		}
+	}
+#endif
+
+}
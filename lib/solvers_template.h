@@ -0,0 +1,836 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - solvers_template.h
+
+Content:
+  -This file contains the implementation of the Riemann solvers. It is a template: it is included
+   by kernels.c once for each combination of EQUATION_SYSTEM, SOLVER, ST and MULTICOMPONENT, which
+   are defined as constants before the inclusion. Function names are suffixed with KERNEL().
+  -The solvers of the inner faces work on all the faces of a pencil at once (batch solvers), while
+   the boundary faces use the solvers of a single face (t_wall).
+  
+*/
+
+
+#if EQUATION_SYSTEM == 2
+
+/*
+ Batch Riemann solvers. They compute the numerical fluxes of the n faces of a pencil at once, from the
+ left and right states stored as structure of arrays (see t_faces). The momentum components are
+ permuted when the arrays are set (component 1 normal to the faces), so there are no rotations. They
+ are written as simd loops, and the wave speed of the faces that are computed (wtype 1) is reduced in
+ the same loop. The fluxes of the other faces are overwritten by the caller. When SIMD_DISPATCH is
+ active, they are compiled for AVX-512, AVX2 and the baseline instruction set.
+*/
+
+
+//HLL flux of one component, from the wave speeds S1 < S2 and the left and right fluxes and states
+static inline double KERNEL(hll_flux)(double S1, double S2, double diffS, double FL, double FR, double WL, double WR){
+
+	return (S1>=0 ? FL : (S2<=0 ? FR : (S2*FL-S1*FR+S1*S2*(WR-WL))/(diffS)));
+}
+
+
+#if SOLVER == 0
+SIMD_DISPATCH_ATTR
+static double KERNEL(riemann_HLLE_batch)(t_faces *fc){
+
+	int j,n,stride;
+	double lambda;
+	const double * restrict UL0=fc->UL[0], * restrict UL1=fc->UL[1], * restrict UL2=fc->UL[2], * restrict UL3=fc->UL[3], * restrict UL4=fc->UL[4];
+	const double * restrict UR0=fc->UR[0], * restrict UR1=fc->UR[1], * restrict UR2=fc->UR[2], * restrict UR3=fc->UR[3], * restrict UR4=fc->UR[4];
+	double * restrict F0=fc->FL[0], * restrict F1=fc->FL[1], * restrict F2=fc->FL[2], * restrict F3=fc->FL[3], * restrict F4=fc->FL[4];
+	const char * restrict wtype=fc->wtype;
+	const double * restrict UL5=fc->UL[5], * restrict UR5=fc->UR[5];
+	double * restrict F5=fc->FL[5];
+#if ST==2||ST==3
+	const double * restrict ULe0=fc->ULe[0], * restrict ULe2=fc->ULe[2], * restrict ULe3=fc->ULe[3], * restrict ULe4=fc->ULe[4];
+	const double * restrict URe0=fc->URe[0], * restrict URe2=fc->URe[2], * restrict URe3=fc->URe[3], * restrict URe4=fc->URe[4];
+	const double * restrict pLe=fc->pLe, * restrict pRe=fc->pRe;
+#endif
+#if ST==3
+	const double * restrict zf=fc->z;
+#endif
+
+	n=fc->n;
+	stride=fc->stride;
+	lambda=0.0;
+
+#pragma omp simd reduction(max:lambda)
+	for(j=0;j<n;j++){
+		double uL, uR, vL, vR, wL, wR, pL, pR, HL, HR, cL, cR, gammaL, gammaR;
+		double raizrhoR, raizrhoL, sumRaizRho;
+		double u_hat, v_hat, w_hat, H_hat, c_hat, gamma_hat;
+		double S1, S2, diffS, maxS;
+		double z;
+#if MULTICOMPONENT
+		double phiL, phiR;
+#endif
+
+#if ST==3
+		z=zf[j];
+#else
+		z=0.0;
+#endif
+
+#if MULTICOMPONENT
+		phiL=UL5[j]/UL0[j];
+		phiR=UR5[j]/UR0[j];
+	#if MULTI_TYPE==1
+		gammaL=phiL;
+		gammaR=phiR;
+	#else
+		gammaL=1.0+1.0/phiL;
+		gammaR=1.0+1.0/phiR;
+	#endif
+#else
+		gammaL=_gamma_;
+		gammaR=_gamma_;
+#endif
+
+		/**Additional variables for the solver**/
+		uL=UL1[j]/UL0[j];
+		uR=UR1[j]/UR0[j];
+
+		vL=UL2[j]/UL0[j];
+		vR=UR2[j]/UR0[j];
+
+		wL=UL3[j]/UL0[j];
+		wR=UR3[j]/UR0[j];
+
+		pL=pressure_from_energy(ST, gammaL, UL4[j], uL, vL, wL, UL0[j], z);
+		pR=pressure_from_energy(ST, gammaR, UR4[j], uR, vR, wR, UR0[j], z);
+
+#if ST==3
+		HL=(UL4[j]-UL0[j]*_g_*z+pL)/UL0[j];
+		HR=(UR4[j]-UR0[j]*_g_*z+pR)/UR0[j];
+#else
+		HL=(UL4[j]+pL)/UL0[j];
+		HR=(UR4[j]+pR)/UR0[j];
+#endif
+
+		cL=sqrt(gammaL*pL/UL0[j]);
+		cR=sqrt(gammaR*pR/UR0[j]);
+
+		raizrhoL=sqrt(UL0[j]);
+		raizrhoR=sqrt(UR0[j]);
+		sumRaizRho=raizrhoR+raizrhoL;
+
+		/**Hat variables (Roe averages)**/
+		u_hat=(uR*raizrhoR+uL*raizrhoL)/sumRaizRho;
+		v_hat=(vR*raizrhoR+vL*raizrhoL)/sumRaizRho;
+		w_hat=(wR*raizrhoR+wL*raizrhoL)/sumRaizRho;
+		H_hat=(HR*raizrhoR+HL*raizrhoL)/sumRaizRho;
+#if MULTICOMPONENT
+	#if MULTI_TYPE==1
+		gamma_hat=1.0+ 1.0/( (phiR*raizrhoR+phiL*raizrhoL)/sumRaizRho );
+	#else
+		gamma_hat=(gammaR*raizrhoR+gammaL*raizrhoL)/sumRaizRho;
+	#endif
+#else
+		gamma_hat=_gamma_;
+#endif
+
+		c_hat=sqrt((gamma_hat-1)*(H_hat-0.5*(u_hat*u_hat+v_hat*v_hat+w_hat*w_hat)));
+
+		/**Wave speed estimation**/
+		S1=MIN(uL-cL,u_hat-c_hat);
+		S2=MAX(uR+cR, u_hat+c_hat);
+
+		maxS=MAX(ABS(S1),ABS(S2));
+		diffS=S2-S1;
+
+		/**HLLE flux calculation, from the physical fluxes. With source terms, the fluctuations
+		of the states with respect to the equilibrium are used (except for the normal momentum)**/
+#if ST==2||ST==3
+		F0[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j],UR1[j],UL0[j]-ULe0[j*stride],UR0[j]-URe0[j*stride]);
+		F1[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j]*uL+(pL-pLe[j*stride]),UR1[j]*uR+(pR-pRe[j*stride]),UL1[j],UR1[j]);
+		F2[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j]*vL,UR1[j]*vR,UL2[j]-ULe2[j*stride],UR2[j]-URe2[j*stride]);
+		F3[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j]*wL,UR1[j]*wR,UL3[j]-ULe3[j*stride],UR3[j]-URe3[j*stride]);
+		F4[j]=KERNEL(hll_flux)(S1,S2,diffS,uL*(UL4[j]+pL),uR*(UR4[j]+pR),UL4[j]-ULe4[j*stride],UR4[j]-URe4[j*stride]);
+#else
+		F0[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j],UR1[j],UL0[j],UR0[j]);
+		F1[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j]*uL+pL,UR1[j]*uR+pR,UL1[j],UR1[j]);
+		F2[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j]*vL,UR1[j]*vR,UL2[j],UR2[j]);
+		F3[j]=KERNEL(hll_flux)(S1,S2,diffS,UL1[j]*wL,UR1[j]*wR,UL3[j],UR3[j]);
+		F4[j]=KERNEL(hll_flux)(S1,S2,diffS,uL*(UL4[j]+pL),uR*(UR4[j]+pR),UL4[j],UR4[j]);
+#endif
+
+		/**Transport of the passive scalar (phi), upwinded with the mass flux**/
+		F5[j]=(F0[j]<TOL14 ? F0[j]*UR5[j]/UR0[j] : F0[j]*UL5[j]/UL0[j]);
+
+		if(wtype[j*stride]==1){
+			lambda=MAX(lambda,maxS);
+		}
+	}
+
+	return lambda;
+}
+#endif
+
+
+#if SOLVER == 1
+SIMD_DISPATCH_ATTR
+static double KERNEL(riemann_HLLC_batch)(t_faces *fc){
+
+	int j,n,stride;
+	double lambda;
+	const double * restrict UL0=fc->UL[0], * restrict UL1=fc->UL[1], * restrict UL2=fc->UL[2], * restrict UL3=fc->UL[3], * restrict UL4=fc->UL[4];
+	const double * restrict UR0=fc->UR[0], * restrict UR1=fc->UR[1], * restrict UR2=fc->UR[2], * restrict UR3=fc->UR[3], * restrict UR4=fc->UR[4];
+	double * restrict F0=fc->FL[0], * restrict F1=fc->FL[1], * restrict F2=fc->FL[2], * restrict F3=fc->FL[3], * restrict F4=fc->FL[4];
+	const char * restrict wtype=fc->wtype;
+	const double * restrict UL5=fc->UL[5], * restrict UR5=fc->UR[5];
+	double * restrict F5=fc->FL[5];
+
+	n=fc->n;
+	stride=fc->stride;
+	lambda=0.0;
+
+#pragma omp simd reduction(max:lambda)
+	for(j=0;j<n;j++){
+		double uL, uR, vL, vR, wR, wL, pL, pR, HL, HR, cL, cR;
+		double raizrhoR, raizrhoL, sumRaizRho;
+		double u_hat, v_hat, w_hat, H_hat, c_hat;
+		double S1, S2, maxS, S_star;
+		double uK, vK, wK, rhoK, SK, pK, EK, aux;
+		double FR0, FR1, FR2, FR3, FR4, FL0, FL1, FL2, FL3, FL4;
+		double W0, W1, W2, W3, W4; //star state
+		int right; //1 if the star state is on the right hand side of the contact wave
+
+		/**Additional variables for the solver**/
+		uL=UL1[j]/UL0[j];
+		uR=UR1[j]/UR0[j];
+
+		vL=UL2[j]/UL0[j];
+		vR=UR2[j]/UR0[j];
+
+		wL=UL3[j]/UL0[j];
+		wR=UR3[j]/UR0[j];
+
+		pL=(_gamma_-1.0)*(UL4[j]-0.5*UL0[j]*(uL*uL+vL*vL+wL*wL));
+		pR=(_gamma_-1.0)*(UR4[j]-0.5*UR0[j]*(uR*uR+vR*vR+wR*wR));
+
+		HL=(UL4[j]+pL)/UL0[j];
+		HR=(UR4[j]+pR)/UR0[j];
+
+		cL=sqrt(_gamma_*pL/UL0[j]);
+		cR=sqrt(_gamma_*pR/UR0[j]);
+
+		raizrhoL=sqrt(UL0[j]);
+		raizrhoR=sqrt(UR0[j]);
+		sumRaizRho=raizrhoR+raizrhoL;
+
+		/**Hat variables (Roe averages)**/
+		u_hat=(uR*raizrhoR+uL*raizrhoL)/sumRaizRho;
+		v_hat=(vR*raizrhoR+vL*raizrhoL)/sumRaizRho;
+		w_hat=(wR*raizrhoR+wL*raizrhoL)/sumRaizRho;
+		H_hat=(HR*raizrhoR+HL*raizrhoL)/sumRaizRho;
+
+		c_hat=sqrt((_gamma_-1)*(H_hat-0.5*(u_hat*u_hat+v_hat*v_hat+w_hat*w_hat)));
+
+		/**Physical flux calculation (the F of the eqs.)**/
+		FR0=UR1[j];
+		FL0=UL1[j];
+
+		FR1=UR1[j]*uR+pR;
+		FL1=UL1[j]*uL+pL;
+
+		FR2=UR1[j]*vR;
+		FL2=UL1[j]*vL;
+
+		FR3=UR1[j]*wR;
+		FL3=UL1[j]*wL;
+
+		FR4=uR*(UR4[j]+pR);
+		FL4=uL*(UL4[j]+pL);
+
+		/**Wave speed estimation**/
+		S1=MIN(uL-cL,u_hat-c_hat);
+		S2=MAX(uR+cR, u_hat+c_hat);
+
+		maxS=MAX(ABS(S1),ABS(S2));
+
+		S_star= ( pR-pL + UL1[j]*(S1-uL) - UR1[j]*(S2-uR) ) / ( UL0[j]*(S1-uL) - UR0[j]*(S2-uR) );
+
+		/**HLLC flux calculation. The star state of the side of the contact wave is computed**/
+		right=(S_star<=0);
+		uK=(right ? uR : uL);
+		vK=(right ? vR : vL);
+		wK=(right ? wR : wL);
+		rhoK=(right ? UR0[j] : UL0[j]);
+		SK=(right ? S2 : S1);
+		pK=(right ? pR : pL);
+		EK=(right ? UR4[j] : UL4[j]);
+
+		aux=rhoK*(SK-uK)/(SK-S_star);
+		W0=aux;
+		W1=aux*S_star;
+		W2=aux*vK;
+		W3=aux*wK;
+		W4=aux*( EK/rhoK + (S_star-uK)*(S_star + pK/(rhoK*(SK-uK))) );
+
+		if(right){
+			W0=FR0+S2*(W0-UR0[j]);
+			W1=FR1+S2*(W1-UR1[j]);
+			W2=FR2+S2*(W2-UR2[j]);
+			W3=FR3+S2*(W3-UR3[j]);
+			W4=FR4+S2*(W4-UR4[j]);
+		}else{
+			W0=FL0+S1*(W0-UL0[j]);
+			W1=FL1+S1*(W1-UL1[j]);
+			W2=FL2+S1*(W2-UL2[j]);
+			W3=FL3+S1*(W3-UL3[j]);
+			W4=FL4+S1*(W4-UL4[j]);
+		}
+
+		F0[j]=(S1>=0 ? FL0 : (S2<=0 ? FR0 : W0));
+		F1[j]=(S1>=0 ? FL1 : (S2<=0 ? FR1 : W1));
+		F2[j]=(S1>=0 ? FL2 : (S2<=0 ? FR2 : W2));
+		F3[j]=(S1>=0 ? FL3 : (S2<=0 ? FR3 : W3));
+		F4[j]=(S1>=0 ? FL4 : (S2<=0 ? FR4 : W4));
+
+		/**Transport of the passive scalar (phi), upwinded with the mass flux**/
+		F5[j]=(F0[j]<TOL14 ? F0[j]*UR5[j]/UR0[j] : F0[j]*UL5[j]/UL0[j]);
+
+		if(wtype[j*stride]==1){
+			lambda=MAX(lambda,maxS);
+		}
+	}
+
+	return lambda;
+}
+#endif
+
+
+#if SOLVER == 2
+SIMD_DISPATCH_ATTR
+static double KERNEL(riemann_HLLS_batch)(t_faces *fc){
+
+	int j,n,stride,normal_z;
+	double lambda;
+	const double * restrict UL0=fc->UL[0], * restrict UL1=fc->UL[1], * restrict UL2=fc->UL[2], * restrict UL3=fc->UL[3], * restrict UL4=fc->UL[4];
+	const double * restrict UR0=fc->UR[0], * restrict UR1=fc->UR[1], * restrict UR2=fc->UR[2], * restrict UR3=fc->UR[3], * restrict UR4=fc->UR[4];
+	double * restrict FL0=fc->FL[0], * restrict FL1=fc->FL[1], * restrict FL2=fc->FL[2], * restrict FL3=fc->FL[3], * restrict FL4=fc->FL[4];
+	double * restrict FR0=fc->FR[0], * restrict FR1=fc->FR[1], * restrict FR2=fc->FR[2], * restrict FR3=fc->FR[3], * restrict FR4=fc->FR[4];
+	const double * restrict ULe0=fc->ULe[0], * restrict URe0=fc->URe[0];
+	const double * restrict pLe=fc->pLe, * restrict pRe=fc->pRe;
+	const char * restrict wtype=fc->wtype;
+	const double * restrict UL5=fc->UL[5], * restrict UR5=fc->UR[5];
+	double * restrict FL5=fc->FL[5], * restrict FR5=fc->FR[5];
+
+	n=fc->n;
+	stride=fc->stride;
+	normal_z=fc->normal_z;
+	lambda=0.0;
+
+#pragma omp simd reduction(max:lambda)
+	for(j=0;j<n;j++){
+		double uL, uR, vL, vR, wL, wR, pL, pR, HL, HR, gammaL, gammaR;
+		double dpe, rhoLe, rhoRe;
+		double raizrhoR, raizrhoL, sumRaizRho;
+		double u_hat, v_hat, w_hat, H_hat, c_hat, gamma_hat, psi, chi;
+		double S1, S2, diffS, maxS;
+		double fR0, fR1, fR2, fR3, fR4, fL0, fL1, fL2, fL3, fL4;
+		double Sm1, Sm4, B0, B2, B3, B4; //source term and its contribution to the states (the other components are zero)
+#if MULTICOMPONENT
+		double phiL, phiR;
+#endif
+
+#if MULTICOMPONENT
+		phiL=UL5[j]/UL0[j];
+		phiR=UR5[j]/UR0[j];
+	#if MULTI_TYPE==1
+		gammaL=phiL;
+		gammaR=phiR;
+	#else
+		gammaL=1.0+1.0/phiL;
+		gammaR=1.0+1.0/phiR;
+	#endif
+#else
+		gammaL=_gamma_;
+		gammaR=_gamma_;
+#endif
+
+		/**Additional variables for the solver**/
+		uL=UL1[j]/UL0[j];
+		uR=UR1[j]/UR0[j];
+
+		vL=UL2[j]/UL0[j];
+		vR=UR2[j]/UR0[j];
+
+		wL=UL3[j]/UL0[j];
+		wR=UR3[j]/UR0[j];
+
+		pL=(gammaL-1.0)*(UL4[j]-0.5*UL0[j]*(uL*uL+vL*vL+wL*wL));
+		pR=(gammaR-1.0)*(UR4[j]-0.5*UR0[j]*(uR*uR+vR*vR+wR*wR));
+
+		HL=(UL4[j]+pL)/UL0[j];
+		HR=(UR4[j]+pR)/UR0[j];
+
+		raizrhoL=sqrt(UL0[j]);
+		raizrhoR=sqrt(UR0[j]);
+		sumRaizRho=raizrhoR+raizrhoL;
+
+		/**Hat variables (Roe averages)**/
+		u_hat=(uR*raizrhoR+uL*raizrhoL)/sumRaizRho;
+		v_hat=(vR*raizrhoR+vL*raizrhoL)/sumRaizRho;
+		w_hat=(wR*raizrhoR+wL*raizrhoL)/sumRaizRho;
+		H_hat=(HR*raizrhoR+HL*raizrhoL)/sumRaizRho;
+#if MULTICOMPONENT
+	#if MULTI_TYPE==1
+		gamma_hat=1.0+ 1.0/( (phiR*raizrhoR+phiL*raizrhoL)/sumRaizRho );
+	#else
+		gamma_hat=(gammaR*raizrhoR+gammaL*raizrhoL)/sumRaizRho;
+	#endif
+#else
+		gamma_hat=_gamma_;
+#endif
+
+		c_hat=sqrt((gamma_hat-1)*(H_hat-0.5*(u_hat*u_hat+v_hat*v_hat+w_hat*w_hat)));
+
+		/**Physical flux calculation (the F of the eqs.)**/
+		fR0=UR1[j];
+		fL0=UL1[j];
+
+		fR1=UR1[j]*uR+pR;
+		fL1=UL1[j]*uL+pL;
+
+		fR2=UR1[j]*vR;
+		fL2=UL1[j]*vL;
+
+		fR3=UR1[j]*wR;
+		fL3=UL1[j]*wL;
+
+		fR4=uR*(UR4[j]+pR);
+		fL4=uL*(UL4[j]+pL);
+
+		/**Wave speed estimation**/
+		S1=u_hat-c_hat;
+		S2=u_hat+c_hat;
+
+		maxS=MAX(ABS(S1),ABS(S2));
+		diffS=S2-S1;
+
+		/**Source term, only in the direction of gravity**/
+		dpe=pRe[j*stride]-pLe[j*stride];
+		rhoRe=URe0[j*stride];
+		rhoLe=ULe0[j*stride];
+
+		if(normal_z){ //this is neccessary when considering atm pressures of 1.e5, to keep precision
+			Sm1=(UR0[j]+UL0[j])*(dpe)/(rhoRe+rhoLe);
+		}else{
+			Sm1=0.0;
+		}
+		Sm4=Sm1*u_hat;
+
+		psi=(rhoRe-rhoLe)*c_hat*c_hat/(dpe+TOL14);
+		chi=0.5*(psi-1.0)*(v_hat*v_hat+w_hat*w_hat);
+
+		B0=-psi*Sm1/(S1*S2);
+		B2=-psi*v_hat/(S1*S2)*Sm1;
+		B3=-psi*w_hat/(S1*S2)*Sm1;
+		B4=-(H_hat-u_hat*u_hat+chi)/(S1*S2)*Sm1;
+
+		/**HLLS flux calculation, at the left hand side of the face**/
+		FL0[j]=(S1>=0 ? fL0 : (S2<=0 ? fR0-0.0 : (S2*fL0-S1*fR0+S1*S2*(UR0[j]-UL0[j])+S1*(0.0-S2*B0))/(diffS)));
+		FL1[j]=(S1>=0 ? fL1 : (S2<=0 ? fR1-Sm1 : (S2*fL1-S1*fR1+S1*S2*(UR1[j]-UL1[j])+S1*(Sm1-S2*0.0))/(diffS)));
+		FL2[j]=(S1>=0 ? fL2 : (S2<=0 ? fR2-0.0 : (S2*fL2-S1*fR2+S1*S2*(UR2[j]-UL2[j])+S1*(0.0-S2*B2))/(diffS)));
+		FL3[j]=(S1>=0 ? fL3 : (S2<=0 ? fR3-0.0 : (S2*fL3-S1*fR3+S1*S2*(UR3[j]-UL3[j])+S1*(0.0-S2*B3))/(diffS)));
+		FL4[j]=(S1>=0 ? fL4 : (S2<=0 ? fR4-Sm4 : (S2*fL4-S1*fR4+S1*S2*(UR4[j]-UL4[j])+S1*(Sm4-S2*B4))/(diffS)));
+
+		/**and at the right hand side**/
+		FR0[j]=(S1>=0 ? fL0+0.0 : (S2<=0 ? fR0 : (S2*fL0-S1*fR0+S1*S2*(UR0[j]-UL0[j])+S2*(0.0-S1*B0))/(diffS)));
+		FR1[j]=(S1>=0 ? fL1+Sm1 : (S2<=0 ? fR1 : (S2*fL1-S1*fR1+S1*S2*(UR1[j]-UL1[j])+S2*(Sm1-S1*0.0))/(diffS)));
+		FR2[j]=(S1>=0 ? fL2+0.0 : (S2<=0 ? fR2 : (S2*fL2-S1*fR2+S1*S2*(UR2[j]-UL2[j])+S2*(0.0-S1*B2))/(diffS)));
+		FR3[j]=(S1>=0 ? fL3+0.0 : (S2<=0 ? fR3 : (S2*fL3-S1*fR3+S1*S2*(UR3[j]-UL3[j])+S2*(0.0-S1*B3))/(diffS)));
+		FR4[j]=(S1>=0 ? fL4+Sm4 : (S2<=0 ? fR4 : (S2*fL4-S1*fR4+S1*S2*(UR4[j]-UL4[j])+S2*(Sm4-S1*B4))/(diffS)));
+
+		/**Transport of the passive scalar (phi), upwinded with the mass flux**/
+		FR5[j]=(FR0[j]<TOL14 ? FR0[j]*UR5[j]/UR0[j] : FL0[j]*UL5[j]/UL0[j]);
+		FL5[j]=FR5[j];
+
+		if(wtype[j*stride]==1){
+			lambda=MAX(lambda,maxS);
+		}
+	}
+
+	return lambda;
+}
+#endif
+
+/*
+ Solvers of the boundary faces. The states of the face are given in the frame of the 1D problem
+ (component 1 normal to the face), as for the batch solvers, and so are the fluxes.
+*/
+
+static void KERNEL(compute_transmissive_euler)(t_wall *wall, int wp){
+
+	int m;
+	double WR[6], WL[6]; /**<Auxiliar array of variables of the 1D problem**/
+	double uL, uR, vL, vR, wL, wR, pL, pR, gammaL, gammaR;
+	double FR[5], FL[5];
+	double F_star[5];
+#if MULTICOMPONENT	
+	double phiL, phiR;
+#endif
+
+
+	/**States of the 1D problem (the momentum is already permuted, see sweep_fluxes())**/
+
+	WR[0]=wall->UR[0];
+	WL[0]=wall->UL[0];
+
+	WR[1]=wall->UR[1];
+	WL[1]=wall->UL[1];
+
+	WR[2]=wall->UR[2];
+	WL[2]=wall->UL[2];
+
+	WR[3]=wall->UR[3];
+	WL[3]=wall->UL[3];
+
+
+	WR[4]=wall->UR[4];
+	WL[4]=wall->UL[4];
+
+#if MULTICOMPONENT
+	WR[5]=wall->UR[5];
+	WL[5]=wall->UL[5];
+	phiL=WL[5]/WL[0];
+	phiR=WR[5]/WR[0];
+	#if MULTI_TYPE==1
+		gammaL=phiL;
+		gammaR=phiR;
+	#else
+	gammaL=1.0+1.0/phiL;
+	gammaR=1.0+1.0/phiR;
+	#endif
+#else
+	gammaL=_gamma_;
+	gammaR=_gamma_;
+#endif
+
+
+	/**Additional variables for the solver**/
+	uL=WL[1]/WL[0];
+	uR=WR[1]/WR[0];
+
+	vL=WL[2]/WL[0];
+	vR=WR[2]/WR[0];
+
+      wL=WL[3]/WL[0];
+	wR=WR[3]/WR[0];
+
+	pL=(gammaL-1.0)*(WL[4]-0.5*WL[0]*(uL*uL+vL*vL+wL*wL));
+	pR=(gammaR-1.0)*(WR[4]-0.5*WR[0]*(uR*uR+vR*vR+wR*wR));
+
+
+
+	/**Physical flux calculation (the F of the eqs.)**/
+
+      FR[0]=WR[1];
+	FL[0]=WL[1];
+
+//#if ST==99
+//      pRe  =wall->pRe;
+//      pLe  =wall->pLe;
+//	FR[1]=WR[1]*uR+(pR-pRe);
+//	FL[1]=WL[1]*uL+(pL-pLe);
+//#else
+	FR[1]=WR[1]*uR+pR;
+	FL[1]=WL[1]*uL+pL;
+//#endif
+
+	FR[2]=WR[1]*vR;
+	FL[2]=WL[1]*vL;
+
+      FR[3]=WR[1]*wR;
+	FL[3]=WL[1]*wL;
+
+	FR[4]=uR*(WR[4]+pR);
+	FL[4]=uL*(WL[4]+pL);
+
+
+	/**the star flux is equal to the physical flux**/
+	for(m=0;m<5;m++){
+		if (wp==1 || wp==4 || wp==5){ //bottom and left interfaces, the innercell flux is FR
+			F_star[m]=FR[m];
+		}else{
+			F_star[m]=FL[m];
+		}
+	}
+
+	for(m=0;m<5;m++){
+		wall->fR_star[m]=F_star[m];
+		wall->fL_star[m]=F_star[m];
+	}
+
+
+
+}
+
+static void KERNEL(compute_solid_euler_hlle)(t_wall *wall, double *lambda_max, int wp){
+
+	int m;
+	double WR[5], WL[5]; /**<Auxiliar array of variables of the 1D problem**/
+	double uL, uR, vL, vR, wL, wR, pL, pR, HL, HR, cL, cR;
+#if ST==2||ST==3 //fluctuation version for source terms	
+	double pLe, pRe, rhoprimeL, rhoprimeR, EprimeL, EprimeR;
+#endif
+	double raizrhoR, raizrhoL, sumRaizRho;
+	double u_hat, v_hat, w_hat, H_hat, c_hat;
+	double S1, S2, diffS, maxS;
+	double FR[5], FL[5];
+	double F_star[5];
+
+	/**States of the 1D problem (the momentum is already permuted, see sweep_fluxes())**/
+
+	WR[0]=wall->UR[0];
+	WL[0]=wall->UL[0];
+
+	WR[1]=wall->UR[1];
+	WL[1]=wall->UL[1];
+
+	WR[2]=wall->UR[2];
+	WL[2]=wall->UL[2];
+
+	WR[3]=wall->UR[3];
+	WL[3]=wall->UL[3];
+
+
+
+	WR[4]=wall->UR[4];
+	WL[4]=wall->UL[4];
+
+
+      for(m=0;m<5;m++){
+		if (wp==1 || wp==4 || wp==5){ //bottom and left interfaces, the innercell state is WR, otherwise is WL
+                  if (m==1){
+                        WL[m]=-WR[m];
+                  }else{
+                        WL[m]= WR[m];
+                  }
+		}else{
+                  if (m==1){
+                        WR[m]=-WL[m];
+                  }else{
+                        WR[m]= WL[m];
+                  }
+		}
+	}
+
+	#if ST==2||ST==3
+	if (wp==1 || wp==4 || wp==5){ //bottom and left interfaces, the innercell state is WR, otherwise is WL
+		pRe = wall->pRe;
+		pLe = pRe;
+		rhoprimeR=WR[0]-wall->URe[0];
+		rhoprimeL=rhoprimeR;
+		EprimeR=WR[4]-wall->URe[4];
+		EprimeL=EprimeR;
+	}else{
+		pLe = wall->pLe;
+		pRe = pLe;
+		EprimeL=WL[4]-wall->ULe[4];
+		EprimeR=EprimeL;
+		rhoprimeL=WL[0]-wall->ULe[0];
+		rhoprimeR=rhoprimeL;
+	}
+
+
+
+      #endif
+
+
+	/**Additional variables for the solver**/
+	uL=WL[1]/WL[0];
+	uR=WR[1]/WR[0];
+
+	vL=WL[2]/WL[0];
+	vR=WR[2]/WR[0];
+
+      wL=WL[3]/WL[0];
+	wR=WR[3]/WR[0];
+
+	pL=pressure_from_energy(ST, _gamma_, WL[4], uL, vL, wL, WL[0], wall->z);
+	pR=pressure_from_energy(ST, _gamma_, WR[4], uR, vR, wR, WR[0], wall->z);
+
+#if ST==3
+	HL=(WL[4]-WL[0]*_g_*wall->z+pL)/WL[0];
+	HR=(WR[4]-WR[0]*_g_*wall->z+pR)/WR[0];
+#else
+	HL=(WL[4]+pL)/WL[0];
+	HR=(WR[4]+pR)/WR[0];
+#endif
+
+
+	cL=sqrt(_gamma_*pL/WL[0]);
+	cR=sqrt(_gamma_*pR/WR[0]);
+
+
+	raizrhoL=sqrt(WL[0]);
+	raizrhoR=sqrt(WR[0]);
+	sumRaizRho=raizrhoR+raizrhoL;
+
+	/**Hat variables (Roe averages)**/
+	u_hat=(uR*raizrhoR+uL*raizrhoL)/sumRaizRho;
+	v_hat=(vR*raizrhoR+vL*raizrhoL)/sumRaizRho;
+      w_hat=(wR*raizrhoR+wL*raizrhoL)/sumRaizRho;
+	H_hat=(HR*raizrhoR+HL*raizrhoL)/sumRaizRho;
+
+	c_hat=sqrt((_gamma_-1)*(H_hat-0.5*(u_hat*u_hat+v_hat*v_hat+w_hat*w_hat)));
+
+	/**Physical flux calculation (the F of the eqs.)**/
+
+	FR[0]=WR[1];
+	FL[0]=WL[1];
+
+#if ST==2||ST==3
+	FR[1]=WR[1]*uR+(pR-pRe);
+	FL[1]=WL[1]*uL+(pL-pLe);
+#else
+	FR[1]=WR[1]*uR+pR;
+	FL[1]=WL[1]*uL+pL;
+#endif
+
+	FR[2]=WR[1]*vR;
+	FL[2]=WL[1]*vL;
+
+      FR[3]=WR[1]*wR;
+	FL[3]=WL[1]*wL;
+
+	FR[4]=uR*(WR[4]+pR);
+	FL[4]=uL*(WL[4]+pL);
+
+#if ST==2||ST==3
+	WL[0]=rhoprimeL;
+	WR[0]=rhoprimeR;
+	WL[4]=EprimeL;
+	WR[4]=EprimeR;
+#endif
+
+
+
+
+	/**Wave speed estimation**/
+
+	S1=MIN(uL-cL,u_hat-c_hat);
+	S2=MAX(uR+cR, u_hat+c_hat);
+
+
+	maxS=MAX(ABS(S1),ABS(S2));
+	diffS=S2-S1;
+
+	/**HLLE flux calculation**/
+	for(m=0;m<5;m++){
+		if(S1>=0){
+			F_star[m]=FL[m];
+		}else if(S2<=0){
+			F_star[m]=FR[m];
+		}else{
+                  F_star[m]=(S2*FL[m]-S1*FR[m]+S1*S2*(WR[m]-WL[m]))/(diffS);
+            }
+	}
+
+
+	for(m=0;m<5;m++){
+		wall->fR_star[m]=F_star[m];
+		wall->fL_star[m]=F_star[m];
+	}
+
+
+	*lambda_max=MAX(*lambda_max,maxS);
+
+}
+
+#if SOLVER == 3 //Roe solver, not available yet
+static void KERNEL(compute_euler_Roe)(t_wall *wall,double *lambda_max){
+
+	printf("%s We are working on it. Sorry!\n",WAR);
+	abort();
+}
+
+#endif
+
+#endif
+
+#if EQUATION_SYSTEM == 1
+//Burgers flux of the faces of a pencil (see the batch Riemann solvers above). The boundary faces
+//(wtype 3) are also computed
+SIMD_DISPATCH_ATTR
+static double KERNEL(burgers_batch)(t_faces *fc){
+
+	int j,n,stride;
+	double lambda;
+	const double * restrict UL=fc->UL[0], * restrict UR=fc->UR[0];
+	double * restrict F=fc->FL[0];
+	const char * restrict wtype=fc->wtype;
+
+	n=fc->n;
+	stride=fc->stride;
+	lambda=0.0;
+
+#pragma omp simd reduction(max:lambda)
+	for(j=0;j<n;j++){
+		double Savg, fL, fR, dU;
+
+		fL=UL[j]*UL[j]/2.0;
+		fR=UR[j]*UR[j]/2.0;
+
+		Savg=(UL[j]+UR[j])*0.5;
+		dU=UR[j]-UL[j];
+
+		F[j]=0.5*(fL+fR - ABS(Savg)*dU);
+
+		if(wtype[j*stride]==1||wtype[j*stride]==3){
+			lambda=MAX(lambda,Savg);
+		}
+	}
+
+	return lambda;
+}
+
+#endif
+
+#if EQUATION_SYSTEM == 0
+//Upwind flux of the linear advection equation at the faces of a pencil (see the batch Riemann solvers
+//above). The boundary faces (wtype 3) are also computed
+SIMD_DISPATCH_ATTR
+static double KERNEL(linear_batch)(t_faces *fc){
+
+	int j,n,stride;
+	double lambda,Savg;
+	const double * restrict UL=fc->UL[0], * restrict UR=fc->UR[0];
+	double * restrict F=fc->FL[0];
+	const char * restrict wtype=fc->wtype;
+
+	n=fc->n;
+	stride=fc->stride;
+	Savg=fc->vel;
+	lambda=0.0;
+
+#pragma omp simd reduction(max:lambda)
+	for(j=0;j<n;j++){
+		double fL, fR, dU;
+
+		fL=UL[j]*Savg;
+		fR=UR[j]*Savg;
+
+		dU=UR[j]-UL[j];
+
+		F[j]=0.5*(fL+fR - ABS(Savg)*dU);
+
+		if(wtype[j*stride]==1||wtype[j*stride]==3){
+			lambda=MAX(lambda,Savg);
+		}
+	}
+
+	return lambda;
+}
+#endif
@@ -17,6 +17,12 @@ Content:
 #ifndef STRUCTURES_H
 #define STRUCTURES_H
 #include "definitions.h"
+#if USE_MPI
+#include <mpi.h>
+#endif
+#if ASYNC_OUTPUT
+#include <pthread.h>
+#endif
 
 
 ////////////////////////////////////////////////////
@@ -24,39 +30,30 @@ Content:
 ////////////////////////////////////////////////////
 
 
-typedef struct t_node_ t_node;
 typedef struct t_cell_ t_cell;
 typedef struct t_wall_ t_wall;
 typedef struct t_mesh_ t_mesh;
 typedef struct t_sim_ t_sim;
+typedef struct t_rkstage_ t_rkstage;
+typedef struct t_kernels_ t_kernels;
 typedef struct t_solid_ t_solid;
 typedef struct t_stl_ t_stl;
 typedef struct t_triangle_ t_triangle;
-
-
-struct t_node_{
-	int id;
-	double x,y,z; //coordinates of the node
-
-};
+typedef struct t_pencil_ t_pencil;
+typedef struct t_faces_ t_faces;
+typedef struct t_profiler_ t_profiler;
+typedef struct t_comm_ t_comm;
+typedef struct t_snapshot_ t_snapshot;
+typedef struct t_output_ t_output;
+typedef struct t_checkpoint_ t_checkpoint;
 
 
 struct t_cell_{
 	int id;
 	int l,m,n;//index in cartesian reference
-	double *U; //array of conserved variables. When using Euler: rho, rhou, rhov, E, rhophi
-	double *U_aux; //aux array of conserved variables for RK stepping
-	double *Ue; //array of conserved variables for the equilibrium state
-	double *S; //array of source terms
-	double *S_corr; //source term correction for well-balancing
-	double pres,prese,u_int; 
 	double dx,dy,dz; //cell sizes
 	double xc,yc,zc; //cell centers
 	
-	int n1,n2,n3,n4,n5,n6,n7,n8; //ID's of the nodes of the cell
-	int w1_id,w2_id,w3_id,w4_id,w5_id,w6_id; //ID's of the walls of the cell
-	t_wall *w1, *w2, *w3, *w4, *w5, *w6; //pointer to cell walls
-
 	int type; //Cell type: 0=solid, 1=nomal
 	int ghost; //Ghost cell: 0=no, 1=yes
 	double xim,yim,zim;
@@ -66,25 +63,23 @@ struct t_cell_{
 	int solid_id,triangle_id;
 	int out; //auxiliary variable for assing_cell_type() . It indicates that a cell is outside of a surface
 	t_triangle *tri;
-	int st_sizeX, st_sizeY, st_sizeZ;	//stencil size
-	int stX[9], stY[9], stZ[9];		//id's of the cells in the X and Y stencil.
+	int st_sizeX, st_sizeY, st_sizeZ;	//stencil size. The stencil is centered at the cell, along the pencil of each direction
 
 };
 
 
+//Face descriptor. Walls are not stored in memory: a t_wall is filled on the fly
+//for each face of the structured grid (see gridindex.h) and passed to the solvers.
+//Single face, for the solvers of the boundary faces. The states and fluxes are given in the frame of
+//the face (the momentum component 1 is the normal one), see t_faces
 struct t_wall_{
-	int id;
-	int stencil; //this could be 1, 3, 5 or 7, depending on the method stencil
-	double *UL, *UR; //array of reconstructed values on the left and right hand side of the wall, coming from (WENO/TENO) reconstruction
-	double *fR_star,*fL_star; //array of numerical fluxes
-	double *ULe, *URe; //array of reconstructed equilibrium values on the left and right hand side of the wall, coming from (WENO/TENO) reconstruction, for the EQUILIBRIUM
+	double UL[MAX_NVAR], UR[MAX_NVAR]; //reconstructed values on the left and right hand side of the wall, coming from (WENO/TENO) reconstruction
+	double fR_star[MAX_NVAR],fL_star[MAX_NVAR]; //numerical fluxes
+	double ULe[MAX_NVAR], URe[MAX_NVAR]; //reconstructed values on the left and right hand side of the wall, for the EQUILIBRIUM
 	double pRe,pLe; //equilibrium pressures on the left and right hand side of the wall
 	int cellR_id, cellL_id; //id of the right and left cell
-	t_cell *cellR, *cellL; //pointers to the left and right hand cells of the wall
-	double nx, ny, nz; //wall normals
 	double z; //height in z direction
       int wtype, boundId; //wtype: 1 for inner walls, 3 for transmissive boundary walls and 4 for solid walls
-      double vel; //advection velocity projected onto the wall normal
 };
 
 
@@ -95,15 +90,37 @@ struct t_mesh_{
 	double Lx, Ly, Lz;
 	double u_x, u_y, u_z;
 	int ncells;
-	int nwalls;
+	int nfaces[3]; //number of faces normal to x, y and z
 	int nnodes;
 	int bc[6]; //boundary type
 	int flux_bc_flag,cell_bc_flag; //cell_bc_flag is 1 if all the boundaries are updated imposing cell averages
 						 //flux_bc_flag is 1 if all the boundaries are updated with numerical fluxes
 	int periodicX,periodicY,periodicZ;
 	t_cell *cell;
-	t_wall *wall;
-	t_node *node;
+
+	//State storage (structure of arrays): U[k][i] is the variable k of the cell with id i.
+	//Each U[k] is a contiguous and aligned array of ncells values.
+	double **U; //conserved variables. When using Euler: rho, rhou, rhov, rhow, E, rhophi
+	double **U_aux; //aux conserved variables for RK stepping
+	double **Ue; //conserved variables for the equilibrium state
+	double **S_corr; //source term correction for well-balancing
+	double *prese; //equilibrium pressure
+	double **divF; //flux divergence, accumulated by the direction sweeps
+	double **W; //primitive variables u, v, w, p (W[PRIM_U..PRIM_P][i]), updated once per stage. Only allocated for the reconstruction in primitive variables
+
+	//Face storage, one set of arrays per direction d (0: x, 1: y, 2: z): ULe[d][k][f] is
+	//the variable k at the face f. Face ids are computed in gridindex.h.
+	double **ULe[3], **URe[3]; //reconstructed equilibrium states (only allocated when ST!=0)
+	double *pLe[3], *pRe[3]; //reconstructed equilibrium pressures (only allocated when ST!=0)
+	char *wtype[3], *boundId[3]; //wall type and boundary id (0 for faces which are not at a boundary)
+
+	//Work lists, built once the cell and wall types are known (see build_work_lists()), so that the
+	//solid part of the domain is not visited by the time loop
+	int nactive, *active; //fluid cells, which are updated by the time integration (type!=0 and ghost!=1)
+	int nghost, *ghosts; //ghost cells of the immersed boundaries (ghost==1), see build_ghost_table() in ibmutils.c
+	int *gni; //ghost cell table, packed by ghost g: neighbours gni[8*g+q] of the image point,
+	double *gli, *gnr; //their weights gli[8*g+q] and normal gnr[3*g+c] of the facet
+	int npencils[3], *pencils[3]; //pencils of direction d (pencil_index() numbering) with at least one face with flux (wtype!=0)
 
 	double lambda_max;
 	double tke;
@@ -111,15 +128,153 @@ struct t_mesh_{
 
 	t_sim *sim;
 
+	//Domain decomposition (see mpicomm.c). xcells, ycells, zcells and ncells are the cells of the
+	//subdomain of this rank. Without MPI, the subdomain is the whole grid
+	int gxcells, gycells, gzcells; //cells of the whole grid
+	int offset[3]; //global (l,m,n) indices of the first cell of the subdomain
+	t_comm *comm;
+
+};
+
+//Coefficients of a stage of the low-storage Runge-Kutta schemes, which use two registers (U and
+//U_aux). The stage computes x = a*U_aux + b*U - c*dt*R(U), where R is the residual (flux divergence
+//minus source term). Then, U=x or, if mix is 1, U_aux = d*U_aux + e*x and U = f*U_aux + g*x.
+//U_aux is always set to U before the first stage.
+struct t_rkstage_{
+	double a,b,c;
+	int mix;
+	double d,e,f,g;
+};
+
+//Kernels specialized for the equations and numerical scheme of the run. They are selected once,
+//after reading configure.input (see kernels.c and reconst.c)
+struct t_kernels_{
+	void (*reconstruct_pencil)(t_pencil *pc, int nvar, int order); //reconstruction of a pencil (TYPE_REC)
+	int (*compute_fluxes)(t_mesh *mesh, t_sim *sim, int stage); //flux sweeps (EQUATION_SYSTEM, SOLVER, ST, MULTICOMPONENT)
+};
+
+//Accumulated wall-clock times of the phases of the computation (see profiler.h)
+struct t_profiler_{
+	int nthreads; //number of threads
+	double *time; //time[th*PROF_STRIDE+phase] is the time spent by the thread th in the phase
+	double t_start; //start of the time loop
+	double t_report; //time of the previous report
+	long steps; //number of time steps
+	long steps_report; //number of time steps at the previous report
 };
 
 struct t_sim_{
 	double dt,t,CFL;  //dynamic variables
 	double tf, tVolc; //static variables
-	int rk_steps; //number of Runge-Kutta steps (1 if 1-st order, 3 otherwise)
+	int rk_scheme; //time integration scheme (0: automatic, 1: Euler, 2: SSPRK(3,3), 3: SSPRK(4,3), 4: SSPRK(10,4))
+	int rk_steps; //number of Runge-Kutta stages
+	double rk_ssp; //SSP coefficient of the scheme, which scales the time step
+	t_rkstage rk[MAX_RK_STAGES]; //stage coefficients
 	int order; //order of accuracy
 	int nvar;  //number of variables
 
+	//Equations and numerical scheme. They are read from configure.input, the macros of
+	//definitions.h with the same name are the default values
+	int eq_system; //EQUATION_SYSTEM
+	int solver; //SOLVER
+	int type_rec; //TYPE_REC
+	int rec_vars; //REC_VARIABLES
+	int st; //ST
+	int multicomponent; //MULTICOMPONENT
+	int print_rho, print_velocity, print_energy, print_pressure, print_overpressure, print_solutes, print_potentialtem; //variables written in the vtk files
+	int vtk_format; //VTK_FORMAT
+	double checkpoint_time; //simulated time between checkpoints (0: no checkpoints)
+	double checkpoint_walltime; //wall-clock time between checkpoints, in seconds (0: no checkpoints)
+	int restart; //1: the run is resumed from the last checkpoint, if there is one
+	t_kernels kernels;
+	t_profiler prof; //timers of the run (PROFILE)
+
+};
+
+
+//Cartesian communicator of the subdomains and halo buffers. The halo of direction d is exchanged
+//only when the direction is split among several ranks; otherwise the pencils wrap around (periodic)
+//or are padded with ghost cells, as in the serial code. halo[d][s] keeps the cells beyond the lower (s=0) or upper (s=1) boundary
+//of the subdomain: halo[d][s][(k*npencils+q)*width+w] is the variable k of the w-th cell of the
+//pencil q (pencil_index() numbering), ordered along the direction
+struct t_comm_{
+	int rank, nranks;
+	int dims[3], coords[3]; //ranks along each direction and position of this rank
+	int nbr[3][2]; //neighbour rank across the lower and upper boundary, -1 if there is none (or the direction is not split)
+	int width; //halo width: half stencil plus one cell
+	int nvar;
+	double *halo[3][2], *send[3][2]; //received halos and packed boundary cells
+#if USE_MPI
+	MPI_Comm cart;
+	MPI_Request req[3][4]; //receives and sends in flight, per direction
+#endif
+};
+
+
+//Copy of the state to be written by the background writer (ASYNC_OUTPUT). mesh is a copy of the
+//mesh structure whose U points to the copy of the state, so that the writers of postproc.c can be used
+struct t_snapshot_{
+	double **U; //conserved variables at the time of the dump
+	t_mesh *mesh;
+	char vtkfile[1024], listfile[1024]; //files to write (empty if not written)
+};
+
+//Output stage: circular queue of OUTPUT_QUEUE snapshots, written in order by the writer thread.
+//When the queue is full, the computation waits for the writer (back-pressure)
+struct t_output_{
+	int nslots; //size of the queue
+	int nvar;
+	t_snapshot *slot;
+	int head, count; //first snapshot pending and number of snapshots pending
+	int stop; //1 when the writer must finish
+	double time_vtk, time_list; //time spent by the writer thread
+#if ASYNC_OUTPUT
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t ready, free; //a snapshot has been queued, a slot has been released
+#endif
+};
+
+
+//Checkpoints of the run (checkpoint.c). The files are rotated: path[0] is the newest one, and the
+//previous ones are kept in path[1]...path[CHECKPOINT_KEEP-1]
+struct t_checkpoint_{
+	int enabled; //1 if checkpoints are written
+	char path[CHECKPOINT_KEEP][1024]; //files of this rank, from the newest to the oldest
+	int seq; //number of the last checkpoint
+	double t_last; //simulated time of the last checkpoint
+	double wall_last; //wall-clock time of the last checkpoint
+	int stop; //1 if the run must stop after the checkpoint (a SIGTERM or SIGUSR1 has been received)
+};
+
+
+//Work buffers for the sweep along a pencil (1D line of cells) of the mesh. Each thread owns one.
+struct t_pencil_{
+	int ncells; //number of cells of the pencil
+	int l,m,n; //indices of the first cell of the pencil
+	int order; //order of the reconstruction along the pencil (1 if the direction has fewer cells than the stencil)
+	int lo, hi; //1 if the cell -1 (lo) or ncells (hi) is a ghost cell or a cell of a neighbour subdomain, and is also reconstructed
+	int *id; //ids of the cells of the pencil (-1 for the cells -1 and ncells)
+	int *st_size; //stencil size of the cells of the pencil (only used with solids)
+	double **U; //line buffer: U[k][p] is the variable k of the cell p, with p=-PENCIL_HALO...ncells+PENCIL_HALO-1 (padded with periodic, halo or ghost cells)
+	double **UL, **UR; //reconstructed values at the right (UL) and left (UR) hand side of the cells of the pencil, p=-1...ncells
+	double **FL, **FR; //numerical fluxes at the left and right hand side of the faces of the pencil, j=0...ncells (they only differ with HLLS)
+	double *zf; //height of the faces of the pencil (ST==3)
+};
+
+//Faces of a pencil for the batch Riemann solvers (solvers_template.h), as structure of arrays. The
+//momentum components are permuted so that the component 1 is the one normal to the faces, and the
+//solvers work on the 1D problem without rotations (see sweep_fluxes())
+struct t_faces_{
+	int n; //number of faces
+	double *UL[MAX_NVAR], *UR[MAX_NVAR]; //states at the left and right hand side of the face j, UL[k][j] and UR[k][j]
+	double *FL[MAX_NVAR], *FR[MAX_NVAR]; //numerical fluxes at the left and right hand side of the face j
+	const char *wtype; //wall types of the faces, wtype[j*stride]
+	double *ULe[MAX_NVAR], *URe[MAX_NVAR], *pLe, *pRe; //equilibrium states and pressures (ST!=0), ULe[k][j*stride]
+	int stride; //stride of the face arrays of the mesh along the pencil
+	double *z; //height of the faces (ST==3)
+	double vel; //advection velocity normal to the faces (linear advection)
+	int normal_z; //1 if the faces are normal to z
 };
 
 
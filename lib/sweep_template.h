@@ -0,0 +1,444 @@
+/*
+
+Authors:
+ - Adrián Navas Montilla
+ - Isabel Echeverribar
+
+Copyright (C) 2019-2024 The authors.
+
+File:
+  - sweep_template.h
+
+Content:
+  -This file contains the flux sweeps along the pencils of the mesh, the source terms and the
+   update of the Runge-Kutta stages. It is a template: it is included by kernels.c once for each
+   combination of EQUATION_SYSTEM, SOLVER, ST and MULTICOMPONENT (after solvers_template.h), which
+   are defined as constants before the inclusion. Function names are suffixed with KERNEL().
+
+*/
+
+
+#if EQUATION_SYSTEM == 2
+static void KERNEL(compute_transport)(t_wall *wall){
+
+	if(wall->fR_star[0]<TOL14){ //negative transport -> information from right hand side
+		wall->fR_star[5]=wall->fR_star[0]*wall->UR[5]/wall->UR[0];
+		wall->fL_star[5]=wall->fR_star[5];
+	}else{ //positive transport -> information from right hand side
+		wall->fR_star[5]=wall->fL_star[0]*wall->UL[5]/wall->UL[0];
+		wall->fL_star[5]=wall->fR_star[5];
+	}
+
+
+}
+#endif
+
+
+#if ST!=0&&EQUATION_SYSTEM==2
+static void KERNEL(compute_source)(t_mesh *mesh, int i, double *S){
+	//Source term of the cell i, evaluated with the current state. It is not stored in the mesh
+
+	int k;
+	t_cell *cell;
+
+	for(k=0;k<MAX_NVAR;k++){
+		S[k]=0.0;
+	}
+	cell=&(mesh->cell[i]);
+	#if ST==1
+	if(cell->type!=0&&cell->st_sizeZ>1){     //This is the implementation of gravity force in -Z direction
+		S[3]= -_g_*mesh->U[0][i] + mesh->S_corr[3][i];
+		S[4]= -_g_*mesh->U[3][i];
+	}
+	#elif ST==2
+	if(cell->type!=0){     //This is the implementation of gravity force in -Z direction
+		S[3]= -_g_*(mesh->U[0][i]-mesh->Ue[0][i]);
+		S[4]= -_g_*mesh->U[3][i];
+	}
+	#else
+	if(cell->type!=0){     //This is the implementation of gravity force in -Z direction
+		S[3]= -_g_*(mesh->U[0][i]-mesh->Ue[0][i]);
+		S[4]= 0.0;
+	}
+	#endif
+}
+#endif
+
+
+static void KERNEL(update_pencil)(t_mesh *mesh, t_sim *sim, t_pencil *pc, int stage){
+	//Residual (flux divergence minus source term) of the cells of a pencil. In the first stage it
+	//is stored in mesh->divF, as dt is not known yet. Otherwise, the cells are updated in place
+	//with the Runge-Kutta stage
+
+	int p,k,id;
+	t_rkstage *rk;
+	double t0;
+#if ST!=0&&EQUATION_SYSTEM==2
+	double S[MAX_NVAR]; //source term of the cell
+#endif
+
+	PROF_START(t0);
+#if ST!=0&&EQUATION_SYSTEM==2
+	for(p=0;p<pc->ncells;p++){
+		id=pc->id[p];
+		KERNEL(compute_source)(mesh,id,S);
+		for(k=0;k<sim->nvar;k++){
+			mesh->divF[k][id]=mesh->divF[k][id] - S[k];
+		}
+	}
+	PROF_LAP(sim,PROF_SOURCE,t0);
+#endif
+
+	if(stage!=1){
+		rk=&(sim->rk[stage-1]);
+		for(p=0;p<pc->ncells;p++){
+			id=pc->id[p];
+			if(mesh->cell[id].type!=0&&mesh->cell[id].ghost!=1){
+				for(k=0;k<sim->nvar;k++){
+					rk_stage_update(rk,sim->dt,mesh->divF[k][id],&(mesh->U[k][id]),&(mesh->U_aux[k][id]));
+				}
+			}
+		}
+		PROF_LAP(sim,PROF_STAGE,t0);
+	}
+
+}
+
+
+#if EQUATION_SYSTEM==2&&ST==0
+static void KERNEL(primitive_pencil)(t_mesh *mesh, t_pencil *pc){
+	//Primitive variables (rho, u, v, w, p, phi) of the line buffer of a pencil, for their
+	//reconstruction (REC_VARIABLES 1). The cells of the pencil take them from the cache of the stage
+	//(update_primitives()), and the cells beyond its ends are converted here
+
+	int p,id,ncells;
+	double rho,u,v,w,phi;
+	double * restrict U0=pc->U[0];
+	double * restrict U1=pc->U[1];
+	double * restrict U2=pc->U[2];
+	double * restrict U3=pc->U[3];
+	double * restrict U4=pc->U[4];
+	double * restrict U5=pc->U[5];
+
+	ncells=pc->ncells;
+	for(p=0;p<ncells;p++){
+		id=pc->id[p];
+		U1[p]=mesh->W[PRIM_U][id];
+		U2[p]=mesh->W[PRIM_V][id];
+		U3[p]=mesh->W[PRIM_W][id];
+		U4[p]=mesh->W[PRIM_P][id];
+		U5[p]=(U0[p]>0.0 ? U5[p]/U0[p] : 1.0);
+	}
+	for(p=-PENCIL_HALO;p<ncells+PENCIL_HALO;p++){
+		if(p>=0&&p<ncells){
+			continue;
+		}
+		rho=(U0[p]>0.0 ? U0[p] : 1.0);
+		u=U1[p]/rho;
+		v=U2[p]/rho;
+		w=U3[p]/rho;
+		phi=(U0[p]>0.0 ? U5[p]/rho : 1.0);
+		U1[p]=u;
+		U2[p]=v;
+		U3[p]=w;
+		U4[p]=pressure_from_energy(ST,mixture_gamma(MULTICOMPONENT,phi),U4[p],u,v,w,U0[p],0.0);
+		U5[p]=phi;
+	}
+
+}
+
+
+static void KERNEL(conserved_faces)(t_pencil *pc){
+	//Conserved variables at the faces of the cells of a pencil, from the reconstructed primitive
+	//variables (REC_VARIABLES 1), so that the Riemann solvers are the same in both cases
+
+	int p,n,s;
+	double *ptr[2][MAX_NVAR];
+
+	n=pc->ncells+2;
+	for(p=0;p<MAX_NVAR;p++){
+		ptr[0][p]=pc->UL[p]-1;
+		ptr[1][p]=pc->UR[p]-1;
+	}
+	for(s=0;s<2;s++){
+		double * restrict U0=ptr[s][0];
+		double * restrict U1=ptr[s][1];
+		double * restrict U2=ptr[s][2];
+		double * restrict U3=ptr[s][3];
+		double * restrict U4=ptr[s][4];
+		double * restrict U5=ptr[s][5];
+#pragma omp simd
+		for(p=0;p<n;p++){
+			double rho,u,v,w,pres,phi;
+			rho=U0[p];
+			u=U1[p];
+			v=U2[p];
+			w=U3[p];
+			pres=U4[p];
+			phi=U5[p];
+			U1[p]=rho*u;
+			U2[p]=rho*v;
+			U3[p]=rho*w;
+			U4[p]=energy_from_pressure(ST,mixture_gamma(MULTICOMPONENT,phi),pres,u,v,w,rho,0.0);
+			U5[p]=rho*phi;
+		}
+	}
+
+}
+#endif
+
+
+static KERNEL_INLINE void KERNEL(sweep_fluxes)(t_mesh *mesh, t_sim *sim, t_pencil *pc, int d, int q, int stage, double *lambdaMax){
+	//Fluxes of the faces of the pencil q of direction d, and their divergence. It is instantiated for
+	//each direction (see sweep_fluxes_x/y/z() below), so d is a constant
+
+	int j,k,f,fbase,fstride,ncells,id,wt;
+	int perm[MAX_NVAR]; //component of the state for each component of the 1D problem
+	double h; //cell size in the sweep direction
+	double div,lambda;
+	double **FR; //right flux of the faces (the left one, except with HLLS)
+	t_faces faces; //faces of the pencil, for the batch Riemann solver
+	t_faces *fc;
+#if EQUATION_SYSTEM == 2
+	t_wall face; //face descriptor, for the boundary faces
+	t_wall *wall;
+#endif
+	double t0;
+
+	PROF_START(t0);
+	load_pencil(mesh,pc,mesh->U,sim->nvar,d,q,&fbase,&fstride);
+#if EQUATION_SYSTEM==2&&ST==0
+	if(sim->rec_vars==1){
+		KERNEL(primitive_pencil)(mesh,pc);
+	}
+#endif
+	sim->kernels.reconstruct_pencil(pc,sim->nvar,pc->order);
+#if EQUATION_SYSTEM==2&&ST==0
+	if(sim->rec_vars==1){
+		KERNEL(conserved_faces)(pc);
+	}
+#endif
+	PROF_LAP(sim,PROF_RECONST,t0);
+	ncells=pc->ncells;
+	h=(d==0 ? mesh->dx : (d==1 ? mesh->dy : mesh->dz));
+
+	//The faces at the ends of a periodic pencil take the cells of the other end (see load_pencil()),
+	//so that the left and right states of the face j are always UL[k][j-1] and UR[k][j]
+	if(!pc->lo){
+		for(k=0;k<sim->nvar;k++){
+			pc->UL[k][-1]=pc->UL[k][ncells-1];
+		}
+	}
+	if(!pc->hi){
+		for(k=0;k<sim->nvar;k++){
+			pc->UR[k][ncells]=pc->UR[k][0];
+		}
+	}
+#if ST==3
+	for(j=0;j<=ncells;j++){
+		pc->zf[j]=face_height(mesh,d,(d==2 ? j : pc->n));
+	}
+#endif
+
+	//Frame of the faces: the normal momentum is the component 1 of the 1D problem, and the
+	//tangential ones keep their order. No signs are needed, as the solvers are symmetric with
+	//respect to the tangential velocities
+	for(k=0;k<MAX_NVAR;k++){
+		perm[k]=k;
+	}
+#if EQUATION_SYSTEM == 2
+	perm[1]=1+d;
+	perm[1+d]=1;
+#endif
+
+	fc=&faces;
+	fc->n=ncells+1;
+	fc->wtype=mesh->wtype[d]+fbase;
+	fc->stride=fstride;
+	fc->z=pc->zf;
+	fc->vel=(d==0 ? mesh->u_x : (d==1 ? mesh->u_y : mesh->u_z));
+	fc->normal_z=(d==2);
+	for(k=0;k<sim->nvar;k++){
+		fc->UL[k]=pc->UL[perm[k]]-1;
+		fc->UR[k]=pc->UR[perm[k]];
+		fc->FL[k]=pc->FL[perm[k]];
+		fc->FR[k]=pc->FR[perm[k]];
+#if ST!=0&&EQUATION_SYSTEM==2
+		fc->ULe[k]=mesh->ULe[d][perm[k]]+fbase;
+		fc->URe[k]=mesh->URe[d][perm[k]]+fbase;
+#endif
+	}
+#if ST!=0&&EQUATION_SYSTEM==2
+	fc->pLe=mesh->pLe[d]+fbase;
+	fc->pRe=mesh->pRe[d]+fbase;
+#endif
+
+	//Fluxes of all the faces of the pencil at once. The wave speed only accounts for the inner faces
+	//(and for the boundary faces of the scalar equations, which use the same flux)
+#if EQUATION_SYSTEM == 2
+	#if SOLVER == 0
+	lambda=KERNEL(riemann_HLLE_batch)(fc);
+	#elif SOLVER == 1
+	lambda=KERNEL(riemann_HLLC_batch)(fc);
+	#else
+	lambda=KERNEL(riemann_HLLS_batch)(fc);
+	#endif
+#elif EQUATION_SYSTEM == 1
+	lambda=KERNEL(burgers_batch)(fc);
+#else
+	lambda=KERNEL(linear_batch)(fc);
+#endif
+	*lambdaMax=MAX(*lambdaMax,lambda);
+
+	//The boundary faces are computed again with their own solvers, in the same frame, and the faces
+	//without flux (e.g. between solid cells) are set to zero
+#if EQUATION_SYSTEM == 2
+	wall=&face;
+#endif
+	for(j=0;j<=ncells;j++){
+		f=fbase+j*fstride;
+		wt=mesh->wtype[d][f];
+		if(wt==1){
+			continue;
+		}
+		if(wt==3||wt==4){
+			if(mesh->boundId[d][f]==0){
+				printf("%s boundId has not been assigned, please check. The program will close when pressing a key. \n",ERR);
+				getchar();
+				exit(1);
+			}
+		}
+#if EQUATION_SYSTEM == 2
+		if(wt==3||wt==4){
+			wall->wtype=wt;
+			wall->boundId=mesh->boundId[d][f];
+			wall->z=face_height(mesh,d,(d==2 ? j : pc->n));
+			#if ST!=0
+			for(k=0;k<sim->nvar;k++){
+				wall->ULe[k]=fc->ULe[k][j*fstride];
+				wall->URe[k]=fc->URe[k][j*fstride];
+			}
+			wall->pLe=fc->pLe[j*fstride];
+			wall->pRe=fc->pRe[j*fstride];
+			#endif
+			for(k=0;k<sim->nvar;k++){
+				wall->UL[k]=fc->UL[k][j];
+				wall->UR[k]=fc->UR[k][j];
+			}
+			if(wt==3){
+				KERNEL(compute_transmissive_euler)(wall,wall->boundId);
+			}else{
+				KERNEL(compute_solid_euler_hlle)(wall,lambdaMax,wall->boundId);
+			}
+			KERNEL(compute_transport)(wall);
+			for(k=0;k<sim->nvar;k++){
+				fc->FL[k][j]=wall->fL_star[k];
+				fc->FR[k][j]=wall->fR_star[k];
+			}
+			continue;
+		}
+#else
+		if(wt==3){
+			continue;
+		}
+#endif
+		for(k=0;k<sim->nvar;k++){
+			pc->FL[k][j]=0.0;
+			pc->FR[k][j]=0.0;
+		}
+	}
+
+	//Flux divergence of the cells of the pencil, from the left flux of the upper face and the right
+	//flux of the lower one
+#if EQUATION_SYSTEM == 2 && SOLVER == 2
+	FR=pc->FR;
+#else
+	FR=pc->FL;
+#endif
+	for(k=0;k<sim->nvar;k++){
+		if(d==0){
+			for(j=0;j<ncells;j++){
+				id=pc->id[j];
+				div=(pc->FL[k][j+1]-FR[k][j])/h;
+				mesh->divF[k][id]=div;
+			}
+		}else{
+			for(j=0;j<ncells;j++){
+				id=pc->id[j];
+				div=(pc->FL[k][j+1]-FR[k][j])/h;
+				mesh->divF[k][id]+=div;
+			}
+		}
+	}
+	PROF_LAP(sim,PROF_RIEMANN,t0);
+
+	//Last sweep: the flux divergence of the cells of the pencil is complete and still in cache.
+	//The source term is added and the stage is applied (the z-pencil owns all its cells)
+	if(d==2&&stage!=0){
+		KERNEL(update_pencil)(mesh,sim,pc,stage);
+	}
+
+}
+
+
+//Sweeps of the x, y and z pencils
+static void KERNEL(sweep_fluxes_x)(t_mesh *mesh, t_sim *sim, t_pencil *pc, int q, int stage, double *lambdaMax){
+	KERNEL(sweep_fluxes)(mesh,sim,pc,0,q,stage,lambdaMax);
+}
+
+static void KERNEL(sweep_fluxes_y)(t_mesh *mesh, t_sim *sim, t_pencil *pc, int q, int stage, double *lambdaMax){
+	KERNEL(sweep_fluxes)(mesh,sim,pc,1,q,stage,lambdaMax);
+}
+
+static void KERNEL(sweep_fluxes_z)(t_mesh *mesh, t_sim *sim, t_pencil *pc, int q, int stage, double *lambdaMax){
+	KERNEL(sweep_fluxes)(mesh,sim,pc,2,q,stage,lambdaMax);
+}
+
+
+static int KERNEL(compute_fluxes)(t_mesh *mesh, t_sim *sim, int stage){
+	//See compute_fluxes() in numcore.c for the meaning of stage
+
+	double lambdaMax;
+	int d,q,i;
+	t_pencil *pc;
+
+	mesh->lambda_max=0.0;
+	lambdaMax=mesh->lambda_max;
+
+	//Dimension by dimension sweep: x, y and z pencils are processed in turns, so that the
+	//flux divergence is accumulated in each cell without race conditions. With MPI, each sweep
+	//waits for the halo of its direction, while the others are still in flight
+#pragma omp parallel default(none) private(pc,d,q,i) shared(sim,mesh,stage) reduction(max:lambdaMax)
+	{
+	pc=allocate_pencil(mesh,sim);
+	for(d=0;d<3;d++){
+#if USE_MPI
+#pragma omp master
+		halo_exchange_wait(mesh,d);
+#pragma omp barrier
+#endif
+		//Only the pencils with flux (see build_work_lists()). Without solids, they are all the pencils,
+		//with the same partition as first_touch() in preproc.c for the x pencils
+#pragma omp for schedule(static)
+		for(i=0;i<mesh->npencils[d];i++){
+			q=mesh->pencils[d][i];
+			if(d==0){
+				KERNEL(sweep_fluxes_x)(mesh,sim,pc,q,stage,&lambdaMax);
+			}else if(d==1){
+				KERNEL(sweep_fluxes_y)(mesh,sim,pc,q,stage,&lambdaMax);
+			}else{
+				KERNEL(sweep_fluxes_z)(mesh,sim,pc,q,stage,&lambdaMax);
+			}
+#if USE_MPI
+			halo_exchange_progress(mesh);
+#endif
+		}
+	}
+	free_pencil(pc,sim);
+	}
+
+	mesh->lambda_max=lambdaMax;
+
+
+	return 1;
+}
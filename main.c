@@ -35,41 +35,55 @@ Content:
 
 #include "lib/definitions.h"
 #include "lib/structures.h"
-#include "lib/closures.h"
 #include "lib/ibmutils.h"
+#include "lib/checkpoint.h"
+#include "lib/kernels.h"
 #include "lib/mathutils.h"
+#include "lib/mpicomm.h"
 #include "lib/numcore.h"
+#include "lib/output.h"
 #include "lib/postproc.h"
 #include "lib/preproc.h"
+#include "lib/profiler.h"
 #include "lib/reconst.h"
-#include "lib/solvers.h"
 
 int main(int argc, char * argv[]){
 	t_mesh *mesh;
 	t_sim *sim;
 	t_solid *solids;
+	t_comm *comm;
+	t_output *output;
+	t_checkpoint *ckpt;
 	char vtkfile[1024];
 	char listfile[1024];
-	double tf,timeac;
-	int nIt;
+	double tf,timeac,timeac2,t0;
+	int nIt,restarted,i;
 #if WRITE_TKE
-	double timeac2,tTke;
+	double tTke;
 	FILE *file_tke;
 #endif
 
-	if (argc < 2) {
-		printf("%s A folder path must be passed as follows: %s <folder_path>\n", ERR, argv[0]);
+	comm=parallel_init(&argc,&argv);	//MPI initialization (a single rank without USE_MPI)
+
+	//Arguments: the case folder and, optionally, the number of threads (-t N or --threads N)
+	const char *folder_path = NULL;
+	int nthreads = NTHREADS;
+	if (getenv("OMP_NUM_THREADS") != NULL && atoi(getenv("OMP_NUM_THREADS")) > 0) {
+		nthreads = atoi(getenv("OMP_NUM_THREADS"));
+	}
+	for (i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i+1 < argc) {
+			nthreads = atoi(argv[++i]);
+		} else if (folder_path == NULL) {
+			folder_path = argv[i];
+		}
+	}
+	if (folder_path == NULL) {
+		printf("%s A folder path must be passed as follows: %s <folder_path> [-t <threads>]\n", ERR, argv[0]);
 		return 1; // Exit 
 	}
-	const char *folder_path = argv[1];
-
-#ifdef _OPENMP
-	omp_set_num_threads(NTHREADS);
-	printf("The number of threads is set to %d.\n",NTHREADS);
-#pragma omp parallel
-	printf("Thread %d of %d is checked.\n", omp_get_thread_num(), omp_get_num_threads());
 
-#endif
+	threads_init(comm,nthreads);	//number of OpenMP threads and pinning
 
 	////////////////////////////////////////////////////
 	///////////// M E M O R Y  A L L O C. //////////////
@@ -81,6 +95,7 @@ int main(int argc, char * argv[]){
 	sim=(t_sim*)malloc(sizeof(t_sim));
 	//Solids allocation
 	solids=(t_solid*)malloc(sizeof(t_solid));
+	mesh->comm=comm;
 
 
 	////////////////////////////////////////////////////
@@ -90,25 +105,30 @@ int main(int argc, char * argv[]){
 	read_config(mesh,sim,folder_path);
 	print_info(mesh,sim,folder_path);
 
-#if EQUATION_SYSTEM == 2	//Definition of the number of conserved variables
-	sim->nvar=6;
-#else
-	sim->nvar=1;
-#endif
-
-	if(sim->order==1){	//Definition of the Runge-Kutta steps depending on the spatial order of accuracy
-		sim->rk_steps=1;
+	if(sim->eq_system==2){	//Definition of the number of conserved variables
+		sim->nvar=6;
 	}else{
-		sim->rk_steps=3;
+		sim->nvar=1;
 	}
 
+	select_kernels(sim);	//Selection of the flux and reconstruction kernels for the chosen equations, solver and reconstruction
+#if PROFILE
+	profiler_init(sim);	//Timers of the phases of the computation
+#endif
+
+	set_rk_scheme(sim);	//Definition of the Runge-Kutta stages (by default, depending on the spatial order of accuracy)
+
 	mesh->dx= mesh->Lx/mesh->xcells;
 	mesh->dy= mesh->Ly/mesh->ycells;
 	mesh->dz= mesh->Lz/mesh->zcells;
 
+	decompose_domain(mesh,sim);	//The grid is split among the MPI ranks. From here on, the mesh is the subdomain of this rank
+
 	timeac=0.0;
-#if WRITE_TKE
 	timeac2=0.0;
+	nIt=0;
+	sim->t=0.0;
+#if WRITE_TKE
 	tTke=0.05;
 #endif    
 
@@ -133,47 +153,65 @@ int main(int argc, char * argv[]){
 	update_wall_type(mesh,solids);
 	printf("%s Image points have been defined and ghost cell values have been computed \n",OK);
 #endif
+	build_work_lists(mesh);			//Lists of the fluid cells, ghost cells and pencils with flux
+
+	ckpt=checkpoint_init(mesh,sim,folder_path);	//Checkpoints of the run
+	restarted=read_checkpoint(ckpt,mesh,sim,&timeac,&timeac2,&nIt);	//With Restart 1, the state, time and counters are read from the last checkpoint
 
-#if EQUATION_SYSTEM == 0
-	set_velocity(mesh,sim);
-#endif
-	
 	snprintf(vtkfile, sizeof(vtkfile),"%s/out/inital_geo_mesh.vtk", folder_path);
 	write_geo_vtk(mesh,vtkfile);
-	snprintf(vtkfile, sizeof(vtkfile),"%s/out/state000.vtk", folder_path);
-	write_vtk(mesh,vtkfile);
-	snprintf(listfile, sizeof(listfile),"%s/out/state000.out", folder_path);
-	write_list(mesh,listfile);
+	output=output_init(mesh,sim);			//Output stage (background writer with ASYNC_OUTPUT)
+#if PROFILE
+	profiler_start(sim);				//The initial output files are also timed
+#endif
+	if(!restarted){
+		snprintf(vtkfile, sizeof(vtkfile),"%s/out/state000.vtk", folder_path);
+		snprintf(listfile, sizeof(listfile),"%s/out/state000.out", folder_path);
+		output_submit(output,mesh,vtkfile,listfile);
+	}
 	snprintf(listfile, sizeof(listfile),"%s/out/list_eq.out", folder_path);
+	PROF_START(t0);
 	write_list_eq(mesh,listfile);
+	PROF_LAP(sim,PROF_WRITE_LIST,t0);
 	printf("\n");
-	printf(" T= 0.0e+0. Initial data printed. Starting time loop.\n");
+	if(restarted){
+		printf(" T= %14.14e. Checkpoint read. Resuming time loop.\n",sim->t);
+	}else{
+		printf(" T= 0.0e+0. Initial data printed. Starting time loop.\n");
+	}
 
 #if WRITE_TKE == 1
 	snprintf(listfile, sizeof(listfile),"%s/out/tke.out", folder_path);
-	file_tke=fopen(listfile,"w");
+	rank_filename(comm,listfile,vtkfile,sizeof(vtkfile));
+	if(restarted){
+		truncate_time_series(vtkfile,sim->t);	//The lines after the checkpoint are written again
+	}
+	file_tke=fopen(vtkfile,(restarted ? "a" : "w"));
 #endif
 
 	mass_calculation(mesh,sim);			//Computing the total mass
 	energy_calculation(mesh,sim);			//Computing the total energy
-	mesh->mass0=mesh->mass;
-	mesh->energy0=mesh->energy;
+	if(!restarted){
+		mesh->mass0=mesh->mass;
+		mesh->energy0=mesh->energy;
+	}
 
 	////////////////////////////////////////////////////
 	////////////// C A L C U L A T I O N ///////////////
 	////////////////////////////////////////////////////
 
 	tf=sim->tf;
-	sim->t=0.0;
-	nIt=0;
 
-	#if ST!=0&&EQUATION_SYSTEM==2
-	equilibrium_reconstruction(mesh,sim);	//High order reconstruction for the equilibrium variables (atmospheric cases)
-	#endif
+	if(sim->st!=0&&sim->eq_system==2){
+		equilibrium_reconstruction(mesh,sim);	//High order reconstruction for the equilibrium variables (atmospheric cases)
+	}
 
 	while(sim->t<tf){
 		
 		update_solution(mesh,sim,solids,sim->rk_steps); //This updates all variables one time step
+#if PROFILE
+		sim->prof.steps++;
+#endif
 
 		if(mesh->cell_bc_flag!=1){
 			update_cell_boundaries(mesh);
@@ -184,14 +222,15 @@ int main(int argc, char * argv[]){
 
 		if(timeac>sim->tVolc){
 			screen_info(mesh,sim);
+			vtkfile[0]='\0';
+			listfile[0]='\0';
 			#if WRITE_VTK
 			snprintf(vtkfile, sizeof(vtkfile), "%s/out/state%03d.vtk", folder_path, nIt + 1);
-			write_vtk(mesh,vtkfile);
 			#endif
 			#if WRITE_LIST
 			snprintf(listfile, sizeof(listfile), "%s/out/state%03d.out", folder_path, nIt + 1);
-			write_list(mesh,listfile);
 			#endif
+			output_submit(output,mesh,vtkfile,listfile);
 			nIt++;	
 			timeac=0.0;
 		}
@@ -199,29 +238,50 @@ int main(int argc, char * argv[]){
 		#if WRITE_TKE
 		timeac2=timeac2+sim->dt;
 		if(timeac2>tTke){
+		PROF_START(t0);
 		tke_calculation(mesh,sim);
 		fprintf(file_tke,"%14.14e %14.14e\n",sim->t,mesh->tke);
+		PROF_LAP(sim,PROF_WRITE_TKE,t0);
 			timeac2=0.0;
 		}
 		#endif
+
+		if(checkpoint_due(ckpt,mesh,sim)){
+			#if WRITE_TKE
+			fflush(file_tke);	//The lines up to the checkpoint are kept by a restart
+			#endif
+			write_checkpoint(ckpt,mesh,sim,timeac,timeac2,nIt);
+			if(ckpt->stop){
+				printf("%s The run is stopped after a SIGTERM or SIGUSR1. Restart it with Restart 1\n",WAR);
+				break;
+			}
+		}
 	}
 
 	printf(" \n");
 	printf(" Final time is T= %14.14e \n \n",sim->t);
 
-	if(timeac>TOL14){
+	if(timeac>TOL14&&!ckpt->stop){
 		snprintf(vtkfile, sizeof(vtkfile), "%s/out/state%03d.vtk", folder_path, nIt + 1);
-		write_vtk(mesh,vtkfile);
 		snprintf(listfile, sizeof(listfile), "%s/out/state%03d.out", folder_path, nIt + 1);
-		write_list(mesh,listfile);
+		output_submit(output,mesh,vtkfile,listfile);
 	}
+	output_finalize(output,sim);			//Waits for the files still being written
+	free(ckpt);
 
 	#if WRITE_TKE
 	fclose(file_tke);
 	#endif
 
+#if PROFILE
+	snprintf(listfile, sizeof(listfile),"%s/out/profile.json", folder_path);
+	profiler_summary(mesh,sim,listfile);	//Time of each phase per thread, MCUPS and load imbalance
+#endif
+
 	printf("\n%s Simulation completed!\n",END);
 
+	parallel_finalize(comm);
+
 	return 1;
 
 }
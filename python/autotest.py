@@ -3,7 +3,7 @@ import math
 import argparse                   
 import numpy as np             
 import matplotlib.pyplot as plt 
-from utils import modify_header_file, write_config, write_initial, write_equilibrium, backup_file, restore_file, backup_fileL2, restore_fileL2, compile_program, run_program, initialize_variables, read_data_euler, singleRP, caseBubble, caseLinear, ordersLinear
+from utils import write_config, write_initial, write_equilibrium, compile_program, run_program, initialize_variables, read_data_euler, singleRP, caseBubble, caseLinear, ordersLinear
 
 # Set up argument parsing
 parser = argparse.ArgumentParser(description="Run test cases and print results.")
@@ -12,12 +12,12 @@ parser.add_argument('arg2', type=int, nargs='?', default=0, help="Reconstruction
 parser.add_argument('arg3', type=int, nargs='?', default=5, help="Order")
 args = parser.parse_args()
 
-script_dir = os.path.dirname(os.path.abspath(__file__))
-folder_lib = os.path.join(script_dir, "../lib")
-backup_fileL2(folder_lib+'/definitions.h')
-modify_header_file(folder_lib+'/definitions.h', 'NTHREADS', args.arg1)
-modify_header_file(folder_lib+'/definitions.h', 'TYPE_REC', args.arg2)
+# The program is compiled once. The number of threads is passed with -t and the equations, solver and
+# reconstruction of each test are written in its configure.input
+nthreads=args.arg1
+rec=args.arg2
 ord=args.arg3
+compile_program()
 
 # Define colors for the output
 bold_green = "\033[1;32m"
@@ -29,18 +29,16 @@ reset = "\033[0m"
 test_names = ["Convergence test (linear)","RP1 (equilibrium)", "RP2 (sod-shock)", "RP3", "RP4 (2-component)", "Bubble collision"]
 
 # Run the Linear transport test
-l = ordersLinear()
+l = ordersLinear(nthreads, rec, build=False)
 
 # Run RP tests
 rp = np.zeros(4)
 for i in range(1, 5):
-    a = singleRP(i,ord)
+    a = singleRP(i, ord, nthreads, rec, build=False)
     rp[i-1] = a
 
 # Run the Bubble collision case test
-b = caseBubble(ord)
-
-restore_fileL2(folder_lib+'/definitions.h')
+b = caseBubble(ord, nthreads, rec, build=False)
 
 # Store test results
 results = []
@@ -0,0 +1,274 @@
+#!/usr/bin/env python
+# coding: utf-8
+
+# # Performance benchmark (*bench*)
+#
+# This script runs a fixed matrix of reference cases and stores the performance of each run in a JSON file:
+#
+# - Cases: 1D Riemann problem (Sod), 2D Kelvin-Helmholtz instability and 3D Taylor-Green vortex, each with a small and a large mesh.
+# - Orders 1, 3, 5 and 7, solvers HLL, HLLC and HLLS (with gravity source term) and several numbers of threads.
+#
+# For each run (the fastest of several repetitions), the time per step, the million cell updates per second (MCUPS), the time of the solver spent in the output files (from `out/profile.json`, which is subtracted from the wall-clock time; with `ASYNC_OUTPUT`, only the copies of the state and the waits for the writer thread) and the peak resident memory are recorded. The program is compiled once in a copy of the code (the file `lib/definitions.h` of the repository is not modified), with `PROFILE 1`, and the number of threads of each run is passed with `-t`. The equations, solver and order are selected in `configure.input`.
+#
+# Usage (from the main directory, or with `make bench`):
+#
+# `python3 python/bench.py [--quick] [--threads 1,8] [--output bench.json] [--compare reference.json]`
+#
+# With `--compare`, the time per step of each run is compared with the one in a previous JSON file, and the script returns a non-zero exit code if any run is slower than the given tolerance. Only the standard library is used, so that it can be run in the compute nodes.
+
+import os
+import re
+import sys
+import json
+import math
+import time
+import shutil
+import argparse
+import platform
+import subprocess
+
+
+script_dir = os.path.dirname(os.path.abspath(__file__))
+folder_root = os.path.join(script_dir, "../")
+
+gamma = 1.4
+
+# Reference cases: mesh sizes (small, large), domain and boundary conditions (Face_1 ... Face_6)
+cases = {
+    "rp1d":  {"sizes": {"small": (800, 1, 1), "large": (3200, 1, 1)}, "length": (1.0, None, None), "bc": (1, 3, 1, 3, 1, 1)},
+    "kh2d":  {"sizes": {"small": (96, 96, 1), "large": (192, 192, 1)}, "length": (1.0, 1.0, None), "bc": (1, 1, 1, 1, 1, 1)},
+    "tgv3d": {"sizes": {"small": (32, 32, 32), "large": (64, 64, 64)}, "length": (2*math.pi, 2*math.pi, 2*math.pi), "bc": (1, 1, 1, 1, 1, 1)},
+}
+
+solver_names = {0: "HLL", 1: "HLLC", 2: "HLLS"}
+
+
+def initial_state(case, x, y, z):
+    # Primitive variables (u, v, w, rho, p) at the point (x, y, z)
+    if case == "rp1d":
+        if x < 0.5:
+            return 0.0, 0.0, 0.0, 1.0, 1.0
+        return 0.0, 0.0, 0.0, 0.125, 0.1
+    if case == "kh2d":
+        inner = abs(y - 0.5) < 0.25
+        return (0.5 if inner else -0.5), 0.01*math.sin(4.0*math.pi*x), 0.0, (2.0 if inner else 1.0), 2.5
+    # Taylor-Green vortex with Mach number 0.1
+    p0 = 1.0/(gamma*0.1**2)
+    u = math.sin(x)*math.cos(y)*math.cos(z)
+    v = -math.cos(x)*math.sin(y)*math.cos(z)
+    p = p0 + (math.cos(2*x) + math.cos(2*y))*(math.cos(2*z) + 2.0)/16.0
+    return u, v, 0.0, 1.0, p
+
+
+def case_geometry(case, size):
+    cells = cases[case]["sizes"][size]
+    dx = cases[case]["length"][0]/cells[0]
+    # Degenerate directions have one cell of the same size as in x, so that they do not limit dt
+    lengths = tuple(L if L is not None else dx*n for L, n in zip(cases[case]["length"], cells))
+    return cells, lengths
+
+
+def write_case(folder_case, case, size):
+    # Initial data, equilibrium data (rest state, only used with source terms) and maximum wave speed
+    (xcells, ycells, zcells), (SizeX, SizeY, SizeZ) = case_geometry(case, size)
+    dx, dy, dz = SizeX/xcells, SizeY/ycells, SizeZ/zcells
+    os.makedirs(folder_case+"/out", exist_ok=True)
+    smax = 0.0
+    with open(folder_case+"/initial.out", "w") as f, open(folder_case+"/equilibrium.out", "w") as fe:
+        f.write("VARIABLES = X, Y, Z, u, v, w, rho, p, phi \n")
+        f.write(f"CELLS = {xcells}, {ycells}, {zcells},\n")
+        fe.write("VARIABLES = X, Y, Z, ue, ve, we, rhoe, pe, phi(n/u) \n")
+        fe.write(f"CELLS = {xcells}, {ycells}, {zcells},\n")
+        for l in range(xcells):
+            for m in range(ycells):
+                for n in range(zcells):
+                    x, y, z = (l+0.5)*dx, (m+0.5)*dy, (n+0.5)*dz
+                    u, v, w, rho, p = initial_state(case, x, y, z)
+                    f.write(f"{x} {y} {z} {u} {v} {w} {rho} {p} 0.0\n")
+                    fe.write(f"{x} {y} {z} 0.0 0.0 0.0 {rho} {p} 0.0\n")
+                    smax = max(smax, math.sqrt(u*u + v*v + w*w) + math.sqrt(gamma*p/rho))
+    return smax
+
+
+def write_configure(folder_case, case, size, order, solver, steps, smax, cfl):
+    # The final time is set so that the run takes approximately the given number of steps
+    (xcells, ycells, zcells), (SizeX, SizeY, SizeZ) = case_geometry(case, size)
+    dl = min(SizeX/xcells, SizeY/ycells, SizeZ/zcells)
+    FinalTime = steps*cfl*dl/smax
+    bc = cases[case]["bc"]
+    with open(folder_case+"/configure.input", "w") as f:
+        f.write("/////SIMULATION_SETUP////// \n")
+        f.write(f"FinalTime    {FinalTime}\nDumpTime    {FinalTime/2.0}\nCFL    {cfl}\nOrder    {order}\n \n")
+        f.write("////////MESH_SETUP/////////\n")
+        f.write(f"xcells    {xcells}\nycells    {ycells}\nzcells    {zcells}\n")
+        f.write(f"SizeX    {SizeX}\nSizeY    {SizeY}\nSizeZ    {SizeZ}\n \n")
+        f.write("///////BOUNDARY_COND///////\n")
+        for i in range(6):
+            f.write(f"Face_{i+1}    {bc[i]}\n")
+        f.write(" \n///////LINEAR_TRANSPORT///////(if_applicable)\nu_x    0.0\nu_y    0.0\nu_z    0.0\n")
+        f.write(" \n///////OPTIONAL///////\n")
+        f.write(f"EquationSystem    2\nSolver    {solver}\nSourceTerm    {1 if solver == 2 else 0}\n")
+
+
+def build(folder_build):
+    # Copy of the code compiled with the profiler active
+    shutil.rmtree(folder_build, ignore_errors=True)
+    os.makedirs(folder_build)
+    shutil.copytree(folder_root+"lib", folder_build+"/lib", ignore=shutil.ignore_patterns("*.o"))
+    shutil.copy(folder_root+"main.c", folder_build)
+    shutil.copy(folder_root+"Makefile", folder_build)
+    fname = folder_build+"/lib/definitions.h"
+    with open(fname) as f:
+        text = f.read()
+    text = re.sub(r"#define\s+PROFILE\s+\d+", "#define PROFILE 1", text)
+    with open(fname, "w") as f:
+        f.write(text)
+    result = subprocess.run("make -j", shell=True, cwd=folder_build, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        print(result.stdout)
+        sys.exit(f"Compilation failed in {folder_build}")
+    return folder_build+"/caelum"
+
+
+def macro_value(macro):
+    # Value of a macro of lib/definitions.h
+    with open(folder_root+"lib/definitions.h") as f:
+        match = re.search(rf"#define\s+{macro}\s+(\d+)", f.read())
+    return int(match.group(1)) if match else 0
+
+
+def output_time(phases):
+    # Time of the solver spent in the output files. With ASYNC_OUTPUT, the files are written by a
+    # background thread while the solver computes, and only the copies of the state and the waits
+    # for the writer (output_stage) are on the path of the solver
+    time = phases["output_stage"]["total"]
+    if not async_output:
+        time += phases["write_vtk"]["total"] + phases["write_list"]["total"]
+    return time
+
+
+def run(executable, folder_case, nthreads):
+    # Runs a case with a number of threads and returns the profile summary and the peak resident memory
+    # (MB). The number of threads is given with -t, and also in OMP_NUM_THREADS, so that the value of
+    # the environment of the shell is not used
+    env = dict(os.environ, OMP_NUM_THREADS=str(nthreads))
+    for fname in os.listdir(folder_case+"/out"):
+        os.remove(os.path.join(folder_case+"/out", fname))
+    with open(folder_case+"/log.txt", "w") as log:
+        process = subprocess.Popen([executable, folder_case, "-t", str(nthreads)], env=env, stdin=subprocess.DEVNULL, stdout=log, stderr=subprocess.STDOUT)
+        _, status, usage = os.wait4(process.pid, 0)
+    fname = folder_case+"/out/profile.json"
+    if not os.path.exists(fname):
+        return None, 0.0
+    with open(fname) as f:
+        profile = json.load(f)
+    return profile, usage.ru_maxrss/1024.0
+
+
+def key(r):
+    return (r["case"], r["size"], r["order"], r["solver"], r["threads"])
+
+
+def compare(results, fname_ref, tolerance):
+    # Compares the time per step with a previous benchmark. Returns the number of regressions
+    with open(fname_ref) as f:
+        reference = {key(r): r for r in json.load(f)["results"]}
+    regressions = 0
+    print(f"\n{'Run':<40}{'Reference':>12}{'Current':>12}{'Ratio':>8}")
+    for r in results:
+        ref = reference.get(key(r))
+        if ref is None or ref["time_per_step"] <= 0.0:
+            continue
+        ratio = r["time_per_step"]/ref["time_per_step"]
+        flag = ""
+        if ratio > 1.0 + tolerance:
+            flag = "  SLOWER"
+            regressions += 1
+        name = f"{r['case']}/{r['size']} o{r['order']} {solver_names[r['solver']]} {r['threads']}t"
+        print(f"{name:<40}{ref['time_per_step']:>12.4e}{r['time_per_step']:>12.4e}{ratio:>8.3f}{flag}")
+    return regressions
+
+
+def git_commit():
+    result = subprocess.run("git rev-parse --short HEAD", shell=True, cwd=folder_root, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    return result.stdout.strip()
+
+
+def int_list(text):
+    return [int(a) for a in text.split(",")]
+
+
+parser = argparse.ArgumentParser(description="Run the performance benchmark and store the results in a JSON file.")
+parser.add_argument("--cases", type=lambda t: t.split(","), default=list(cases), help="Cases (rp1d,kh2d,tgv3d)")
+parser.add_argument("--sizes", type=lambda t: t.split(","), default=["small", "large"], help="Mesh sizes (small,large)")
+parser.add_argument("--orders", type=int_list, default=[1, 3, 5, 7], help="Orders of accuracy")
+parser.add_argument("--solvers", type=int_list, default=[0, 1, 2], help="Solvers (0: HLL, 1: HLLC, 2: HLLS)")
+parser.add_argument("--threads", type=int_list, default=sorted({1, os.cpu_count() or 1}), help="Numbers of threads")
+parser.add_argument("--steps", type=int, default=20, help="Approximate number of time steps of each run")
+parser.add_argument("--repeat", type=int, default=3, help="Repetitions of each run (the fastest one is kept)")
+parser.add_argument("--cfl", type=float, default=0.4, help="CFL number")
+parser.add_argument("--quick", action="store_true", help="Small meshes, orders 3 and 5 and HLLC only")
+parser.add_argument("--workdir", default=os.path.join(folder_root, "bench"), help="Folder for the builds and the cases")
+parser.add_argument("--output", default="bench.json", help="JSON file with the results")
+parser.add_argument("--compare", default=None, help="JSON file of a previous benchmark")
+parser.add_argument("--tolerance", type=float, default=0.15, help="Allowed slow-down in the comparison (0.15 is 15%%)")
+args = parser.parse_args()
+
+if args.quick:
+    args.sizes = ["small"]
+    args.orders = [3, 5]
+    args.solvers = [1]
+
+async_output = macro_value("ASYNC_OUTPUT") != 0
+results = []
+executable = build(os.path.join(args.workdir, "build"))
+for nthreads in args.threads:
+    for case in args.cases:
+        for size in args.sizes:
+            folder_case = os.path.join(args.workdir, f"{case}_{size}")
+            smax = write_case(folder_case, case, size)
+            for order in args.orders:
+                for solver in args.solvers:
+                    write_configure(folder_case, case, size, order, solver, args.steps, smax, args.cfl)
+                    profile, rss = None, 0.0
+                    for i in range(args.repeat):
+                        p, m = run(executable, folder_case, nthreads)
+                        if p is not None and (profile is None or p["wall_time"] < profile["wall_time"]):
+                            profile, rss = p, m
+                    name = f"{case}/{size} order {order} {solver_names[solver]} {nthreads} threads"
+                    if profile is None or profile["steps"] == 0:
+                        print(f"{name:<45} FAILED (see {folder_case}/log.txt)")
+                        continue
+                    solver_output = output_time(profile["phases"])
+                    r = {
+                        "case": case, "size": size, "cells": profile["cells"], "order": order, "solver": solver, "threads": nthreads,
+                        "steps": profile["steps"],
+                        "time_per_step": (profile["wall_time"] - solver_output)/profile["steps"],
+                        "mcups": profile["cells"]*profile["steps"]/(profile["wall_time"] - solver_output)*1.0e-6,
+                        "output_time": solver_output,
+                        "wall_time": profile["wall_time"],
+                        "load_imbalance": profile["load_imbalance"],
+                        "peak_rss_mb": rss,
+                    }
+                    results.append(r)
+                    print(f"{name:<45} {r['time_per_step']:.4e} s/step  {r['mcups']:8.3f} MCUPS  {rss:8.1f} MB")
+
+summary = {
+    "commit": git_commit(),
+    "date": time.strftime("%Y-%m-%d %H:%M:%S"),
+    "host": platform.node(),
+    "cpus": os.cpu_count(),
+    "steps": args.steps,
+    "repeat": args.repeat,
+    "cfl": args.cfl,
+    "results": results,
+}
+with open(args.output, "w") as f:
+    json.dump(summary, f, indent=2)
+print(f"\nResults written in {args.output}")
+
+if args.compare is not None:
+    regressions = compare(results, args.compare, args.tolerance)
+    if regressions > 0:
+        sys.exit(f"{regressions} runs are slower than the reference")
+    print("No performance regressions")
@@ -14,7 +14,7 @@ folder_out = os.path.join(script_dir, "../"+folder_case+"/"+folder_out)
 pv.start_xvfb()
 
 # Find output files
-vtk_files = glob(folder_out + "/*.vtk")
+vtk_files = glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti")
 
 # Filter files that contain digits in their filenames
 vtk_files_with_digits = [f for f in vtk_files if re.search(r'\d+', os.path.basename(f))]
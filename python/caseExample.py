@@ -52,7 +52,7 @@ folder_exe = os.path.join(script_dir, "../")
 os.makedirs(folder_case, exist_ok=True)
 os.makedirs(folder_out, exist_ok=True)
 
-for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.png"):
+for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti") + glob(folder_out + "/*.png"):
     os.remove(f) 
 # ### Setting up the compilation variables (*definitions.h*)
 # 
@@ -64,13 +64,19 @@ for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder
 #Do not change the line below, it creates a backup of the definitions.h file
 backup_file(folder_lib+'/definitions.h')
 #Configure the header file for compilation. Add as many lines as desired for the macros you want to modify.
-modify_header_file(folder_lib+'/definitions.h', 'NTHREADS', 32)         #number of threads
-modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 2)  #System of equations solved
-modify_header_file(folder_lib+'/definitions.h', 'ST', 3)               #Source term type
-modify_header_file(folder_lib+'/definitions.h', 'SOLVER', 0)           #Riemann solver used
 modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)     #Read or not initial data, this should ALWAYS be 1
 
 
+# ### Setting up the runtime options (*configure.input*)
+# 
+# The number of threads, the equations, the solver, the reconstruction, the source term and the printed variables are read by the program when it starts (the threads are passed with `-t`), so they can be changed without compiling again. They are written in *configure.input* below.
+
+nthreads = 32           #number of threads
+EquationSystem = 2      #System of equations solved
+SourceTerm = 3          #Source term type
+Solver = 0              #Riemann solver used
+
+
 # ### Configure the global simulation parameters
 # 
 # We can set the global simulation parameters as desired:
@@ -174,7 +180,7 @@ for l in range(0,xcells):
 # In[21]:
 
 
-write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)
+write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z, EquationSystem=EquationSystem, SourceTerm=SourceTerm, Solver=Solver)
 write_equilibrium(folder_case, fname_eq, xcells, ycells, zcells, xc, yc, zc, ue, ve, we, rhoe, pe)       
 write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v, w, rho, p, phi)
 
@@ -188,7 +194,7 @@ write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v,
 
 compile_program()
 print("Program is running...")
-run_program(folder_exe+"./exehow3d "+folder_case)
+run_program(folder_exe+"./exehow3d "+folder_case, nthreads)
 restore_file(folder_lib+'/definitions.h')
 
 
@@ -49,17 +49,23 @@ os.makedirs(folder_out, exist_ok=True)
 #Do not change the line below, it creates a backup of the definitions.h file
 backup_file(folder_lib+'/definitions.h')
 #Configure the header file for compilation. Add as many lines as desired for the macros you want to modify.
-modify_header_file(folder_lib+'/definitions.h', 'NTHREADS', 60)         #number of threads
-modify_header_file(folder_lib+'/definitions.h', 'TYPE_REC', 0)
-modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 2)  #System of equations solved
-modify_header_file(folder_lib+'/definitions.h', 'ST', 0)               #Source term type
-modify_header_file(folder_lib+'/definitions.h', 'SOLVER', 1)           #Riemann solver used
 modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)     #Read or not initial data, this should ALWAYS be 1   
 modify_header_file(folder_lib+'/definitions.h', 'WRITE_LIST', 0)       
-modify_header_file(folder_lib+'/definitions.h', 'print_VELOCITY', 0)     
-modify_header_file(folder_lib+'/definitions.h', 'print_POTENTIALTEM', 0)     
-modify_header_file(folder_lib+'/definitions.h', 'print_PRESSURE', 1)   
-modify_header_file(folder_lib+'/definitions.h', 'print_RHO', 1)    
+
+
+# ### Setting up the runtime options (*configure.input*)
+# 
+# The number of threads, the equations, the solver, the reconstruction, the source term and the printed variables are read by the program when it starts (the threads are passed with `-t`), so they can be changed without compiling again. They are written in *configure.input* below.
+
+nthreads = 60           #number of threads
+Reconstruction = 0      #0: WENO, 1: TENO, 2: optimal weights
+EquationSystem = 2      #System of equations solved
+SourceTerm = 0          #Source term type
+Solver = 1              #Riemann solver used
+PrintVelocity = 0
+PrintPotentialTemperature = 0
+PrintPressure = 1
+PrintRho = 1
 
 # ### Configure the global simulation parameters
 # 
@@ -135,7 +141,7 @@ for l in range(0,xcells):
 
 # Now, the configuration and initial condition (and equilibrium) files are written: 
 
-write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)      
+write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z, Reconstruction=Reconstruction, EquationSystem=EquationSystem, SourceTerm=SourceTerm, Solver=Solver, PrintVelocity=PrintVelocity, PrintPotentialTemperature=PrintPotentialTemperature, PrintPressure=PrintPressure, PrintRho=PrintRho)
 write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v, w, rho, p, phi)
 
 
@@ -146,7 +152,7 @@ write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v,
 compile_program()
 restore_file(folder_lib+'/definitions.h')
 print("Program is running...")
-run_program(folder_exe+"./caelum "+folder_case)
+run_program(folder_exe+"./caelum "+folder_case, nthreads)
 
 
 
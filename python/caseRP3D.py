@@ -47,7 +47,7 @@ folder_exe = os.path.join(script_dir, "../")
 os.makedirs(folder_case, exist_ok=True)
 os.makedirs(folder_out, exist_ok=True)
 
-for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.png"):
+for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti") + glob(folder_out + "/*.png"):
     os.remove(f) 
 # ### Setting up the compilation variables (*definitions.h*)
 # 
@@ -56,13 +56,19 @@ for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder
 #Do not change the line below, it creates a backup of the definitions.h file
 backup_file(folder_lib+'/definitions.h')
 #Configure the header file for compilation. Add as many lines as desired for the macros you want to modify.
-modify_header_file(folder_lib+'/definitions.h', 'NTHREADS', 48)         #number of threads
-modify_header_file(folder_lib+'/definitions.h', 'TYPE_REC', 0)
-modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 2)  #System of equations solved
-modify_header_file(folder_lib+'/definitions.h', 'ST', 0)               #Source term type
-modify_header_file(folder_lib+'/definitions.h', 'SOLVER', 1)           #Riemann solver used
 modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)     #Read or not initial data, this should ALWAYS be 1
 modify_header_file(folder_lib+'/definitions.h', 'WRITE_LIST', 0)  
+
+
+# ### Setting up the runtime options (*configure.input*)
+# 
+# The number of threads, the equations, the solver, the reconstruction, the source term and the printed variables are read by the program when it starts (the threads are passed with `-t`), so they can be changed without compiling again. They are written in *configure.input* below.
+
+nthreads = 48           #number of threads
+Reconstruction = 0      #0: WENO, 1: TENO, 2: optimal weights
+EquationSystem = 2      #System of equations solved
+SourceTerm = 0          #Source term type
+Solver = 1              #Riemann solver used
      
 
 # ### Configure the global simulation parameters
@@ -176,7 +182,7 @@ for l in range(0,xcells):
 
 # Now, the configuration and initial condition (and equilibrium) files are written: 
 
-write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)      
+write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z, Reconstruction=Reconstruction, EquationSystem=EquationSystem, SourceTerm=SourceTerm, Solver=Solver)
 write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v, w, rho, p, phi)
 
 
@@ -187,7 +193,7 @@ write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v,
 compile_program()
 restore_file(folder_lib+'/definitions.h')
 print("Program is running...")
-run_program(folder_exe+"./caelum "+folder_case)
+run_program(folder_exe+"./caelum "+folder_case, nthreads)
 
 
 
@@ -197,7 +203,7 @@ run_program(folder_exe+"./caelum "+folder_case)
 pv.start_xvfb()
 
 # Find output files
-vtk_files = glob(folder_out + "/*.vtk")
+vtk_files = glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti")
 
 # Filter files that contain digits in their filenames
 vtk_files_with_digits = [f for f in vtk_files if re.search(r'\d+', os.path.basename(f))]
@@ -0,0 +1,83 @@
+#!/usr/bin/env python
+# coding: utf-8
+
+# # Binary initial conditions (*initial2bin*)
+#
+# This script converts the ASCII input files of a case (`initial.out` and `equilibrium.out`) to the binary format read by the solver (`initial.bin` and `equilibrium.bin`). When a binary file exists in the case folder, it is used instead of the ASCII one. The binary files are read much faster, and in parallel, which matters for large meshes.
+#
+# Usage:
+#
+# `python3 python/initial2bin.py <case_folder> [<case_folder> ...]`
+#
+# The binary file has a header of 160 bytes (the text `EHOWINIT`, the version, the number of variables, the number of cells in x, y and z, and the names of the variables, 16 characters each), followed by one array of doubles per variable, over the whole grid, with the x index running fastest. The variables are those of the ASCII files without the coordinates: u for scalar equations, and u, v, w, rho, p, phi for Euler equations. The files are written in the byte order of the machine and must be read on the same kind of machine.
+#
+# Only the standard library is used, so that it can be run in the compute nodes. `write_initial_bin()` is also used by the case scripts to write the binary files directly (see `write_initial_binary()` in `utils.py`).
+
+import os
+import sys
+import struct
+from array import array
+
+MAGIC = b"EHOWINIT"
+VERSION = 1
+
+
+def write_initial_bin(fname, cells, names, fields):
+    # fields: one flat array per variable over the whole grid, with the x index running fastest
+    # (e.g. numpy.ravel(u, order="F") for the arrays of initialize_variables())
+    with open(fname, "wb") as f:
+        f.write(struct.pack("=8s6i", MAGIC, VERSION, len(names), cells[0], cells[1], cells[2], 0))
+        for i in range(8):
+            f.write(struct.pack("16s", names[i].encode()[:15] if i < len(names) else b""))
+        for field in fields:
+            if not hasattr(field, "tofile"):
+                field = array("d", field)
+            field.tofile(f)
+
+
+def read_ascii(fname):
+    # ASCII input file: two header lines (variables and cells) and one line per cell, with the z index
+    # running fastest. Returns the cells, the names of the variables (without the coordinates) and their
+    # values, reordered with the x index running fastest
+    with open(fname, "r") as f:
+        names = [s.strip() for s in f.readline().split("=")[1].split(",")][3:]
+        cells = [int(s) for s in f.readline().split("=")[1].split(",") if s.strip()]
+        xcells, ycells, zcells = cells
+        fields = [array("d", bytes(8*xcells*ycells*zcells)) for name in names]
+        nlines = 0
+        for line in f:
+            values = line.split()
+            if not values:
+                continue
+            if nlines == xcells*ycells*zcells or len(values) < len(names)+3:
+                raise ValueError(f"{fname}: unexpected line {nlines+3}")
+            l, m, n = nlines//(ycells*zcells), (nlines//zcells) % ycells, nlines % zcells
+            k = l + m*xcells + n*xcells*ycells
+            for i in range(len(names)):
+                fields[i][k] = float(values[3+i])
+            nlines += 1
+    if nlines != xcells*ycells*zcells:
+        raise ValueError(f"{fname} has {nlines} cells, but {xcells}x{ycells}x{zcells} are expected")
+    return cells, names, fields
+
+
+def convert_case(folder_case):
+    converted = 0
+    for name in ("initial", "equilibrium"):
+        fname = os.path.join(folder_case, name+".out")
+        if os.path.exists(fname):
+            cells, names, fields = read_ascii(fname)
+            write_initial_bin(os.path.join(folder_case, name+".bin"), cells, names, fields)
+            print(f"{fname} -> {name}.bin ({len(names)} variables, {cells[0]} x {cells[1]} x {cells[2]} cells)")
+            converted += 1
+    if converted == 0:
+        print(f"No initial.out or equilibrium.out found in {folder_case}")
+    return converted
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Usage: python3 initial2bin.py <case_folder> [<case_folder> ...]")
+        sys.exit(1)
+    for folder in sys.argv[1:]:
+        convert_case(folder)
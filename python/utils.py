@@ -10,6 +10,7 @@ from scipy.special import erf
 import matplotlib.pyplot as plt 
 from scipy.interpolate import interp1d
 from glob import glob
+from initial2bin import write_initial_bin
 
 def modify_header_file(file_path, macro_name, new_value):
     """
@@ -156,13 +157,16 @@ def compile_program_jupyter(make_command='make', makefile_directory='../'):
     else:
         print("Compilation successful")        
 
-def run_program(executable_path):
+def run_program(executable_path, nthreads=None):
     """
     Runs the compiled program and captures the output to display on the screen.
     
     Args:
-        executable_path (str): Full path to the program's executable.
+        executable_path (str): Full path to the program's executable, followed by the case folder.
+        nthreads (int): Number of threads, passed with -t. By default, NTHREADS of definitions.h.
     """
+    if nthreads is not None:
+        executable_path = f"{executable_path} -t {nthreads}"
     result = subprocess.run(executable_path, shell=True, capture_output=True, text=True)
     
     # Print the captured output and error (if any)
@@ -202,7 +206,9 @@ def initialize_variables(xcells, ycells, zcells, SizeX, SizeY, SizeZ):
     return xc, yc, zc, u, v, w, rho, p, phi, ue, ve, we, rhoe, pe
 
 
-def write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z):
+def write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z, **options):
+    # options: optional parameters of configure.input (e.g. TimeScheme=4, EquationSystem=2, Solver=0),
+    # which override the defaults of definitions.h without recompiling
     with open(folder_case + fname_config, "w") as f:
         f.write("/////SIMULATION_SETUP////// \n")
         f.write(f"FinalTime    {FinalTime}\n")
@@ -230,6 +236,12 @@ def write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xce
         f.write(f"u_x    {u_x}\n")
         f.write(f"u_y    {u_y}\n")
         f.write(f"u_z    {u_z}\n")
+        options = {key: value for key, value in options.items() if value is not None}
+        if options:
+            f.write(" \n")
+            f.write("///////OPTIONAL///////\n")
+            for key, value in options.items():
+                f.write(f"{key}    {value}\n")
 
 
 def write_equilibrium(folder_case, fname_eq, xcells, ycells, zcells, xc, yc, zc, ue, ve, we, rhoe, pe):
@@ -261,6 +273,18 @@ def write_initial_scalar(folder_case, fname_ini, xcells, ycells, zcells, xc, yc,
                     f.write(f"{xc[l,m,n]} {yc[l,m,n]} {zc[l,m,n]} {u[l,m,n]} \n")
 
 
+def write_initial_binary(folder_case, fname_ini, u, v, w, rho, p, phi):
+    # Binary version of write_initial() (and of write_equilibrium(), with phi=0), read much faster by the
+    # solver. fname_ini must be initial.bin or equilibrium.bin
+    fields = [np.ravel(np.asarray(f, dtype=np.float64), order="F") for f in (u, v, w, rho, p, phi)]
+    write_initial_bin(folder_case + fname_ini, np.shape(u), ["u", "v", "w", "rho", "p", "phi"], fields)
+
+
+def write_initial_scalar_binary(folder_case, fname_ini, u):
+    # Binary version of write_initial_scalar(). fname_ini must be initial.bin
+    write_initial_bin(folder_case + fname_ini, np.shape(u), ["u"], [np.ravel(np.asarray(u, dtype=np.float64), order="F")])
+
+
 def read_data_euler(fname, xcells, ycells, zcells, lf, gamma, j):
     """
     Process data from a file and return processed arrays.
@@ -324,7 +348,9 @@ def read_data_scalar(u,fname, xcells, ycells, zcells, lf, j):
     return u
     
     
-def singleRP(case,ord):
+def singleRP(case, ord, nthreads=None, Reconstruction=None, build=True):
+    # The equations, the solver and the reconstruction are written in configure.input, so the
+    # program is only compiled when build is True (a sweep compiles it once, see autotest.py)
     
     script_dir = os.path.dirname(os.path.abspath(__file__))
 
@@ -344,20 +370,10 @@ def singleRP(case,ord):
     folder_exe = os.path.join(script_dir, "../")
 
 
-    #Configure the header file for compilation
-    backup_file(folder_lib+'/definitions.h')
-    modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 2)
-    modify_header_file(folder_lib+'/definitions.h', 'ST', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'SOLVER', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)
-    if case==4: 
-        modify_header_file(folder_lib+'/definitions.h', 'MULTICOMPONENT', 1)
-        modify_header_file(folder_lib+'/definitions.h', 'MULTI_TYPE', 2)
-        
     # COMPILING
 
-    compile_program()
-    restore_file(folder_lib+'/definitions.h')
+    if build:
+        compile_program()
 
     #Simulation setup
     FinalTime = 0.011
@@ -470,7 +486,8 @@ def singleRP(case,ord):
       
     # WRITING CONFIGURATION AND INITIAL DATA
 
-    write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)
+    write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z,
+                 EquationSystem=2, SourceTerm=0, Solver=0, Multicomponent=(1 if case==4 else 0), Reconstruction=Reconstruction)
     #write_equilibrium(folder_case, fname_eq, xcells, ycells, zcells, xc, yc, zc, ue, ve, we, rhoe, pe)       
     write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v, w, rho, p, phi)
 
@@ -479,7 +496,7 @@ def singleRP(case,ord):
     print("Program is running...")
     print(folder_exe+"./caelum ")
     print(folder_case)
-    run_program(folder_exe+"./caelum "+folder_case)
+    run_program(folder_exe+"./caelum "+folder_case, nthreads)
 
     # READING OUTPUT DATA AND PLOTTING
 
@@ -550,7 +567,7 @@ def singleRP(case,ord):
         
         
     # Remove all .out and .vtk files generated by the simulator
-    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk"):
+    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti"):
         os.remove(f)
         
     return vf
@@ -558,7 +575,7 @@ def singleRP(case,ord):
     
     
     
-def caseBubble(ord):
+def caseBubble(ord, nthreads=None, Reconstruction=None, build=True):
     
     script_dir = os.path.dirname(os.path.abspath(__file__))
 
@@ -578,17 +595,10 @@ def caseBubble(ord):
     folder_exe = os.path.join(script_dir, "../")
 
 
-    #Configure the header file for compilation
-    backup_file(folder_lib+'/definitions.h')
-    modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 2)
-    modify_header_file(folder_lib+'/definitions.h', 'ST', 3)
-    modify_header_file(folder_lib+'/definitions.h', 'SOLVER', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)
-
     # COMPILING
 
-    compile_program()
-    restore_file(folder_lib+'/definitions.h')
+    if build:
+        compile_program()
 
     #Simulation setup
     FinalTime = 800.0
@@ -664,14 +674,15 @@ def caseBubble(ord):
       
     # WRITING CONFIGURATION AND INITIAL DATA
 
-    write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)
+    write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z,
+                 EquationSystem=2, SourceTerm=3, Solver=0, Reconstruction=Reconstruction)
     write_equilibrium(folder_case, fname_eq, xcells, ycells, zcells, xc, yc, zc, ue, ve, we, rhoe, pe)       
     write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v, w, rho, p, phi)
 
     # RUNNING
 
     print("Program is running...")
-    run_program(folder_exe+"./caelum "+folder_case)
+    run_program(folder_exe+"./caelum "+folder_case, nthreads)
 
     # READING OUTPUT DATA AND PLOTTING
 
@@ -738,13 +749,13 @@ def caseBubble(ord):
         vf=0
         
     # Remove all .out and .vtk files generated by the simulator
-    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk"):
+    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti"):
         os.remove(f)
         
     return vf
     
     
-def caseLinear(ord):
+def caseLinear(ord, nthreads=None, Reconstruction=None, build=True):
     
     script_dir = os.path.dirname(os.path.abspath(__file__))
 
@@ -764,15 +775,10 @@ def caseLinear(ord):
     folder_exe = os.path.join(script_dir, "../")
 
 
-    #Configure the header file for compilation
-    backup_file(folder_lib+'/definitions.h')
-    modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'ST', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)
-
     # COMPILING
 
-    compile_program()
+    if build:
+        compile_program()
 
     #Simulation setup
     FinalTime = 20.0
@@ -814,13 +820,14 @@ def caseLinear(ord):
       
     # WRITING CONFIGURATION AND INITIAL DATA
 
-    write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)      
+    write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, Order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z,
+                 EquationSystem=0, SourceTerm=0, Reconstruction=Reconstruction)
     write_initial_scalar(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u)
 
     # RUNNING
 
     print("Program is running...")
-    run_program(folder_exe+"./caelum "+folder_case)
+    run_program(folder_exe+"./caelum "+folder_case, nthreads)
 
     # READING OUTPUT DATA AND PLOTTING
 
@@ -851,21 +858,19 @@ def caseLinear(ord):
     
     print(f"L1 Error: {L1_error}")
     
-    restore_file(folder_lib+'/definitions.h')
-    
     if L1_error < 0.1*(8-ord):
         vf=1
     else:
         vf=0
         
     # Remove all .out and .vtk files generated by the simulator
-    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk"):
+    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti"):
         os.remove(f)
         
     return vf
     
     
-def ordersLinear():
+def ordersLinear(nthreads=None, Reconstruction=None, build=True):
     script_dir = os.path.dirname(os.path.abspath(__file__))
     
     folder_case="autotest/caseLinear/"
@@ -882,14 +887,8 @@ def ordersLinear():
     folder_lib = os.path.join(script_dir, "../"+folder_lib)
     folder_exe = os.path.join(script_dir, "../")
     
-    backup_file(folder_lib+'/definitions.h')
-    modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'ST', 0)
-    modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)
-
-    compile_program()
-    
-    restore_file(folder_lib+'/definitions.h')
+    if build:
+        compile_program()
       
     orders = [1, 3, 5, 7]
     grid_sizes = [20, 40, 80, 160, 320]
@@ -930,11 +929,12 @@ def ordersLinear():
                         u[l,m,n] =  1.0 + 0.5*(-np.cos(2.0*math.pi*x1) + np.cos(2.0*math.pi*x2))/(dx*2.0*math.pi)      
                         uex[l,m,n] =  1.0 + 0.5*(-np.cos(2.0*math.pi*(x1-u_x*FinalTime)) + np.cos(2.0*math.pi*(x2-u_x*FinalTime)))/(dx*2.0*math.pi)   
 
-            write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)      
+            write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z,
+                         EquationSystem=0, SourceTerm=0, Reconstruction=Reconstruction)
             write_initial_scalar(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u)
 
             print("Program is running...")
-            run_program(folder_exe + "./caelum " + folder_case)
+            run_program(folder_exe + "./caelum " + folder_case, nthreads)
 
             files = glob(folder_out + "/*.out")
             lf = len(files)
@@ -1017,13 +1017,13 @@ def ordersLinear():
         vf=0
         
     # Remove all .out and .vtk files generated by the simulator
-    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk"):
+    for f in glob(folder_out + "/*.out") + glob(folder_out + "/*.vtk") + glob(folder_out + "/*.vti"):
         os.remove(f)
 
     return vf
     
     
-def ordersEuler():
+def ordersEuler(nthreads=None, Reconstruction=None, build=True):
     script_dir = os.path.dirname(os.path.abspath(__file__))
     
     folder_case="autotest/caseAccuracy/"
@@ -1040,6 +1040,9 @@ def ordersEuler():
     folder_lib = os.path.join(script_dir, "../"+folder_lib)
     folder_exe = os.path.join(script_dir, "../")
 
+    if build:
+        compile_program()
+
     orders = [1, 3, 5, 7]
     grid_sizes = [20, 40, 80, 160, 320]
     results = []
@@ -1068,13 +1071,6 @@ def ordersEuler():
             u_y = 1.0
             u_z = 1.0
 
-            backup_file(folder_lib+'/definitions.h')
-            modify_header_file(folder_lib+'/definitions.h', 'EQUATION_SYSTEM', 2)
-            modify_header_file(folder_lib+'/definitions.h', 'ST', 0)
-            modify_header_file(folder_lib+'/definitions.h', 'READ_INITIAL', 1)
-
-            compile_program()
-            
             uex = np.zeros((xcells, ycells, zcells))
             xc, yc, zc, u, v, w, rho, p, phi, ue, ve, we, rhoe, pe = initialize_variables(xcells, ycells, zcells, SizeX, SizeY, SizeZ)
             dx=SizeX/xcells
@@ -1091,11 +1087,12 @@ def ordersEuler():
                         phi[l,m,n]=1.0                        
                         uex[l,m,n] =  1.0 + 0.5*(-np.cos(2.0*math.pi*(x1-u_x*FinalTime)) + np.cos(2.0*math.pi*(x2-u_x*FinalTime)))/(dx*2.0*math.pi)   
 
-            write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z)      
+            write_config(folder_case, fname_config, FinalTime, DumpTime, CFL, order, xcells, ycells, zcells, SizeX, SizeY, SizeZ, Face_1, Face_2, Face_3, Face_4, Face_5, Face_6, u_x, u_y, u_z,
+                         EquationSystem=2, SourceTerm=0, Reconstruction=Reconstruction)
             write_initial(folder_case, fname_ini, xcells, ycells, zcells, xc, yc, zc, u, v, w, rho, p, phi)
 
             print("Program is running...")
-            run_program(folder_exe + "./caelum " + folder_case)
+            run_program(folder_exe + "./caelum " + folder_case, nthreads)
 
             files = glob(folder_out + "/*.out")
             lf = len(files)
@@ -1115,8 +1112,6 @@ def ordersEuler():
             L1_error = np.sum(error)*dx
             print(f"Order {order}, Grid {xcells}: L1 Error = {L1_error}")
             results.append((order, xcells, L1_error))
-
-            restore_file(folder_lib+'/definitions.h')
     
     # Compute the orders of accuracy
     orders_accuracy = {}